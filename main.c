@@ -11,39 +11,36 @@
 #include <stdio.h>
 #include <time.h>
 #include <string.h>
+#include <limits.h>
 #include "splpv1.h"
+#include "splptest.h"
+#include "splplog.h"
+#include "splpcap.h"
+#include "splpwatch.h"
+#include "splpadmit.h"
+#include "splpbench.h"
+#include "splpgate.h"
+#include "splpopen.h"
+#include "splpscale.h"
+#include "splpmix.h"
+#include "splpadv.h"
+#include "splpconc.h"
+#include "splpproc.h"
+#include "splpsched.h"
+#include "splpprio.h"
+#include "splpmigrate.h"
+#include "splpembed.h"
+#include "splpbatch.h"
+#include "splpcorpus.h"
+#include "splpdict.h"
+#include "splpperf.h"
+#include "splpalloc.h"
 
 
 
-#define SPLP_INVALID_MSG_INDEX    0xffffffff
 #define DEFAULT_CYCLE_COUNT       100
 #define DEFAULT_TEST_FILENAME     "test.txt"
-
-
-
-
-typedef enum _SPLP_STATUS
-{
-    SPLP_STATUS_OK,
-    SPLP_STATUS_ERROR
-} SPLP_STATUS;
-
-
-
-
-/* SPLP_TEST_MESSAGE
-* This is a utility data structure which holds a message to evaluate
-* by validate_message() and the answer which is expected to be.
-* if the result returned by validate_message() for msg member is NOT
-* the same as  expectedTestStatus,  the function is implemented with
-* mistakes.
-*/
-typedef struct _SPLP_TEST_MESSAGE
-{
-    enum test_status  expectedTestStatus;  /* Correct answer */
-    struct Message    msg;                 /* Message */
-
-}SPLP_TEST_MESSAGE, *PSPLP_TEST_MESSAGE;
+#define LOG_TIMING_STRIDE         64      /* one in so many log appends is timed */
 
 
 
@@ -67,34 +64,15 @@ typedef struct _SPLP_TEST_STATISTICS
 
     unsigned int firstWrongMsg;
 
-}SPLP_TEST_STATISTICS, *PSPLP_TEST_STATISTICS;
-
-
+    SPLP_WATCHDOG watchdog;     /* slowest messages, if enabled */
+    SPLP_PERF     perf;         /* hardware counters of the timed loop */
+    SPLP_ALLOC_COUNT allocations; /* allocator calls in the timed loop */
 
+    unsigned long long logTicks;  /* TSC spent on the verdict log, estimated */
+    unsigned long long loopTicks; /* TSC of the loop, 0 without a log */
+    SPLP_STATUS   outputStatus; /* log or capture not written completely */
 
-/* SPLP_TEST_OPTIONS
-* This structure contains configuration for a test
-*/
-typedef struct _SPLP_TEST_OPTIONS
-{
-    const char*  testFileName;  /* path to the file with test messages */
-    unsigned int cycleCount;    /* how many times should the file be evaluated */
-
-}SPLP_TEST_OPTIONS, *PSPLP_TEST_OPTIONS;
-
-
-
-
-/* SPLP_TEST_DATA
-* This structure contains data for a test
-*/
-typedef struct _SPLP_TEST_DATA
-{
-    PSPLP_TEST_MESSAGE   MessageArray; /* test messages to evaluate */
-    unsigned int         size;         /* amount of messages in MessageArray */
-    unsigned int         dataSize;     /* total size of test data, in bytes  */
-
-}SPLP_TEST_DATA, *PSPLP_TEST_DATA;
+}SPLP_TEST_STATISTICS, *PSPLP_TEST_STATISTICS;
 
 
 
@@ -141,7 +119,63 @@ void SplpPrintUsage( )
     printf( "usage:\n"
         "\ttest                 - run test program with default values.\n"
         "\ttest filename        - run with filename default cycles.\n"
-        "\ttest filename count  - run filename count>0 iterations.\n" );
+        "\ttest filename count  - run filename count>0 iterations.\n"
+        "options:\n"
+        "\t--log=file           - write verdicts to a columnar log.\n"
+        "\t--log-sample=n       - log every n-th verdict only.\n"
+        "\t--scan-log=file      - print aggregates of a verdict log and exit.\n"
+        "\t--capture=prefix     - capture rejected messages into prefix.N.cap.\n"
+        "\t--capture-files=n    - number of capture ring files.\n"
+        "\t--capture-slots=n    - messages per capture ring file.\n"
+        "\t--capture-sample=n   - capture every n-th rejected message only.\n"
+        "\t--capture-rate=n     - capture at most n messages per second.\n"
+        "\t--capture-export=file - print a ring file as a test file and exit.\n"
+        "\t--watchdog=ticks     - report the slowest messages above ticks TSC.\n"
+        "\t--format=f           - print results as text, json or csv.\n"
+        "\t--no-dedup           - keep every message text in its own heap block\n"
+        "\t                       instead of one dictionary copy, for cold data.\n"
+        "\t--corpus-threads=n   - threads decompressing a zstd test file,\n"
+        "\t                       default one per processor.\n"
+        "\t--alloc-check        - fail if the timed test or open-loop loops\n"
+        "\t                       call malloc, realloc or free; needs a debug\n"
+        "\t                       CRT, or glibc and SPLP_ALLOC_CHECK defined.\n"
+        "\t--overload=policy    - benchmark none|shed|open|closed|all policies\n"
+        "\t                       under overload instead of the test.\n"
+        "\t--overload-load=pct  - offered load in percent of capacity.\n"
+        "\t--overload-high=n    - queue depth entering overload.\n"
+        "\t--overload-low=n     - queue depth leaving overload, below the high one.\n"
+        "\t--bench[=filter]     - run the micro benchmarks and exit.\n"
+        "\t--bench-json=file    - write benchmark results as JSON.\n"
+        "\t--bench-baseline=f,..- compare JSON results of baseline runs with\n"
+        "\t--bench-current=f,.. - the results of current runs, one file per\n"
+        "\t                       process run, at least 8 each, taken in turns;\n"
+        "\t                       exit with 2 on a significant regression.\n"
+        "\t--bench-threshold=n  - percent slowdown tolerated, default 5.\n"
+        "\t--openloop[=loads]   - sweep open-loop load, loads in percent of\n"
+        "\t                       capacity, e.g. 50,90,110, instead of the test.\n"
+        "\t--openloop-arrival=a - poisson or uniform arrivals.\n"
+        "\t--openloop-trace=log - replay the arrival pattern of a verdict log.\n"
+        "\t--openloop-batch[=us] - validate in batches sized adaptively for a\n"
+        "\t                       latency SLO of us microseconds, default 100.\n"
+        "\t--scale[=counts]     - time validation over 1..100M sessions, or the\n"
+        "\t                       given comma separated session counts, and exit.\n"
+        "\t--engines[=shares]   - compare validation engines on traffic with the\n"
+        "\t                       given percent of corrupted messages and exit.\n"
+        "\t--adversarial[=n]    - time adversarial messages and exit, with 2 if\n"
+        "\t                       one costs more than n cycles/byte, default 8.\n"
+        "\t--concurrent[=n]     - compare the sharded and the lock-free session\n"
+        "\t                       table on 1..64, or the given comma separated\n"
+        "\t                       thread counts, and exit.\n"
+        "\t--concurrent-sessions=n - sessions shared by the threads.\n"
+        "\t--processes=n        - split the test cycles over n validator\n"
+        "\t                       processes and sum their statistics.\n"
+        "\t--priority[=n]       - compare FIFO and priority scheduling of control\n"
+        "\t                       messages over bulk payloads scanned in slices\n"
+        "\t                       of n bytes, default 16384, and exit.\n"
+        "\t--migrate[=n]        - time live migration of sessions between n\n"
+        "\t                       worker threads, default 4, and exit.\n"
+        "\t--embed             - time a receive loop over the test messages with\n"
+        "\t                       the library and the inline validator, and exit.\n" );
 }
 
 
@@ -151,28 +185,194 @@ int main( int argc, char* argv[ ] )
 {
     SPLP_TEST_DATA       TestData = { 0 };
     SPLP_TEST_OPTIONS    TestOptions = { 0 };
-    SPLP_TEST_STATISTICS TestStatistics = { 0, 0, 0, 0, 0, SPLP_INVALID_MSG_INDEX };
+    SPLP_TEST_STATISTICS TestStatistics;
+
+
+    memset( &TestStatistics, 0, sizeof( TestStatistics ) );
+    TestStatistics.firstWrongMsg = SPLP_INVALID_MSG_INDEX;
+
+    if ( SPLP_STATUS_OK != SplpTestOptionsInitializeFromCmdLine( &TestOptions, argc, argv ) )
+    {
+        exit( 1 );
+    }
+
+    if ( TestOptions.scanFileName )
+    {
+        return SPLP_STATUS_OK == SplpLogScan( TestOptions.scanFileName ) ? 0 : 1;
+    }
+
+    if ( TestOptions.benchBaselineFileName )
+    {
+        unsigned int regressions;
+        if ( SPLP_STATUS_OK != SplpGateCompare( TestOptions.benchBaselineFileName,
+            TestOptions.benchCurrentFileName, TestOptions.benchThreshold, &regressions ) )
+        {
+            return 1;
+        }
+        return regressions ? 2 : 0;
+    }
+
+    if ( TestOptions.benchmark )
+    {
+        SPLP_BENCH bench;
+        SPLP_STATUS status = SplpBenchInit( &bench );
+
+        if ( SPLP_STATUS_OK == status )
+            status = SplpBenchRun( &bench, TestOptions.benchFilter );
+        if ( SPLP_STATUS_OK == status )
+            SplpBenchPrint( &bench );
+        if ( SPLP_STATUS_OK == status && TestOptions.benchJsonFileName )
+            status = SplpGateWrite( &bench, TestOptions.benchJsonFileName );
+        SplpBenchFree( &bench );
+        return SPLP_STATUS_OK == status ? 0 : 1;
+    }
+
+    if ( TestOptions.adversarial )
+    {
+        unsigned int violations;
+        if ( SPLP_STATUS_OK != SplpAdversarialBenchmark( TestOptions.adversarialBound, &violations ) )
+            return 1;
+        return violations ? 2 : 0;
+    }
+
+    if ( TestOptions.concurrent )
+    {
+        return SPLP_STATUS_OK == SplpConcurrentBenchmark( &TestOptions ) ? 0 : 1;
+    }
+
+    if ( TestOptions.migrateWorkers )
+    {
+        return SPLP_STATUS_OK == SplpMigrationBenchmark( &TestOptions ) ? 0 : 1;
+    }
+
+    if ( TestOptions.priority )
+    {
+        return SPLP_STATUS_OK == SplpPriorityBenchmark( &TestOptions ) ? 0 : 1;
+    }
+
+    if ( TestOptions.engineMix )
+    {
+        return SPLP_STATUS_OK == SplpEngineMixBenchmark( &TestOptions ) ? 0 : 1;
+    }
+
+    if ( TestOptions.scale )
+    {
+        return SPLP_STATUS_OK == SplpScaleBenchmark( &TestOptions ) ? 0 : 1;
+    }
+
+    if ( TestOptions.exportFileName )
+    {
+        return SPLP_STATUS_OK == SplpCaptureExport( TestOptions.exportFileName, stdout ) ? 0 : 1;
+    }
 
+    if ( TestOptions.allocCheck && !SplpAllocSupported( ) )
+    {
+        printf( "***ERROR*** Allocations can't be counted in this build\n" );
+        exit( 1 );
+    }
 
-    if ( SPLP_STATUS_OK != SplpTestOptionsInitializeFromCmdLine( &TestOptions, argc, argv ) ||
-        SPLP_STATUS_OK != SplpTestDataLoadFromFile( TestOptions.testFileName, &TestData ) )
+    SplpCorpusSetThreads( TestOptions.corpusThreads );
+    if ( SPLP_STATUS_OK != SplpTestDataLoadFromFile( TestOptions.testFileName, &TestData ) )
     {
         exit( 1 );
     }
 
+    if ( !TestOptions.noDedup && SPLP_STATUS_OK != SplpTestDataDeduplicate( &TestData ) )
+    {
+        SplpTestDataFree( &TestData );
+        exit( 1 );
+    }
+
+    if ( TestOptions.processWorker )
+    {
+        SPLP_STATUS status = SplpProcessWorker( &TestOptions, &TestData );
+        SplpTestDataFree( &TestData );
+        return SPLP_STATUS_OK == status ? 0 : 1;
+    }
+
+    if ( TestOptions.processes )
+    {
+        static SPLP_PROC_BLOCK blocks[ SPLP_PROC_MAX_PROCESSES ];
+        SPLP_PROC_BLOCK total;
+        SPLP_STATUS status = SplpProcessLaunch( &TestOptions, &TestData, &total, blocks );
+
+        if ( SPLP_STATUS_OK == status )
+        {
+            TestStatistics.truePositive = total.truePositive;
+            TestStatistics.trueNegative = total.trueNegative;
+            TestStatistics.falsePositive = total.falsePositive;
+            TestStatistics.falseNegative = total.falseNegative;
+            TestStatistics.firstWrongMsg = total.firstWrongMsg;
+            TestStatistics.duration = (clock_t) ( ( total.end - total.begin ) * (double) CLOCKS_PER_SEC / SplpTscTicksPerSecond( ) );
+            SplpTestResultPrint( &TestOptions, &TestStatistics, &TestData );
+            if ( TestOptions.outputFormat == SPLP_FORMAT_TEXT )
+                SplpProcessPrint( &TestOptions, &total, blocks );
+        }
+        SplpTestDataFree( &TestData );
+        return SPLP_STATUS_OK == status ? 0 : 1;
+    }
+
+    if ( TestOptions.openLoop )
+    {
+        SPLP_STATUS status = SplpOpenLoopBenchmark( &TestOptions, &TestData );
+        SplpTestDataFree( &TestData );
+        return SPLP_STATUS_OK == status ? 0 : 1;
+    }
+
+    if ( TestOptions.embed )
+    {
+        SPLP_STATUS status = SplpEmbedBenchmark( &TestOptions, &TestData );
+        SplpTestDataFree( &TestData );
+        return SPLP_STATUS_OK == status ? 0 : 1;
+    }
+
+    if ( TestOptions.overloadPolicies )
+    {
+        SPLP_STATUS status = SplpOverloadBenchmark( &TestOptions, &TestData );
+        SplpTestDataFree( &TestData );
+        return SPLP_STATUS_OK == status ? 0 : 1;
+    }
+
     SplpDoTest( &TestOptions, &TestStatistics, &TestData );
 
     SplpTestResultPrint( &TestOptions, &TestStatistics, &TestData );
 
     SplpTestDataFree( &TestData );
 
-    return 0;
+    if ( TestOptions.allocCheck && SplpAllocTotal( &TestStatistics.allocations ) )
+    {
+        printf( "***ERROR*** The timed loop called the allocator %llu times\n",
+            SplpAllocTotal( &TestStatistics.allocations ) );
+        return 1;
+    }
+
+    return SPLP_STATUS_OK == TestStatistics.outputStatus ? 0 : 1;
 }
 
 
 
 
-void SplpTestResultPrint(
+/* SplpLogOverhead
+* Share of the verdict log in the test loop in percent, and its time per
+* validated message in ns.
+*/
+static void SplpLogOverhead(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_STATISTICS pStat,
+    PSPLP_TEST_DATA pData,
+    double* pPercent,
+    double* pNsPerMessage )
+{
+    double messages = (double) pOptions->cycleCount * pData->size;
+
+    *pPercent = pStat->loopTicks ? 100.0 * pStat->logTicks / pStat->loopTicks : 0;
+    *pNsPerMessage = messages ? pStat->logTicks * 1e9 / SplpTscTicksPerSecond( ) / messages : 0;
+}
+
+
+
+
+static void SplpTestResultPrintText(
     PSPLP_TEST_OPTIONS pOptions,
     PSPLP_TEST_STATISTICS pStat,
     PSPLP_TEST_DATA pData )
@@ -184,10 +384,16 @@ void SplpTestResultPrint(
         " Test Info:\n"
         "\tTest file:        \"%s\"\n"
         "\tMessages in file: \t%14u\n"
-        "\tCycles:           \t%14u\n\n",
+        "\tCycles:           \t%14u\n",
         pOptions->testFileName,
         pData->size,
         pOptions->cycleCount );
+    if ( pData->pDictionary )
+    {
+        printf( "\tDistinct texts:   \t%14u (%llu bytes)\n",
+            pData->pDictionary->count, pData->pDictionary->bytes );
+    }
+    printf( "\n" );
 
 
     printf(
@@ -234,46 +440,592 @@ void SplpTestResultPrint(
         ( pStat->duration != 0 ) ?
         (float) pData->dataSize * (float) pOptions->cycleCount * 8.0f / ( (float) ( pStat->duration ) / (float) CLOCKS_PER_SEC ) / 1024.0 / 1024.0 : 0 );
 
+    if ( pStat->perf.available )
+    {
+        unsigned int counter;
+        printf( " Hardware counters (per message):\n" );
+        for ( counter = 0; counter < SPLP_PERF_COUNTER_COUNT; counter++ )
+        {
+            if ( SplpPerfAvailable( &pStat->perf, (SPLP_PERF_COUNTER) counter ) )
+                printf( "\t%-18s\t%14.4f\n", SplpPerfCounterName( (SPLP_PERF_COUNTER) counter ),
+                    (double) pStat->perf.value[ counter ] / ( (double) pOptions->cycleCount * pData->size ) );
+        }
+        printf( "\n" );
+    }
+
+    if ( SplpAllocSupported( ) )
+    {
+        printf(
+            " Allocations in timed loop:\n"
+            "\tmalloc/calloc:    \t%14llu\n"
+            "\trealloc:          \t%14llu\n"
+            "\tfree:             \t%14llu\n\n",
+            pStat->allocations.allocs,
+            pStat->allocations.reallocs,
+            pStat->allocations.frees );
+    }
+
+    if ( pStat->loopTicks )
+    {
+        double percent;
+        double nsPerMessage;
+
+        SplpLogOverhead( pOptions, pStat, pData, &percent, &nsPerMessage );
+        printf(
+            " Verdict log:\n"
+            "\tShare of loop (%%):\t%14.1f\n"
+            "\tPer message (ns): \t%14.1f\n\n",
+            percent,
+            nsPerMessage );
+    }
+
+    if ( pStat->watchdog.threshold )
+    {
+        SplpWatchdogPrint( &pStat->watchdog );
+    }
+
     printf( "======================================================================\n" );
 }
 
 
 
 
-void SplpDoTest(
+/* SplpPrintJsonString
+* Prints text as a quoted JSON string.
+*/
+static void SplpPrintJsonString(
+    const char* text )
+{
+    putchar( '"' );
+    for ( ; *text; text++ )
+    {
+        unsigned char c = (unsigned char) *text;
+        if ( c == '"' || c == '\\' )
+            printf( "\\%c", c );
+        else if ( c < 0x20 )
+            printf( "\\u%04x", c );
+        else
+            putchar( c );
+    }
+    putchar( '"' );
+}
+
+
+
+
+/* SplpPrintCsvString
+* Prints text as a quoted CSV field.
+*/
+static void SplpPrintCsvString(
+    const char* text )
+{
+    putchar( '"' );
+    for ( ; *text; text++ )
+    {
+        if ( *text == '"' )
+            putchar( '"' );
+        putchar( *text );
+    }
+    putchar( '"' );
+}
+
+
+
+
+static void SplpTestResultPrintJson(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_STATISTICS pStat,
+    PSPLP_TEST_DATA pData )
+{
+    double seconds = (double) pStat->duration / CLOCKS_PER_SEC;
+    unsigned int counter;
+    unsigned int i;
+
+    printf( "{\n  \"file\": " );
+    SplpPrintJsonString( pOptions->testFileName );
+    printf( ",\n"
+        "  \"messages_in_file\": %u,\n"
+        "  \"data_bytes\": %u,\n"
+        "  \"cycles\": %u,\n"
+        "  \"total_messages\": %llu,\n"
+        "  \"correct\": %u,\n"
+        "  \"wrong\": %u,\n"
+        "  \"confusion\": {\"true_positive\": %u, \"true_negative\": %u, \"false_positive\": %u, \"false_negative\": %u},\n",
+        pData->size,
+        pData->dataSize,
+        pOptions->cycleCount,
+        (unsigned long long) pOptions->cycleCount * pData->size,
+        pStat->trueNegative + pStat->truePositive,
+        pStat->falseNegative + pStat->falsePositive,
+        pStat->truePositive,
+        pStat->trueNegative,
+        pStat->falsePositive,
+        pStat->falseNegative );
+
+    if ( pStat->falseNegative || pStat->falsePositive )
+    {
+        PSPLP_TEST_MESSAGE pMsg = &pData->MessageArray[ pStat->firstWrongMsg ];
+        printf( "  \"first_wrong\": {\"index\": %u, \"direction\": \"%s\", \"expected\": \"%s\", \"message\": ",
+            pStat->firstWrongMsg,
+            pMsg->msg.direction == A_TO_B ? "A->B" : "B->A",
+            pMsg->expectedTestStatus == MESSAGE_VALID ? "MESSAGE_VALID" : "MESSAGE_INVALID" );
+        SplpPrintJsonString( pMsg->msg.text_message );
+        printf( "},\n" );
+    }
+    else
+    {
+        printf( "  \"first_wrong\": null,\n" );
+    }
+
+    printf(
+        "  \"clocks\": %ld,\n"
+        "  \"seconds\": %.6f,\n"
+        "  \"usec_per_cycle\": %.4f,\n"
+        "  \"throughput_mbps\": %.4f,\n"
+        "  \"counters_per_message\": {",
+        (long) pStat->duration,
+        seconds,
+        pOptions->cycleCount ? seconds * 1000000.0 / pOptions->cycleCount : 0,
+        pStat->duration ? (double) pData->dataSize * pOptions->cycleCount * 8.0 / seconds / 1024.0 / 1024.0 : 0 );
+
+    for ( counter = 0; counter < SPLP_PERF_COUNTER_COUNT; counter++ )
+    {
+        printf( "%s\"%s\": ", counter ? ", " : "", SplpPerfCounterName( (SPLP_PERF_COUNTER) counter ) );
+        if ( SplpPerfAvailable( &pStat->perf, (SPLP_PERF_COUNTER) counter ) )
+            printf( "%.4f", (double) pStat->perf.value[ counter ] / ( (double) pOptions->cycleCount * pData->size ) );
+        else
+            printf( "null" );
+    }
+    printf( "},\n  \"allocations\": " );
+    if ( SplpAllocSupported( ) )
+    {
+        printf( "{\"malloc\": %llu, \"realloc\": %llu, \"free\": %llu}",
+            pStat->allocations.allocs,
+            pStat->allocations.reallocs,
+            pStat->allocations.frees );
+    }
+    else
+    {
+        printf( "null" );
+    }
+
+    printf( ",\n  \"verdict_log\": " );
+    if ( pStat->loopTicks )
+    {
+        double percent;
+        double nsPerMessage;
+
+        SplpLogOverhead( pOptions, pStat, pData, &percent, &nsPerMessage );
+        printf( "{\"loop_percent\": %.2f, \"ns_per_message\": %.2f}", percent, nsPerMessage );
+    }
+    else
+    {
+        printf( "null" );
+    }
+
+    if ( pStat->watchdog.threshold )
+    {
+        SplpWatchdogSort( &pStat->watchdog );
+        printf( ",\n  \"slow_messages\": {\"threshold_ticks\": %llu, \"over_threshold\": %llu, \"slowest\": [",
+            pStat->watchdog.threshold,
+            pStat->watchdog.overThreshold );
+        for ( i = 0; i < pStat->watchdog.count; i++ )
+        {
+            PSPLP_SLOW_MESSAGE pSlot = &pStat->watchdog.slowest[ i ];
+            printf( "%s\n    {\"ticks\": %llu, \"index\": %u, \"length\": %u, \"state\": \"%s\", "
+                "\"command\": \"%s\", \"hash\": \"%08x\", \"valid\": %s}",
+                i ? "," : "",
+                pSlot->elapsed,
+                pSlot->msgIdx,
+                pSlot->length,
+                SplpLogStateName( pSlot->state ),
+                SplpLogCommandName( pSlot->command ),
+                pSlot->hash,
+                pSlot->valid ? "true" : "false" );
+        }
+        printf( "]}" );
+    }
+
+    printf( "\n}\n" );
+}
+
+
+
+
+/* SplpTestResultPrintCsv
+* Prints a header and a single row, so rows of many runs can be
+* concatenated. The slowest message stands in for the watchdog table.
+*/
+static void SplpTestResultPrintCsv(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_STATISTICS pStat,
+    PSPLP_TEST_DATA pData )
+{
+    double seconds = (double) pStat->duration / CLOCKS_PER_SEC;
+    unsigned int counter;
+
+    printf( "file,messages_in_file,data_bytes,cycles,total_messages,correct,wrong,"
+        "true_positive,true_negative,false_positive,false_negative,"
+        "first_wrong_index,first_wrong_direction,first_wrong_expected,first_wrong_message,"
+        "clocks,seconds,usec_per_cycle,throughput_mbps" );
+    for ( counter = 0; counter < SPLP_PERF_COUNTER_COUNT; counter++ )
+        printf( ",%s_per_message", SplpPerfCounterName( (SPLP_PERF_COUNTER) counter ) );
+    printf( ",mallocs,reallocs,frees,watchdog_threshold_ticks,watchdog_over_threshold,slowest_ticks,slowest_index,"
+        "log_loop_percent,log_ns_per_message\n" );
+
+    SplpPrintCsvString( pOptions->testFileName );
+    printf( ",%u,%u,%u,%llu,%u,%u,%u,%u,%u,%u,",
+        pData->size,
+        pData->dataSize,
+        pOptions->cycleCount,
+        (unsigned long long) pOptions->cycleCount * pData->size,
+        pStat->trueNegative + pStat->truePositive,
+        pStat->falseNegative + pStat->falsePositive,
+        pStat->truePositive,
+        pStat->trueNegative,
+        pStat->falsePositive,
+        pStat->falseNegative );
+
+    if ( pStat->falseNegative || pStat->falsePositive )
+    {
+        PSPLP_TEST_MESSAGE pMsg = &pData->MessageArray[ pStat->firstWrongMsg ];
+        printf( "%u,%s,%s,",
+            pStat->firstWrongMsg,
+            pMsg->msg.direction == A_TO_B ? "A->B" : "B->A",
+            pMsg->expectedTestStatus == MESSAGE_VALID ? "MESSAGE_VALID" : "MESSAGE_INVALID" );
+        SplpPrintCsvString( pMsg->msg.text_message );
+    }
+    else
+    {
+        printf( ",,," );
+    }
+
+    printf( ",%ld,%.6f,%.4f,%.4f",
+        (long) pStat->duration,
+        seconds,
+        pOptions->cycleCount ? seconds * 1000000.0 / pOptions->cycleCount : 0,
+        pStat->duration ? (double) pData->dataSize * pOptions->cycleCount * 8.0 / seconds / 1024.0 / 1024.0 : 0 );
+
+    for ( counter = 0; counter < SPLP_PERF_COUNTER_COUNT; counter++ )
+    {
+        if ( SplpPerfAvailable( &pStat->perf, (SPLP_PERF_COUNTER) counter ) )
+            printf( ",%.4f", (double) pStat->perf.value[ counter ] / ( (double) pOptions->cycleCount * pData->size ) );
+        else
+            printf( "," );
+    }
+
+    if ( SplpAllocSupported( ) )
+    {
+        printf( ",%llu,%llu,%llu",
+            pStat->allocations.allocs,
+            pStat->allocations.reallocs,
+            pStat->allocations.frees );
+    }
+    else
+    {
+        printf( ",,," );
+    }
+
+    if ( pStat->watchdog.threshold )
+    {
+        SplpWatchdogSort( &pStat->watchdog );
+        printf( ",%llu,%llu", pStat->watchdog.threshold, pStat->watchdog.overThreshold );
+        if ( pStat->watchdog.count )
+            printf( ",%llu,%u", pStat->watchdog.slowest[ 0 ].elapsed, pStat->watchdog.slowest[ 0 ].msgIdx );
+        else
+            printf( ",," );
+    }
+    else
+    {
+        printf( ",,,," );
+    }
+
+    if ( pStat->loopTicks )
+    {
+        double percent;
+        double nsPerMessage;
+
+        SplpLogOverhead( pOptions, pStat, pData, &percent, &nsPerMessage );
+        printf( ",%.2f,%.2f\n", percent, nsPerMessage );
+    }
+    else
+    {
+        printf( ",,\n" );
+    }
+}
+
+
+
+
+void SplpTestResultPrint(
     PSPLP_TEST_OPTIONS pOptions,
     PSPLP_TEST_STATISTICS pStat,
     PSPLP_TEST_DATA pData )
 {
-    clock_t start = clock( );
+    switch ( pOptions->outputFormat )
+    {
+    case SPLP_FORMAT_JSON:
+        SplpTestResultPrintJson( pOptions, pStat, pData );
+        break;
+    case SPLP_FORMAT_CSV:
+        SplpTestResultPrintCsv( pOptions, pStat, pData );
+        break;
+    default:
+        SplpTestResultPrintText( pOptions, pStat, pData );
+        break;
+    }
+}
+
+
+
+
+static void SplpCountResult(
+    PSPLP_TEST_STATISTICS pStat,
+    enum test_status expected,
+    unsigned int msgIdx,
+    enum test_status result )
+{
+    if ( result != expected )
+    {
+        // WRONG answer
+        if ( pStat->firstWrongMsg == SPLP_INVALID_MSG_INDEX )
+            pStat->firstWrongMsg = msgIdx;
+
+        expected == MESSAGE_VALID ?
+            pStat->falseNegative++ :
+            pStat->falsePositive++;
+    }
+    else
+    {
+        // CORRECT answer
+        expected == MESSAGE_VALID ?
+            pStat->truePositive++ :
+            pStat->trueNegative++;
+    }
+}
+
+
+
+
+/* SplpTscTimingCost
+* TSC ticks between two back to back SplpReadTsc( ), the least of a few
+* tries; timed regions are corrected by it.
+*/
+static unsigned long long SplpTscTimingCost( void )
+{
+    unsigned long long least = ~0ull;
+    unsigned int i;
+
+    for ( i = 0; i < 64; i++ )
+    {
+        unsigned long long begin = SplpReadTsc( );
+        unsigned long long elapsed = SplpReadTsc( ) - begin;
+        if ( elapsed < least )
+            least = elapsed;
+    }
+    return least;
+}
+
+
+
+
+/* SplpDoTestInstrumented
+* Same as SplpDoTest( ) but every verdict is also passed to the
+* verdict log, rejects to the capture and validation time to the
+* watchdog. Kept separate so the plain loop stays untouched.
+*/
+static void SplpDoTestInstrumented(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_STATISTICS pStat,
+    PSPLP_TEST_DATA pData )
+{
+    SPLP_LOG log = { 0 };
+    SPLP_CAPTURE capture = { 0 };
+    clock_t start;
+    unsigned long long loopBegin;
+    unsigned long long loopTicks;
+    unsigned long long logEvents = 0;
+    unsigned long long logTimed = 0;
+    unsigned long long flushCount = 0;
+    unsigned long long logTicks = 0;
+    unsigned long long flushTicks = 0;
+    unsigned long long timingCost = SplpTscTimingCost( );
     unsigned int cycleIdx = 0;
     unsigned int msgIdx = 0;
 
+    if ( pOptions->logFileName &&
+        SPLP_STATUS_OK != SplpLogOpen( &log, pOptions->logFileName, pOptions->logSampleRate ) )
+    {
+        pStat->outputStatus = SPLP_STATUS_ERROR;
+        return;
+    }
+
+    if ( pOptions->capturePrefix &&
+        SPLP_STATUS_OK != SplpCaptureOpen( &capture, pOptions->capturePrefix, pOptions->captureFiles,
+            pOptions->captureSlots, pOptions->captureSampleRate, pOptions->captureRate ) )
+    {
+        SplpLogClose( &log );
+        pStat->outputStatus = SPLP_STATUS_ERROR;
+        return;
+    }
+
+    SplpPerfStart( &pStat->perf );
+    SplpAllocWatchStart( );
+    start = clock( );
+    loopBegin = SplpReadTsc( );
+
     for ( cycleIdx = 0; cycleIdx < pOptions->cycleCount; cycleIdx++ )
     {
         for ( msgIdx = 0; msgIdx < pData->size; msgIdx++ )
         {
-            if ( validate_message( &pData->MessageArray[ msgIdx ].msg ) != pData->MessageArray[ msgIdx ].expectedTestStatus )
+            PSPLP_TEST_MESSAGE pMsg = &pData->MessageArray[ msgIdx ];
+            enum State state = get_state( );
+            unsigned long long begin = pStat->watchdog.threshold ? SplpReadTsc( ) : 0;
+            enum test_status result = validate_message( &pMsg->msg );
+
+            if ( pStat->watchdog.threshold )
             {
-                // WRONG answer
-                if ( pStat->firstWrongMsg == SPLP_INVALID_MSG_INDEX )
-                    pStat->firstWrongMsg = msgIdx;
+                SplpWatchdogCheck( &pStat->watchdog, SplpReadTsc( ) - begin, msgIdx,
+                    &pMsg->msg, pMsg->length, state, result );
+            }
 
-                pData->MessageArray[ msgIdx ].expectedTestStatus == MESSAGE_VALID ?
-                    pStat->falseNegative++ :
-                    pStat->falsePositive++;
+            if ( log.fOutput && SplpLogSample( &log ) )
+            {
+                /* timing every append would cost as much as the log; the
+                 * appends which write a block are all timed, they are few
+                 * and much slower than the rest */
+                int flush = log.eventCount == SPLP_LOG_BLOCK_EVENTS - 1;
+                int timed = flush || ++logEvents % LOG_TIMING_STRIDE == 0;
+                unsigned long long logBegin = timed ? SplpReadTsc( ) : 0;
+                SPLP_LOG_EVENT event;
+
+                event.timestamp = SplpReadTsc( );
+                event.sessionId = 0;    /* validate_message( ) tracks a single session */
+                event.length = pMsg->length;
+                event.state = (unsigned char) state;
+                event.command = (unsigned char) SplpLogClassify( pMsg->msg.text_message, pMsg->length );
+                event.reason = (unsigned char) ( result == MESSAGE_VALID ? REASON_NONE : get_reason( ) );
+                event.valid = result == MESSAGE_VALID;
+                event.direction = pMsg->msg.direction == B_TO_A;
+                SplpLogAppend( &log, &event );
+                if ( flush )
+                {
+                    flushTicks += SplpReadTsc( ) - logBegin;
+                    flushCount++;
+                }
+                else if ( timed )
+                {
+                    logTicks += SplpReadTsc( ) - logBegin;
+                    logTimed++;
+                }
             }
-            else
+
+            if ( result == MESSAGE_INVALID )
             {
-                // CORRECT answer
-                pData->MessageArray[ msgIdx ].expectedTestStatus == MESSAGE_VALID ?
-                    pStat->truePositive++ :
-                    pStat->trueNegative++;
+                SplpCaptureReject( &capture, &pMsg->msg, pMsg->length, state );
             }
+
+            SplpCountResult( pStat, pMsg->expectedTestStatus, msgIdx, result );
+        }
+    }
+
+    loopTicks = SplpReadTsc( ) - loopBegin;
+    pStat->duration = clock( ) - start;
+    SplpAllocWatchStop( &pStat->allocations );
+    SplpPerfStop( &pStat->perf );
+
+    /* the log is encoded inline, so its cost is part of the throughput */
+    if ( log.fOutput )
+    {
+        /* the timing itself isn't part of the log */
+        flushTicks -= flushTicks > timingCost * flushCount ? timingCost * flushCount : flushTicks;
+        logTicks -= logTicks > timingCost * logTimed ? timingCost * logTimed : logTicks;
+
+        pStat->loopTicks = loopTicks;
+        pStat->logTicks = flushTicks;
+        if ( logTimed )
+            pStat->logTicks += (unsigned long long) ( (double) logTicks * logEvents / logTimed );
+    }
+
+    if ( SPLP_STATUS_OK != SplpLogClose( &log ) )
+    {
+        printf( "***ERROR*** Log file \"%s\" wasn't written completely\n", pOptions->logFileName );
+        pStat->outputStatus = SPLP_STATUS_ERROR;
+    }
+
+    if ( capture.dropped )
+    {
+        printf( "***WARNING*** %llu rejected messages weren't captured due to the rate limit\n",
+            capture.dropped );
+    }
+
+    if ( capture.oversized )
+    {
+        printf( "***WARNING*** %llu rejected messages weren't captured, they don't fit a capture slot\n",
+            capture.oversized );
+    }
+
+    if ( SPLP_STATUS_OK != SplpCaptureClose( &capture ) )
+    {
+        printf( "***ERROR*** Capture \"%s\" wasn't written completely\n", pOptions->capturePrefix );
+        pStat->outputStatus = SPLP_STATUS_ERROR;
+    }
+}
+
+
+
+
+void SplpDoTest(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_STATISTICS pStat,
+    PSPLP_TEST_DATA pData )
+{
+    clock_t start;
+    unsigned int cycleIdx = 0;
+    unsigned int msgIdx = 0;
+
+    pStat->watchdog.threshold = pOptions->watchdogThreshold;
+    SplpPerfOpen( &pStat->perf );
+
+    if ( pOptions->logFileName || pOptions->capturePrefix || pOptions->watchdogThreshold )
+    {
+        SplpDoTestInstrumented( pOptions, pStat, pData );
+        SplpPerfClose( &pStat->perf );
+        return;
+    }
+
+    SplpPerfStart( &pStat->perf );
+    SplpAllocWatchStart( );
+    start = clock( );
+
+    for ( cycleIdx = 0; cycleIdx < pOptions->cycleCount && !pData->pEntries; cycleIdx++ )
+    {
+        for ( msgIdx = 0; msgIdx < pData->size; msgIdx++ )
+        {
+            SplpCountResult( pStat, pData->MessageArray[ msgIdx ].expectedTestStatus, msgIdx,
+                validate_message( &pData->MessageArray[ msgIdx ].msg ) );
+        }
+    }
+
+    /* the same sequence from the dictionary, see splpdict.c */
+    for ( cycleIdx = 0; cycleIdx < pOptions->cycleCount && pData->pEntries; cycleIdx++ )
+    {
+        for ( msgIdx = 0; msgIdx < pData->size; msgIdx++ )
+        {
+            SPLP_TEST_ENTRY entry = pData->pEntries[ msgIdx ];
+            struct Message msg;
+
+            msg.direction = entry.direction ? B_TO_A : A_TO_B;
+            msg.text_message = pData->pDictionary->ppTexts[ entry.index ];
+            SplpCountResult( pStat, entry.valid ? MESSAGE_VALID : MESSAGE_INVALID, msgIdx,
+                validate_message( &msg ) );
         }
     }
 
     pStat->duration = clock( ) - start;
+    SplpAllocWatchStop( &pStat->allocations );
+    SplpPerfStop( &pStat->perf );
+    SplpPerfClose( &pStat->perf );
 }
 
 
@@ -284,25 +1036,30 @@ void SplpTestDataFree(
 {
     unsigned int i = 0;
 
-    if ( testData->MessageArray )
+    if ( testData->pDictionary )
+    {
+        SplpDictionaryFree( testData->pDictionary );
+        free( testData->pDictionary );
+        free( testData->pEntries );
+    }
+    else if ( testData->MessageArray )
     {
         for ( i = 0; i<testData->size; i++ )
         {
             free( testData->MessageArray[ i ].msg.text_message );
         }
-        free( testData->MessageArray );
     }
+    free( testData->MessageArray );
 }
 
 
 
 
-unsigned int SplpGetMessageCount( FILE* fInput )
+unsigned int SplpGetMessageCount( PSPLP_CORPUS pCorpus )
 {
-    unsigned int result = 0;
-    fseek( fInput, 0, SEEK_SET );
-    if ( 1 == fscanf_s( fInput, "%u", &result ) )
-        return result;
+    int result = 0;
+    if ( SplpCorpusScanInt( pCorpus, &result ) )
+        return (unsigned int) result;
     return 0;
 }
 
@@ -310,17 +1067,18 @@ unsigned int SplpGetMessageCount( FILE* fInput )
 
 
 SPLP_STATUS SplpReadMessage(
-    FILE* fInput,
+    PSPLP_CORPUS pCorpus,
     PSPLP_TEST_MESSAGE pMsg )
 {
     int direction = 0, correct = 0;
 
-    if ( 2 == fscanf_s( fInput, "%d\t%d\t", &correct, &direction ) )
+    if ( SplpCorpusScanInt( pCorpus, &correct ) && SplpCorpusScanInt( pCorpus, &direction ) )
     {
         char buffer[ 8192 ];
+        SplpCorpusSkipSpace( pCorpus );
         pMsg->expectedTestStatus = ( correct == 1 ) ? MESSAGE_VALID : MESSAGE_INVALID;
         pMsg->msg.direction = ( direction == 1 ) ? B_TO_A : A_TO_B;
-        if ( fgets( buffer, sizeof( buffer ), fInput ) )
+        if ( SplpCorpusGets( pCorpus, buffer, sizeof( buffer ) ) )
         {
             unsigned int size = strlen( buffer );
 
@@ -334,6 +1092,7 @@ SPLP_STATUS SplpReadMessage(
                 }
             }
 
+            pMsg->length = size;
             pMsg->msg.text_message = (char *) malloc( size + 1 );
             if ( pMsg->msg.text_message )
             {
@@ -367,14 +1126,13 @@ SPLP_STATUS  SplpTestDataLoadFromFile(
     const char* fileName,
     PSPLP_TEST_DATA testData )
 {
-    FILE*  fInput = 0;
-    unsigned int fileSize = 0;
+    SPLP_CORPUS corpus;
     SPLP_STATUS status = SPLP_STATUS_ERROR;
 
 
-    if ( 0 == fopen_s( &fInput, fileName, "r" ) )
+    if ( SPLP_STATUS_OK == SplpCorpusOpen( &corpus, fileName ) )
     {
-        unsigned int msgCount = SplpGetMessageCount( fInput );
+        unsigned int msgCount = SplpGetMessageCount( &corpus );
         PSPLP_TEST_MESSAGE testMessages;
 
         if ( msgCount &&
@@ -384,32 +1142,49 @@ SPLP_STATUS  SplpTestDataLoadFromFile(
 
             for ( messagesRead = 0; messagesRead < msgCount; messagesRead++ )
             {
-                if ( SPLP_STATUS_OK != SplpReadMessage( fInput, &testMessages[ messagesRead ] ) )
+                if ( SPLP_STATUS_OK != SplpReadMessage( &corpus, &testMessages[ messagesRead ] ) )
                     break;
             }
 
+            /* the end of a compressed file is checked even if all messages
+             * were read before it */
+            while ( corpus.format != SPLP_CORPUS_TEXT && SplpCorpusFill( &corpus ) )
+                ;
+
             if ( messagesRead )
             {
                 testData->size = messagesRead;
                 testData->MessageArray = testMessages;
                 testData->dataSize = SplpGetTotalDataSize( testMessages, messagesRead );
             }
+            else
+            {
+                free( testMessages );
+            }
 
-            if ( messagesRead != msgCount )
+            if ( corpus.error )
             {
-                printf( "***WARNING*** File \"%s\" wasn't loaded completely. Loaded %u out of %u\n",
+                /* a damaged or truncated compressed file */
+                printf( "***ERROR*** File \"%s\" wasn't loaded. Read %u out of %u messages\n",
                     fileName, messagesRead, msgCount );
+                if ( messagesRead )
+                    SplpTestDataFree( testData );
+                memset( testData, 0, sizeof( *testData ) );
             }
+            else
+            {
+                if ( messagesRead != msgCount )
+                {
+                    printf( "***WARNING*** File \"%s\" wasn't loaded completely. Loaded %u out of %u\n",
+                        fileName, messagesRead, msgCount );
+                }
 
-            if ( messagesRead != 0 )
-                status = SPLP_STATUS_OK;
+                if ( messagesRead != 0 )
+                    status = SPLP_STATUS_OK;
+            }
         }
 
-        fclose( fInput );
-    }
-    else
-    {
-        printf( "***ERROR*** File \"%s\" can't be opened\n", fileName );
+        SplpCorpusClose( &corpus );
     }
 
     return status;
@@ -418,34 +1193,329 @@ SPLP_STATUS  SplpTestDataLoadFromFile(
 
 
 
+/* SplpParseCount
+* Parses a positive count given in a "--name=count" option.
+*/
+static SPLP_STATUS SplpParseCount(
+    const char* text,
+    unsigned int* pValue )
+{
+    unsigned long value = strtoul( text, NULL, 0 );
+    if ( value > 0 && value < UINT_MAX )
+    {
+        *pValue = value;
+        return SPLP_STATUS_OK;
+    }
+    return SPLP_STATUS_ERROR;
+}
+
+
+
+
 SPLP_STATUS  SplpTestOptionsInitializeFromCmdLine(
     PSPLP_TEST_OPTIONS pTestOptions,
     int argc,
     char* argv[ ] )
 {
     SPLP_STATUS Status = SPLP_STATUS_OK;
+    unsigned int positional = 0;
+    int argIdx;
 
     pTestOptions->cycleCount = DEFAULT_CYCLE_COUNT;
     pTestOptions->testFileName = DEFAULT_TEST_FILENAME;
-
-    if ( argc > 1 )
+    pTestOptions->logSampleRate = 1;
+    pTestOptions->overloadLoad = DEFAULT_OVERLOAD_LOAD;
+    pTestOptions->overloadHigh = DEFAULT_OVERLOAD_HIGH;
+    pTestOptions->overloadLow = DEFAULT_OVERLOAD_LOW;
+    pTestOptions->benchThreshold = DEFAULT_GATE_THRESHOLD;
+    pTestOptions->adversarialBound = DEFAULT_ADV_BOUND;
+    pTestOptions->concurrentSessions = DEFAULT_CONC_SESSIONS;
+    pTestOptions->prioritySlice = DEFAULT_SCHED_SLICE_BYTES;
+
+    for ( argIdx = 1; argIdx < argc && Status == SPLP_STATUS_OK; argIdx++ )
     {
-        pTestOptions->testFileName = argv[ 1 ];
-    }
+        const char* arg = argv[ argIdx ];
 
-    if ( argc == 3 )
-    {
-        unsigned long cycleCount = strtoul( argv[ 2 ], NULL, 0 );
-        if ( cycleCount > 0 && cycleCount < ULONG_MAX )
+        if ( 0 == strncmp( arg, "--log=", 6 ) )
+        {
+            pTestOptions->logFileName = arg + 6;
+        }
+        else if ( 0 == strncmp( arg, "--log-sample=", 13 ) )
+        {
+            Status = SplpParseCount( arg + 13, &pTestOptions->logSampleRate );
+        }
+        else if ( 0 == strncmp( arg, "--scan-log=", 11 ) )
+        {
+            pTestOptions->scanFileName = arg + 11;
+        }
+        else if ( 0 == strncmp( arg, "--capture=", 10 ) )
+        {
+            pTestOptions->capturePrefix = arg + 10;
+        }
+        else if ( 0 == strncmp( arg, "--capture-files=", 16 ) )
+        {
+            Status = SplpParseCount( arg + 16, &pTestOptions->captureFiles );
+        }
+        else if ( 0 == strncmp( arg, "--capture-slots=", 16 ) )
+        {
+            Status = SplpParseCount( arg + 16, &pTestOptions->captureSlots );
+        }
+        else if ( 0 == strncmp( arg, "--capture-sample=", 17 ) )
+        {
+            Status = SplpParseCount( arg + 17, &pTestOptions->captureSampleRate );
+        }
+        else if ( 0 == strncmp( arg, "--capture-rate=", 15 ) )
+        {
+            Status = SplpParseCount( arg + 15, &pTestOptions->captureRate );
+        }
+        else if ( 0 == strncmp( arg, "--capture-export=", 17 ) )
+        {
+            pTestOptions->exportFileName = arg + 17;
+        }
+        else if ( 0 == strncmp( arg, "--overload=", 11 ) )
+        {
+            unsigned int policy;
+            for ( policy = 0; policy < SPLP_OVERLOAD_POLICY_COUNT; policy++ )
+            {
+                if ( 0 == strcmp( arg + 11, SplpOverloadPolicyName( (SPLP_OVERLOAD_POLICY) policy ) ) )
+                    pTestOptions->overloadPolicies |= 1u << policy;
+            }
+            if ( 0 == strcmp( arg + 11, "all" ) )
+                pTestOptions->overloadPolicies = ( 1u << SPLP_OVERLOAD_POLICY_COUNT ) - 1;
+            if ( pTestOptions->overloadPolicies == 0 )
+                Status = SPLP_STATUS_ERROR;
+        }
+        else if ( 0 == strncmp( arg, "--overload-load=", 16 ) )
+        {
+            Status = SplpParseCount( arg + 16, &pTestOptions->overloadLoad );
+        }
+        else if ( 0 == strncmp( arg, "--overload-high=", 16 ) )
+        {
+            Status = SplpParseCount( arg + 16, &pTestOptions->overloadHigh );
+        }
+        else if ( 0 == strncmp( arg, "--overload-low=", 15 ) )
+        {
+            char* end;
+            unsigned long value = strtoul( arg + 15, &end, 0 );
+            if ( end != arg + 15 && *end == 0 && value < UINT_MAX )
+                pTestOptions->overloadLow = value;
+            else
+                Status = SPLP_STATUS_ERROR;
+        }
+        else if ( 0 == strcmp( arg, "--bench" ) )
+        {
+            pTestOptions->benchmark = 1;
+        }
+        else if ( 0 == strncmp( arg, "--bench=", 8 ) )
+        {
+            pTestOptions->benchmark = 1;
+            pTestOptions->benchFilter = arg + 8;
+        }
+        else if ( 0 == strncmp( arg, "--bench-json=", 13 ) )
+        {
+            pTestOptions->benchmark = 1;
+            pTestOptions->benchJsonFileName = arg + 13;
+        }
+        else if ( 0 == strncmp( arg, "--bench-baseline=", 17 ) )
+        {
+            pTestOptions->benchBaselineFileName = arg + 17;
+        }
+        else if ( 0 == strncmp( arg, "--bench-current=", 16 ) )
+        {
+            pTestOptions->benchCurrentFileName = arg + 16;
+        }
+        else if ( 0 == strncmp( arg, "--bench-threshold=", 18 ) )
+        {
+            if ( SPLP_STATUS_OK != SplpParseCount( arg + 18, &pTestOptions->benchThreshold ) )
+                Status = SPLP_STATUS_ERROR;
+        }
+        else if ( 0 == strcmp( arg, "--openloop" ) )
+        {
+            pTestOptions->openLoop = 1;
+        }
+        else if ( 0 == strncmp( arg, "--openloop=", 11 ) )
+        {
+            pTestOptions->openLoop = 1;
+            pTestOptions->openLoopLoads = arg + 11;
+        }
+        else if ( 0 == strncmp( arg, "--openloop-arrival=", 19 ) )
+        {
+            if ( 0 == strcmp( arg + 19, "poisson" ) )
+                pTestOptions->openLoopArrival = SPLP_ARRIVAL_POISSON;
+            else if ( 0 == strcmp( arg + 19, "uniform" ) )
+                pTestOptions->openLoopArrival = SPLP_ARRIVAL_UNIFORM;
+            else
+                Status = SPLP_STATUS_ERROR;
+        }
+        else if ( 0 == strcmp( arg, "--openloop-batch" ) )
+        {
+            pTestOptions->openLoopSlo = DEFAULT_BATCH_SLO_USEC;
+        }
+        else if ( 0 == strncmp( arg, "--openloop-batch=", 17 ) )
         {
-            pTestOptions->cycleCount = cycleCount;
+            if ( SPLP_STATUS_OK != SplpParseCount( arg + 17, &pTestOptions->openLoopSlo ) )
+                Status = SPLP_STATUS_ERROR;
+        }
+        else if ( 0 == strncmp( arg, "--openloop-trace=", 17 ) )
+        {
+            pTestOptions->openLoopArrival = SPLP_ARRIVAL_TRACE;
+            pTestOptions->openLoopTrace = arg + 17;
+        }
+        else if ( 0 == strcmp( arg, "--engines" ) )
+        {
+            pTestOptions->engineMix = 1;
+        }
+        else if ( 0 == strncmp( arg, "--engines=", 10 ) )
+        {
+            pTestOptions->engineMix = 1;
+            pTestOptions->mixInvalid = arg + 10;
+        }
+        else if ( 0 == strcmp( arg, "--adversarial" ) )
+        {
+            pTestOptions->adversarial = 1;
+        }
+        else if ( 0 == strncmp( arg, "--adversarial=", 14 ) )
+        {
+            pTestOptions->adversarial = 1;
+            if ( SPLP_STATUS_OK != SplpParseCount( arg + 14, &pTestOptions->adversarialBound ) )
+                Status = SPLP_STATUS_ERROR;
+        }
+        else if ( 0 == strcmp( arg, "--concurrent" ) )
+        {
+            pTestOptions->concurrent = 1;
+        }
+        else if ( 0 == strncmp( arg, "--concurrent=", 13 ) )
+        {
+            pTestOptions->concurrent = 1;
+            pTestOptions->concurrentThreads = arg + 13;
+        }
+        else if ( 0 == strncmp( arg, "--concurrent-sessions=", 22 ) )
+        {
+            if ( SPLP_STATUS_OK != SplpParseCount( arg + 22, &pTestOptions->concurrentSessions ) )
+                Status = SPLP_STATUS_ERROR;
+        }
+        else if ( 0 == strncmp( arg, "--processes=", 12 ) )
+        {
+            if ( SPLP_STATUS_OK != SplpParseCount( arg + 12, &pTestOptions->processes ) ||
+                pTestOptions->processes > SPLP_PROC_MAX_PROCESSES )
+                Status = SPLP_STATUS_ERROR;
+        }
+        else if ( 0 == strncmp( arg, "--process-worker=", 17 ) )
+        {
+            if ( 2 != sscanf( arg + 17, "%u:%u", &pTestOptions->processIndex, &pTestOptions->processLauncher ) )
+                Status = SPLP_STATUS_ERROR;
+            pTestOptions->processWorker = 1;
+        }
+        else if ( 0 == strcmp( arg, "--priority" ) )
+        {
+            pTestOptions->priority = 1;
+        }
+        else if ( 0 == strncmp( arg, "--priority=", 11 ) )
+        {
+            pTestOptions->priority = 1;
+            if ( SPLP_STATUS_OK != SplpParseCount( arg + 11, &pTestOptions->prioritySlice ) ||
+                pTestOptions->prioritySlice == 0 )
+                Status = SPLP_STATUS_ERROR;
+        }
+        else if ( 0 == strcmp( arg, "--migrate" ) )
+        {
+            pTestOptions->migrateWorkers = DEFAULT_MIGRATE_WORKERS;
+        }
+        else if ( 0 == strncmp( arg, "--migrate=", 10 ) )
+        {
+            if ( SPLP_STATUS_OK != SplpParseCount( arg + 10, &pTestOptions->migrateWorkers ) ||
+                pTestOptions->migrateWorkers < 2 || pTestOptions->migrateWorkers > SPLP_MIGRATE_MAX_WORKERS )
+                Status = SPLP_STATUS_ERROR;
+        }
+        else if ( 0 == strcmp( arg, "--embed" ) )
+        {
+            pTestOptions->embed = 1;
+        }
+        else if ( 0 == strcmp( arg, "--scale" ) )
+        {
+            pTestOptions->scale = 1;
+        }
+        else if ( 0 == strncmp( arg, "--scale=", 8 ) )
+        {
+            pTestOptions->scale = 1;
+            pTestOptions->scaleSessions = arg + 8;
+        }
+        else if ( 0 == strcmp( arg, "--no-dedup" ) )
+        {
+            pTestOptions->noDedup = 1;
+        }
+        else if ( 0 == strncmp( arg, "--corpus-threads=", 17 ) )
+        {
+            if ( SPLP_STATUS_OK != SplpParseCount( arg + 17, &pTestOptions->corpusThreads ) )
+                Status = SPLP_STATUS_ERROR;
+        }
+        else if ( 0 == strncmp( arg, "--format=", 9 ) )
+        {
+            if ( 0 == strcmp( arg + 9, "text" ) )
+                pTestOptions->outputFormat = SPLP_FORMAT_TEXT;
+            else if ( 0 == strcmp( arg + 9, "json" ) )
+                pTestOptions->outputFormat = SPLP_FORMAT_JSON;
+            else if ( 0 == strcmp( arg + 9, "csv" ) )
+                pTestOptions->outputFormat = SPLP_FORMAT_CSV;
+            else
+                Status = SPLP_STATUS_ERROR;
+        }
+        else if ( 0 == strcmp( arg, "--alloc-check" ) )
+        {
+            pTestOptions->allocCheck = 1;
+        }
+        else if ( 0 == strncmp( arg, "--watchdog=", 11 ) )
+        {
+            pTestOptions->watchdogThreshold = strtoull( arg + 11, NULL, 0 );
+            if ( pTestOptions->watchdogThreshold == 0 )
+                Status = SPLP_STATUS_ERROR;
+        }
+        else if ( 0 == strncmp( arg, "--", 2 ) )
+        {
+            Status = SPLP_STATUS_ERROR;
+        }
+        else if ( positional == 0 )
+        {
+            pTestOptions->testFileName = arg;
+            positional++;
+        }
+        else if ( positional == 1 )
+        {
+            unsigned long cycleCount = strtoul( arg, NULL, 0 );
+            if ( cycleCount > 0 && cycleCount < ULONG_MAX )
+            {
+                pTestOptions->cycleCount = cycleCount;
+                positional++;
+            }
+            else
+            {
+                Status = SPLP_STATUS_ERROR;
+            }
         }
         else
         {
-            SplpPrintUsage( );
             Status = SPLP_STATUS_ERROR;
         }
     }
 
+    if ( Status == SPLP_STATUS_OK && !pTestOptions->benchBaselineFileName != !pTestOptions->benchCurrentFileName )
+    {
+        printf( "***ERROR*** --bench-baseline and --bench-current are used together\n" );
+        Status = SPLP_STATUS_ERROR;
+    }
+
+    /* between the watermarks the previous decision is kept */
+    if ( Status == SPLP_STATUS_OK && pTestOptions->overloadLow >= pTestOptions->overloadHigh )
+    {
+        printf( "***ERROR*** --overload-low=%u must be below --overload-high=%u\n",
+            pTestOptions->overloadLow, pTestOptions->overloadHigh );
+        Status = SPLP_STATUS_ERROR;
+    }
+
+    if ( Status != SPLP_STATUS_OK )
+    {
+        SplpPrintUsage( );
+    }
+
     return Status;
 }
\ No newline at end of file
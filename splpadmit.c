@@ -0,0 +1,300 @@
+/*
+* SPLPADMIT.c
+* The file is part of practical task for System programming course.
+* This file contains the admission control and the overload benchmark.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "splpadmit.h"
+
+
+
+
+static const char* SplpOverloadPolicyNames[ SPLP_OVERLOAD_POLICY_COUNT ] =
+{
+    "none", "shed", "open", "closed"
+};
+
+
+
+
+void SplpAdmissionInit(
+    PSPLP_ADMISSION pAdmission,
+    SPLP_OVERLOAD_POLICY policy,
+    unsigned int highWatermark,
+    unsigned int lowWatermark )
+{
+    memset( pAdmission, 0, sizeof( *pAdmission ) );
+    pAdmission->policy = policy;
+    pAdmission->highWatermark = highWatermark ? highWatermark : DEFAULT_OVERLOAD_HIGH;
+    pAdmission->lowWatermark = lowWatermark < pAdmission->highWatermark ? lowWatermark : pAdmission->highWatermark - 1;
+}
+
+
+
+
+/* SplpAdmissionShed
+* Decides whether SHED_CONNECT drops the message. While overloaded the
+* CONNECT of a session in INIT is dropped together with the response
+* which follows it, so the session isn't opened and stays in INIT.
+*/
+static int SplpAdmissionShed(
+    PSPLP_ADMISSION pAdmission,
+    PSPLP_ADMISSION_SESSION pSession,
+    const struct Message* pMsg )
+{
+    if ( pSession->shedResponse )
+    {
+        pSession->shedResponse = 0;
+        if ( pMsg->direction == B_TO_A )
+            return 1;
+    }
+
+    if ( pAdmission->overloaded && pSession->session.state == INIT &&
+        pMsg->direction == A_TO_B && 0 == strcmp( pMsg->text_message, "CONNECT" ) )
+    {
+        pSession->shedResponse = 1;
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+
+enum test_status SplpAdmissionValidate(
+    PSPLP_ADMISSION pAdmission,
+    PSPLP_ADMISSION_SESSION pSession,
+    unsigned int queueDepth,
+    struct Message* pMsg )
+{
+    enum State state = (enum State) pSession->session.state;
+
+    if ( !pAdmission->overloaded )
+    {
+        if ( queueDepth >= pAdmission->highWatermark )
+        {
+            pAdmission->overloaded = 1;
+            pAdmission->episodes++;
+        }
+    }
+    else if ( queueDepth <= pAdmission->lowWatermark )
+    {
+        pAdmission->overloaded = 0;
+    }
+
+    switch ( pAdmission->policy )
+    {
+    case SPLP_OVERLOAD_SHED_CONNECT:
+        /* consulted outside of overload too, for the response to a CONNECT shed before it ended */
+        if ( SplpAdmissionShed( pAdmission, pSession, pMsg ) )
+        {
+            pAdmission->shed++;
+            return MESSAGE_INVALID;
+        }
+        break;
+    case SPLP_OVERLOAD_FAIL_OPEN:
+        if ( pAdmission->overloaded && ( state == WAITING_DATA || state == WAITING_B64_DATA ) )
+        {
+            pAdmission->bypassed++;
+            return validate_session_message_fail_open( &pSession->session, pMsg );
+        }
+        break;
+    case SPLP_OVERLOAD_FAIL_CLOSED:
+        if ( pAdmission->overloaded )
+        {
+            pAdmission->failedClosed++;
+            pSession->session.state = INIT;
+            return MESSAGE_INVALID;
+        }
+        break;
+    default:
+        break;
+    }
+
+    pAdmission->admitted++;
+    return validate_session_message( &pSession->session, pMsg );
+}
+
+
+
+
+const char* SplpOverloadPolicyName(
+    SPLP_OVERLOAD_POLICY policy )
+{
+    return policy < SPLP_OVERLOAD_POLICY_COUNT ? SplpOverloadPolicyNames[ policy ] : "?";
+}
+
+
+
+
+static int SplpCompareTicks(
+    const void* pLeft,
+    const void* pRight )
+{
+    unsigned long long left = *(const unsigned long long*) pLeft;
+    unsigned long long right = *(const unsigned long long*) pRight;
+    return left < right ? -1 : left > right ? 1 : 0;
+}
+
+
+
+
+/* SplpOverloadCalibrate
+* Measures the mean validation time of a message in TSC ticks, timed
+* the same way as in SplpOverloadRun( ), and the TSC frequency. The
+* file is replayed until clock( ) has seen at least a tenth of a second.
+*/
+static void SplpOverloadCalibrate(
+    PSPLP_TEST_DATA pData,
+    double* pServiceTicks,
+    double* pTicksPerSecond )
+{
+    struct Session session = { INIT, REASON_NONE };
+    unsigned long long messages = 0;
+    unsigned long long busy = 0;
+    unsigned long long tscStart;
+    clock_t start;
+    unsigned int msgIdx;
+
+    start = clock( );
+    tscStart = SplpReadTsc( );
+
+    do
+    {
+        for ( msgIdx = 0; msgIdx < pData->size; msgIdx++ )
+        {
+            unsigned long long begin = SplpReadTsc( );
+            validate_session_message( &session, &pData->MessageArray[ msgIdx ].msg );
+            busy += SplpReadTsc( ) - begin;
+        }
+        messages += pData->size;
+    } while ( clock( ) - start < CLOCKS_PER_SEC / 10 );
+
+    *pServiceTicks = (double) busy / (double) messages;
+    *pTicksPerSecond = (double) ( SplpReadTsc( ) - tscStart ) * CLOCKS_PER_SEC / (double) ( clock( ) - start );
+}
+
+
+
+
+/* SplpOverloadRun
+* Replays the test file as an open-loop arrival process at a fixed
+* rate. The queue is simulated in TSC time: a message waits until the
+* validator has finished all earlier ones, its own validation is really
+* executed and timed. The queue depth seen by the admission control is
+* the number of messages which have arrived but are not done yet.
+*/
+static void SplpOverloadRun(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_DATA pData,
+    SPLP_OVERLOAD_POLICY policy,
+    double interval,
+    double ticksPerSecond,
+    unsigned long long* pLatency )
+{
+    SPLP_ADMISSION admission;
+    SPLP_ADMISSION_SESSION session = { { INIT, REASON_NONE }, 0 };
+    unsigned long long total = (unsigned long long) pData->size * pOptions->cycleCount;
+    unsigned long long correct = 0;
+    unsigned long long now = 0;
+    unsigned long long msgNumber;
+    double seconds;
+
+    SplpAdmissionInit( &admission, policy, pOptions->overloadHigh, pOptions->overloadLow );
+
+    for ( msgNumber = 0; msgNumber < total; msgNumber++ )
+    {
+        PSPLP_TEST_MESSAGE pMsg = &pData->MessageArray[ msgNumber % pData->size ];
+        unsigned long long arrival = (unsigned long long) ( msgNumber * interval );
+        unsigned long long arrived;
+        unsigned long long begin;
+        enum test_status result;
+
+        if ( now < arrival )
+            now = arrival;
+
+        arrived = (unsigned long long) ( now / interval ) + 1;
+        if ( arrived > total )
+            arrived = total;
+
+        begin = SplpReadTsc( );
+        result = SplpAdmissionValidate( &admission, &session, (unsigned int) ( arrived - msgNumber ), &pMsg->msg );
+        now += SplpReadTsc( ) - begin;
+
+        pLatency[ msgNumber ] = now - arrival;
+        if ( result == pMsg->expectedTestStatus )
+            correct++;
+    }
+
+    qsort( pLatency, (size_t) total, sizeof( pLatency[ 0 ] ), SplpCompareTicks );
+    seconds = now / ticksPerSecond;
+
+    printf( "\t%-8s %14.0f %10llu %10llu %10llu %10llu %12.2f %12.2f\n",
+        SplpOverloadPolicyName( policy ),
+        seconds > 0 ? correct / seconds : 0,
+        correct,
+        admission.shed,
+        admission.bypassed,
+        admission.failedClosed,
+        pLatency[ total / 2 ] * 1000000.0 / ticksPerSecond,
+        pLatency[ total - 1 - total / 100 ] * 1000000.0 / ticksPerSecond );
+}
+
+
+
+
+SPLP_STATUS SplpOverloadBenchmark(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_DATA pData )
+{
+    unsigned long long total = (unsigned long long) pData->size * pOptions->cycleCount;
+    unsigned long long* pLatency;
+    double serviceTicks;
+    double ticksPerSecond;
+    double interval;
+    unsigned int policy;
+
+    pLatency = (unsigned long long*) malloc( (size_t) total * sizeof( *pLatency ) );
+    if ( !pLatency )
+    {
+        printf( "***ERROR*** Not enough memory for %llu latency samples\n", total );
+        return SPLP_STATUS_ERROR;
+    }
+
+    SplpOverloadCalibrate( pData, &serviceTicks, &ticksPerSecond );
+    interval = serviceTicks * 100.0 / pOptions->overloadLoad;
+
+    printf(
+        "======================================================================\n"
+        " OVERLOAD BENCHMARK:\n"
+        "======================================================================\n"
+        "\tTest file:        \"%s\"\n"
+        "\tMessages:         \t%14llu\n"
+        "\tCapacity (msg/s): \t%14.0f\n"
+        "\tOffered load:     \t%13u%%\n"
+        "\tWatermarks:       \t%8u / %3u\n\n",
+        pOptions->testFileName,
+        total,
+        ticksPerSecond / serviceTicks,
+        pOptions->overloadLoad,
+        pOptions->overloadHigh ? pOptions->overloadHigh : DEFAULT_OVERLOAD_HIGH,
+        pOptions->overloadLow );
+
+    printf( "\t%-8s %14s %10s %10s %10s %10s %12s %12s\n",
+        "Policy", "Goodput msg/s", "Correct", "Shed", "Bypassed", "Closed", "p50 usec", "p99 usec" );
+
+    for ( policy = 0; policy < SPLP_OVERLOAD_POLICY_COUNT; policy++ )
+    {
+        if ( pOptions->overloadPolicies & ( 1u << policy ) )
+            SplpOverloadRun( pOptions, pData, (SPLP_OVERLOAD_POLICY) policy, interval, ticksPerSecond, pLatency );
+    }
+
+    printf( "======================================================================\n" );
+
+    free( pLatency );
+    return SPLP_STATUS_OK;
+}
@@ -0,0 +1,103 @@
+/*
+* SPLPADMIT.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the admission control which keeps
+* the validator latency bounded when it can't keep up with the input.
+*/
+#ifndef SPLPADMIT_H
+#define SPLPADMIT_H
+
+#include "splpv1.h"
+#include "splptest.h"
+
+
+
+#define DEFAULT_OVERLOAD_HIGH     64      /* queue depth entering overload */
+#define DEFAULT_OVERLOAD_LOW      16      /* queue depth leaving overload */
+#define DEFAULT_OVERLOAD_LOAD     200     /* offered load, % of capacity */
+
+
+
+
+/* SPLP_OVERLOAD_POLICY
+* What the validator does with a message while it is overloaded.
+*/
+typedef enum _SPLP_OVERLOAD_POLICY
+{
+    SPLP_OVERLOAD_NONE,           /* validate everything */
+    SPLP_OVERLOAD_SHED_CONNECT,   /* drop the CONNECT of new sessions */
+    SPLP_OVERLOAD_FAIL_OPEN,      /* skip payload scans of established sessions */
+    SPLP_OVERLOAD_FAIL_CLOSED,    /* reject everything */
+    SPLP_OVERLOAD_POLICY_COUNT
+} SPLP_OVERLOAD_POLICY;
+
+
+
+
+/* SPLP_ADMISSION
+* Admission state of one validator. Each worker owns its own instance,
+* so the watermark check is a compare against a local queue depth.
+* Between the watermarks the previous decision is kept.
+*/
+typedef struct _SPLP_ADMISSION
+{
+    SPLP_OVERLOAD_POLICY policy;
+    unsigned int       highWatermark;
+    unsigned int       lowWatermark;
+    unsigned int       overloaded;
+    unsigned long long episodes;      /* times overload was entered */
+    unsigned long long admitted;      /* fully validated messages */
+    unsigned long long shed;          /* CONNECTs and their responses dropped by SHED_CONNECT */
+    unsigned long long bypassed;      /* payload scan skipped by FAIL_OPEN */
+    unsigned long long failedClosed;  /* rejected by FAIL_CLOSED */
+
+}SPLP_ADMISSION, *PSPLP_ADMISSION;
+
+
+
+
+/* SPLP_ADMISSION_SESSION
+* One connection as seen by the admission control. While the validator
+* is overloaded, SHED_CONNECT drops the CONNECT of a session in INIT and
+* the response to it. The session stays in INIT, so the next CONNECT of
+* the client is a retry; established sessions are always validated.
+*/
+typedef struct _SPLP_ADMISSION_SESSION
+{
+    struct Session     session;        /* starts as { INIT, REASON_NONE } */
+    unsigned char      shedResponse;   /* the CONNECT before was shed */
+
+}SPLP_ADMISSION_SESSION, *PSPLP_ADMISSION_SESSION;
+
+
+
+
+void SplpAdmissionInit(
+    PSPLP_ADMISSION pAdmission,
+    SPLP_OVERLOAD_POLICY policy,
+    unsigned int highWatermark,
+    unsigned int lowWatermark );
+
+
+
+
+enum test_status SplpAdmissionValidate(
+    PSPLP_ADMISSION pAdmission,
+    PSPLP_ADMISSION_SESSION pSession,
+    unsigned int queueDepth,
+    struct Message* pMsg );
+
+
+
+
+const char* SplpOverloadPolicyName(
+    SPLP_OVERLOAD_POLICY policy );
+
+
+
+
+SPLP_STATUS SplpOverloadBenchmark(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_DATA pData );
+
+#endif /* SPLPADMIT_H */
@@ -0,0 +1,427 @@
+/*
+* SPLPADV.c
+* The file is part of practical task for System programming course.
+* This file contains the adversarial benchmark. Its messages are built
+* to find inputs on which validation is more than linear in the message
+* length: near misses of every keyword, maximal payloads, truncated
+* base64 and bytes outside of ASCII. Every message is timed in TSC
+* cycles and charged per byte, messages shorter than SPLP_ADV_MIN_BYTES
+* as if they were that long, so the fixed cost of a message and the
+* cost of its bytes are held to the same bound.
+*/
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "splpv1.h"
+#include "splpadv.h"
+#include "splpref.h"
+#include "splpbench.h"
+#include "splplog.h"
+
+
+
+#define SPLP_ADV_SAMPLE_SECONDS   0.002   /* minimal duration of a sample */
+
+#define SPLP_ADV_DATA             "abcdefghijklmnopqrstuvwxyz0123456789."
+#define SPLP_ADV_BASE64           "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"
+#define SPLP_ADV_DIGITS           "0123456789"
+
+
+
+
+static const char* SplpAdvClasses[ ] =
+{
+    "near_miss", "max_payload", "truncated_b64", "non_ascii"
+};
+
+#define SPLP_ADV_CLASS_COUNT      ( sizeof( SplpAdvClasses ) / sizeof( SplpAdvClasses[ 0 ] ) )
+
+
+
+
+static const unsigned int SplpAdvSizes[ ] =
+{
+    16, 4096, 1048576
+};
+
+
+
+
+/* SPLP_ADV_CASE
+* An adversarial message validated in a fixed state.
+*/
+typedef struct _SPLP_ADV_CASE
+{
+    const char*        inputClass;
+    char               name[ SPLP_BENCH_NAME_SIZE ];
+    enum State         state;
+    struct Message     msg;
+    unsigned int       length;
+
+}SPLP_ADV_CASE, *PSPLP_ADV_CASE;
+
+
+
+
+typedef struct _SPLP_ADV_SUITE
+{
+    SPLP_ADV_CASE      cases[ SPLP_ADV_CAPACITY ];
+    unsigned int       count;
+
+}SPLP_ADV_SUITE, *PSPLP_ADV_SUITE;
+
+
+
+
+/* SplpAdvAdd
+* Adds a case, text is owned by the suite afterwards.
+*/
+static SPLP_STATUS SplpAdvAdd(
+    PSPLP_ADV_SUITE pSuite,
+    const char* inputClass,
+    const char* name,
+    enum State state,
+    enum Direction direction,
+    char* text )
+{
+    PSPLP_ADV_CASE pCase;
+
+    if ( !text || pSuite->count == SPLP_ADV_CAPACITY )
+    {
+        free( text );
+        printf( "***ERROR*** Cannot add adversarial message \"%s\"\n", name );
+        return SPLP_STATUS_ERROR;
+    }
+
+    pCase = &pSuite->cases[ pSuite->count++ ];
+    pCase->inputClass = inputClass;
+    strncpy( pCase->name, name, SPLP_BENCH_NAME_SIZE - 1 );
+    pCase->name[ SPLP_BENCH_NAME_SIZE - 1 ] = '\0';
+    pCase->state = state;
+    pCase->msg.direction = direction;
+    pCase->msg.text_message = text;
+    pCase->length = (unsigned int) strlen( text );
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+/* SplpAdvMake
+* Builds prefix, size bytes taken from alphabet in turn, and suffix.
+*/
+static char* SplpAdvMake(
+    const char* prefix,
+    const char* alphabet,
+    unsigned int size,
+    const char* suffix )
+{
+    size_t prefixLength = strlen( prefix );
+    size_t alphabetLength = strlen( alphabet );
+    size_t suffixLength = strlen( suffix );
+    char* text = (char*) malloc( prefixLength + size + suffixLength + 1 );
+    unsigned int i;
+
+    if ( !text )
+        return NULL;
+
+    memcpy( text, prefix, prefixLength );
+    for ( i = 0; i < size; i++ )
+        text[ prefixLength + i ] = alphabet[ i % alphabetLength ];
+    memcpy( text + prefixLength + size, suffix, suffixLength + 1 );
+    return text;
+}
+
+
+
+
+/* SplpAdvPatch
+* Overwrites the byte at offset from the end of text.
+*/
+static char* SplpAdvPatch(
+    char* text,
+    size_t offset,
+    char value )
+{
+    if ( text )
+        text[ strlen( text ) - offset ] = value;
+    return text;
+}
+
+
+
+
+static SPLP_STATUS SplpAdvInit(
+    PSPLP_ADV_SUITE pSuite )
+{
+    static const struct
+    {
+        const char*      inputClass;
+        const char*      name;
+        enum State       state;
+        enum Direction   direction;
+        const char*      text;
+    } fixed[ ] =
+    {
+        { "near_miss",     "connect_last",      INIT,             A_TO_B, "CONNECX" },
+        { "near_miss",     "connect_short",     INIT,             A_TO_B, "CONNEC" },
+        { "near_miss",     "connect_ok_last",   CONNECTING,       B_TO_A, "CONNECT_OX" },
+        { "near_miss",     "connect_ok_long",   CONNECTING,       B_TO_A, "CONNECT_OK_" },
+        { "near_miss",     "get_data_last",     CONNECTED,        A_TO_B, "GET_DATX" },
+        { "near_miss",     "get_command_last",  CONNECTED,        A_TO_B, "GET_COMMANX" },
+        { "near_miss",     "disconnect_last",   CONNECTED,        A_TO_B, "DISCONNECX" },
+        { "near_miss",     "get_version",       CONNECTED,        A_TO_B, "GET_VERSION" },
+        { "near_miss",     "version_last",      WAITING_VER,      B_TO_A, "VERSIOX 1" },
+        { "near_miss",     "version_bare",      WAITING_VER,      B_TO_A, "VERSION" },
+        { "near_miss",     "data_prefix",       WAITING_DATA,     B_TO_A, "GET_DATX a GET_DATA" },
+        { "near_miss",     "data_suffix",       WAITING_DATA,     B_TO_A, "GET_DATA a GET_DATX" },
+        { "near_miss",     "data_bare",         WAITING_DATA,     B_TO_A, "GET_COMMAND" },
+        { "near_miss",     "b64_prefix",        WAITING_B64_DATA, B_TO_A, "B64; QUJD" },
+        { "near_miss",     "b64_separator",     WAITING_B64_DATA, B_TO_A, "B64:QUJD" },
+        { "near_miss",     "disconnect_ok_last", DISCONNECTING,   B_TO_A, "DISCONNECT_OX" },
+        { "truncated_b64", "empty",             WAITING_B64_DATA, B_TO_A, "B64: " },
+        { "truncated_b64", "one",               WAITING_B64_DATA, B_TO_A, "B64: Q" },
+        { "truncated_b64", "two",               WAITING_B64_DATA, B_TO_A, "B64: QU" },
+        { "truncated_b64", "three",             WAITING_B64_DATA, B_TO_A, "B64: QUJ" },
+        { "truncated_b64", "pad_only",          WAITING_B64_DATA, B_TO_A, "B64: ==" },
+        { "truncated_b64", "pad_one",           WAITING_B64_DATA, B_TO_A, "B64: Q=" },
+        { "truncated_b64", "keyword",           WAITING_B64_DATA, B_TO_A, "B64:" },
+        { "non_ascii",     "connect",           INIT,             A_TO_B, "CONNECT\xe9" },
+        { "non_ascii",     "get_data",          CONNECTED,        A_TO_B, "GET_DAT\xc1" },
+        { "non_ascii",     "version",           WAITING_VER,      B_TO_A, "VERSION \xb9" },
+        { "non_ascii",     "data",              WAITING_DATA,     B_TO_A, "GET_DATA \xc3\xa9 GET_DATA" },
+        { "non_ascii",     "data_suffix",       WAITING_DATA,     B_TO_A, "GET_DATA a GET_DATA\xff" },
+        { "non_ascii",     "b64",               WAITING_B64_DATA, B_TO_A, "B64: \x80\x80\x80\x80" },
+        { "non_ascii",     "b64_last",          WAITING_B64_DATA, B_TO_A, "B64: QU\xff=" },
+    };
+    char name[ SPLP_BENCH_NAME_SIZE ];
+    SPLP_STATUS status = SPLP_STATUS_OK;
+    unsigned int i;
+
+    memset( pSuite, 0, sizeof( *pSuite ) );
+
+    for ( i = 0; i < sizeof( fixed ) / sizeof( fixed[ 0 ] ) && status == SPLP_STATUS_OK; i++ )
+    {
+        status = SplpAdvAdd( pSuite, fixed[ i ].inputClass, fixed[ i ].name, fixed[ i ].state,
+            fixed[ i ].direction, SplpAdvMake( fixed[ i ].text, "", 0, "" ) );
+    }
+
+    for ( i = 0; i < sizeof( SplpAdvSizes ) / sizeof( SplpAdvSizes[ 0 ] ) && status == SPLP_STATUS_OK; i++ )
+    {
+        unsigned int size = SplpAdvSizes[ i ];
+
+        /* keywords followed by a long tail, compares must stop at the keyword */
+        sprintf( name, "connect_tail/%u", size );
+        status = SplpAdvAdd( pSuite, "near_miss", name, INIT, A_TO_B,
+            SplpAdvMake( "CONNECT", "T", size, "" ) );
+        sprintf( name, "data_suffix_tail/%u", size );
+        if ( status == SPLP_STATUS_OK )
+            status = SplpAdvAdd( pSuite, "near_miss", name, WAITING_DATA, B_TO_A,
+                SplpAdvMake( "GET_DATA a GET_DATA", "A", size, "" ) );
+
+        sprintf( name, "data/%u", size );
+        if ( status == SPLP_STATUS_OK )
+            status = SplpAdvAdd( pSuite, "max_payload", name, WAITING_DATA, B_TO_A,
+                SplpAdvMake( "GET_DATA ", SPLP_ADV_DATA, size, " GET_DATA" ) );
+        sprintf( name, "command/%u", size );
+        if ( status == SPLP_STATUS_OK )
+            status = SplpAdvAdd( pSuite, "max_payload", name, WAITING_DATA, B_TO_A,
+                SplpAdvMake( "GET_COMMAND ", SPLP_ADV_DATA, size, " GET_COMMAND" ) );
+        sprintf( name, "data_no_suffix/%u", size );
+        if ( status == SPLP_STATUS_OK )
+            status = SplpAdvAdd( pSuite, "max_payload", name, WAITING_DATA, B_TO_A,
+                SplpAdvMake( "GET_DATA ", SPLP_ADV_DATA, size, "" ) );
+        sprintf( name, "data_char_last/%u", size );
+        if ( status == SPLP_STATUS_OK )
+            status = SplpAdvAdd( pSuite, "max_payload", name, WAITING_DATA, B_TO_A,
+                SplpAdvPatch( SplpAdvMake( "GET_DATA ", SPLP_ADV_DATA, size, " GET_DATA" ), 10, 'A' ) );
+        sprintf( name, "b64/%u", size );
+        if ( status == SPLP_STATUS_OK )
+            status = SplpAdvAdd( pSuite, "max_payload", name, WAITING_B64_DATA, B_TO_A,
+                SplpAdvMake( "B64: ", SPLP_ADV_BASE64, size, "" ) );
+        sprintf( name, "version/%u", size );
+        if ( status == SPLP_STATUS_OK )
+            status = SplpAdvAdd( pSuite, "max_payload", name, WAITING_VER, B_TO_A,
+                SplpAdvMake( "VERSION ", SPLP_ADV_DIGITS, size, "" ) );
+
+        sprintf( name, "length/%u", size );
+        if ( status == SPLP_STATUS_OK )
+            status = SplpAdvAdd( pSuite, "truncated_b64", name, WAITING_B64_DATA, B_TO_A,
+                SplpAdvMake( "B64: ", SPLP_ADV_BASE64, size - 1, "" ) );
+        sprintf( name, "pad_middle/%u", size );
+        if ( status == SPLP_STATUS_OK )
+            status = SplpAdvAdd( pSuite, "truncated_b64", name, WAITING_B64_DATA, B_TO_A,
+                SplpAdvPatch( SplpAdvMake( "B64: ", SPLP_ADV_BASE64, size, "" ), 3, '=' ) );
+
+        sprintf( name, "data_last/%u", size );
+        if ( status == SPLP_STATUS_OK )
+            status = SplpAdvAdd( pSuite, "non_ascii", name, WAITING_DATA, B_TO_A,
+                SplpAdvPatch( SplpAdvMake( "GET_DATA ", SPLP_ADV_DATA, size, " GET_DATA" ), 10, '\xe9' ) );
+        sprintf( name, "b64_last/%u", size );
+        if ( status == SPLP_STATUS_OK )
+            status = SplpAdvAdd( pSuite, "non_ascii", name, WAITING_B64_DATA, B_TO_A,
+                SplpAdvPatch( SplpAdvMake( "B64: ", SPLP_ADV_BASE64, size, "" ), 3, '\x80' ) );
+        sprintf( name, "version_last/%u", size );
+        if ( status == SPLP_STATUS_OK )
+            status = SplpAdvAdd( pSuite, "non_ascii", name, WAITING_VER, B_TO_A,
+                SplpAdvPatch( SplpAdvMake( "VERSION ", SPLP_ADV_DIGITS, size, "" ), 1, '\xb9' ) );
+    }
+
+    return status;
+}
+
+
+
+
+static void SplpAdvFree(
+    PSPLP_ADV_SUITE pSuite )
+{
+    unsigned int i;
+
+    for ( i = 0; i < pSuite->count; i++ )
+        free( pSuite->cases[ i ].msg.text_message );
+    pSuite->count = 0;
+}
+
+
+
+
+static unsigned long long SplpAdvSample(
+    const SPLP_ADV_CASE* pCase,
+    unsigned int iterations )
+{
+    struct Message msg = pCase->msg;
+    struct Session session = { INIT, REASON_NONE };
+    unsigned long long begin = SplpReadTsc( );
+    unsigned int i;
+
+    for ( i = 0; i < iterations; i++ )
+    {
+        session.state = (unsigned char) pCase->state;
+        validate_session_message( &session, &msg );
+    }
+    return SplpReadTsc( ) - begin;
+}
+
+
+
+
+static int SplpAdvCompareDouble(
+    const void* pLeft,
+    const void* pRight )
+{
+    double left = *(const double*) pLeft;
+    double right = *(const double*) pRight;
+    return left < right ? -1 : left > right ? 1 : 0;
+}
+
+
+
+
+/* SplpAdvCycles
+* Median cycles of one validation of the message.
+*/
+static double SplpAdvCycles(
+    const SPLP_ADV_CASE* pCase,
+    double sampleTicks )
+{
+    double samples[ SPLP_BENCH_SAMPLES ];
+    unsigned int iterations = 1;
+    unsigned int sampleIdx;
+
+    while ( SplpAdvSample( pCase, iterations ) < sampleTicks && iterations < 0x40000000 )
+        iterations *= 2;
+
+    for ( sampleIdx = 0; sampleIdx < SPLP_BENCH_SAMPLES; sampleIdx++ )
+        samples[ sampleIdx ] = (double) SplpAdvSample( pCase, iterations ) / iterations;
+
+    qsort( samples, SPLP_BENCH_SAMPLES, sizeof( samples[ 0 ] ), SplpAdvCompareDouble );
+    return samples[ SPLP_BENCH_SAMPLES / 2 ];
+}
+
+
+
+
+SPLP_STATUS SplpAdversarialBenchmark(
+    unsigned int bound,
+    unsigned int* pViolations )
+{
+    static SPLP_ADV_SUITE suite;
+    double classWorst[ SPLP_ADV_CLASS_COUNT ] = { 0 };
+    double sampleTicks;
+    unsigned int i;
+    unsigned int c;
+
+    *pViolations = 0;
+    if ( SPLP_STATUS_OK != SplpAdvInit( &suite ) )
+    {
+        SplpAdvFree( &suite );
+        return SPLP_STATUS_ERROR;
+    }
+
+    /* a message on the wrong path would be timed for nothing */
+    for ( i = 0; i < suite.count; i++ )
+    {
+        PSPLP_ADV_CASE pCase = &suite.cases[ i ];
+        struct Session reference = { INIT, REASON_NONE };
+        struct Session session = { INIT, REASON_NONE };
+
+        reference.state = session.state = (unsigned char) pCase->state;
+        if ( validate_session_message( &session, &pCase->msg ) != validate_reference_message( &reference, &pCase->msg ) ||
+            session.state != reference.state )
+        {
+            printf( "***ERROR*** Adversarial message %s/%s differs from the reference\n",
+                pCase->inputClass, pCase->name );
+            SplpAdvFree( &suite );
+            return SPLP_STATUS_ERROR;
+        }
+    }
+
+    sampleTicks = SplpTscTicksPerSecond( ) * SPLP_ADV_SAMPLE_SECONDS;
+
+    printf(
+        "======================================================================\n"
+        " ADVERSARIAL MESSAGES (TSC cycles):\n"
+        "======================================================================\n"
+        "\tBound:            \t%14u cycles/byte\n"
+        "\tMinimal bytes:    \t%14u\n"
+        "\tSamples:          \t%14u\n\n",
+        bound,
+        SPLP_ADV_MIN_BYTES,
+        SPLP_BENCH_SAMPLES );
+
+    printf( "\t%-14s %-24s %-17s %8s %12s %8s\n", "Class", "Message", "State", "Bytes", "Cycles", "Cyc/B" );
+    for ( i = 0; i < suite.count; i++ )
+    {
+        PSPLP_ADV_CASE pCase = &suite.cases[ i ];
+        double cycles = SplpAdvCycles( pCase, sampleTicks );
+        double perByte = cycles / ( pCase->length > SPLP_ADV_MIN_BYTES ? pCase->length : SPLP_ADV_MIN_BYTES );
+
+        for ( c = 0; c < SPLP_ADV_CLASS_COUNT && strcmp( SplpAdvClasses[ c ], pCase->inputClass ); c++ )
+            ;
+        if ( c < SPLP_ADV_CLASS_COUNT && perByte > classWorst[ c ] )
+            classWorst[ c ] = perByte;
+
+        if ( perByte > bound )
+            ( *pViolations )++;
+        printf( "\t%-14s %-24s %-17s %8u %12.1f %8.2f%s\n",
+            pCase->inputClass,
+            pCase->name,
+            SplpLogStateName( pCase->state ),
+            pCase->length,
+            cycles,
+            perByte,
+            perByte > bound ? "  EXCEEDED" : "" );
+    }
+
+    printf( "\n\t%-14s %8s\n", "Class", "Worst" );
+    for ( c = 0; c < SPLP_ADV_CLASS_COUNT; c++ )
+        printf( "\t%-14s %8.2f%s\n", SplpAdvClasses[ c ], classWorst[ c ], classWorst[ c ] > bound ? "  EXCEEDED" : "" );
+    printf( "\n\tOver the bound:   \t%14u\n", *pViolations );
+    printf( "======================================================================\n" );
+
+    SplpAdvFree( &suite );
+    return SPLP_STATUS_OK;
+}
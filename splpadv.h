@@ -0,0 +1,30 @@
+/*
+* SPLPADV.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the adversarial benchmark, which
+* bounds the cost of validate_session_message( ) per message byte.
+*/
+#ifndef SPLPADV_H
+#define SPLPADV_H
+
+#include "splptest.h"
+
+
+
+#define DEFAULT_ADV_BOUND         8       /* TSC cycles per byte */
+#define SPLP_ADV_MIN_BYTES        16      /* shorter messages are charged as this long */
+#define SPLP_ADV_CAPACITY         96
+
+
+
+
+/* SplpAdversarialBenchmark
+* Times every adversarial message and checks its verdict against the
+* reference validator. pViolations receives the number of messages
+* which cost more than bound cycles per byte.
+*/
+SPLP_STATUS SplpAdversarialBenchmark(
+    unsigned int bound,
+    unsigned int* pViolations );
+
+#endif /* SPLPADV_H */
@@ -0,0 +1,186 @@
+/*
+* SPLPALLOC.c
+* The file is part of practical task for System programming course.
+* This file contains the allocation counter.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "splpalloc.h"
+
+#if defined( SPLP_ALLOC_INTERPOSE )
+#include <errno.h>
+#include <malloc.h>
+#elif defined( SPLP_ALLOC_CRT_HOOK )
+#include <crtdbg.h>
+#endif
+
+#if defined( _MSC_VER )
+#define SPLP_THREAD_LOCAL         __declspec( thread )
+#else
+#define SPLP_THREAD_LOCAL         __thread
+#endif
+
+
+
+/* Only the watching thread counts, e.g. not the traffic generator of
+* the open-loop benchmark, whose thread start and exit allocate */
+static SPLP_THREAD_LOCAL int SplpAllocWatching = 0;
+static unsigned long long SplpAllocCounts[ 3 ];
+
+#define SPLP_ALLOC_MALLOC         0
+#define SPLP_ALLOC_REALLOC        1
+#define SPLP_ALLOC_FREE           2
+
+
+
+
+static __inline void SplpAllocCount(
+    int kind )
+{
+    if ( SplpAllocWatching )
+        SplpAllocCounts[ kind ]++;
+}
+
+
+
+
+#if defined( SPLP_ALLOC_INTERPOSE )
+
+extern void* __libc_malloc( size_t size );
+extern void* __libc_calloc( size_t count, size_t size );
+extern void* __libc_realloc( void* pBlock, size_t size );
+extern void  __libc_free( void* pBlock );
+extern void* __libc_memalign( size_t alignment, size_t size );
+extern void* __libc_valloc( size_t size );
+extern void* __libc_pvalloc( size_t size );
+
+void* malloc( size_t size )
+{
+    SplpAllocCount( SPLP_ALLOC_MALLOC );
+    return __libc_malloc( size );
+}
+
+void* calloc( size_t count, size_t size )
+{
+    SplpAllocCount( SPLP_ALLOC_MALLOC );
+    return __libc_calloc( count, size );
+}
+
+void* realloc( void* pBlock, size_t size )
+{
+    SplpAllocCount( SPLP_ALLOC_REALLOC );
+    return __libc_realloc( pBlock, size );
+}
+
+void free( void* pBlock )
+{
+    /* free( NULL ) doesn't reach the allocator, stdio does it a lot */
+    if ( pBlock )
+        SplpAllocCount( SPLP_ALLOC_FREE );
+    __libc_free( pBlock );
+}
+
+/* The aligned allocators must be interposed too, otherwise their blocks
+* would be counted by free( ) only */
+int posix_memalign( void** ppBlock, size_t alignment, size_t size )
+{
+    void* pBlock;
+
+    if ( alignment % sizeof( void* ) != 0 || ( alignment & ( alignment - 1 ) ) != 0 || alignment == 0 )
+        return EINVAL;
+    SplpAllocCount( SPLP_ALLOC_MALLOC );
+    pBlock = __libc_memalign( alignment, size );
+    if ( !pBlock )
+        return ENOMEM;
+    *ppBlock = pBlock;
+    return 0;
+}
+
+void* aligned_alloc( size_t alignment, size_t size )
+{
+    SplpAllocCount( SPLP_ALLOC_MALLOC );
+    return __libc_memalign( alignment, size );
+}
+
+void* memalign( size_t alignment, size_t size )
+{
+    SplpAllocCount( SPLP_ALLOC_MALLOC );
+    return __libc_memalign( alignment, size );
+}
+
+void* valloc( size_t size )
+{
+    SplpAllocCount( SPLP_ALLOC_MALLOC );
+    return __libc_valloc( size );
+}
+
+void* pvalloc( size_t size )
+{
+    SplpAllocCount( SPLP_ALLOC_MALLOC );
+    return __libc_pvalloc( size );
+}
+
+#elif defined( SPLP_ALLOC_CRT_HOOK )
+
+static int SplpAllocHook(
+    int allocType,
+    void* pUserData,
+    size_t size,
+    int blockType,
+    long requestNumber,
+    const unsigned char* fileName,
+    int lineNumber )
+{
+    (void) pUserData; (void) size; (void) blockType;
+    (void) requestNumber; (void) fileName; (void) lineNumber;
+
+    SplpAllocCount( allocType == _HOOK_ALLOC ? SPLP_ALLOC_MALLOC :
+        allocType == _HOOK_REALLOC ? SPLP_ALLOC_REALLOC : SPLP_ALLOC_FREE );
+    return TRUE;
+}
+
+#endif
+
+
+
+
+int SplpAllocSupported( void )
+{
+#if defined( SPLP_ALLOC_INTERPOSE ) || defined( SPLP_ALLOC_CRT_HOOK )
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+
+
+
+void SplpAllocWatchStart( void )
+{
+#if defined( SPLP_ALLOC_CRT_HOOK )
+    static int installed = 0;
+    if ( !installed )
+    {
+        _CrtSetAllocHook( SplpAllocHook );
+        installed = 1;
+    }
+#endif
+
+    SplpAllocCounts[ SPLP_ALLOC_MALLOC ] = 0;
+    SplpAllocCounts[ SPLP_ALLOC_REALLOC ] = 0;
+    SplpAllocCounts[ SPLP_ALLOC_FREE ] = 0;
+    SplpAllocWatching = 1;
+}
+
+
+
+
+void SplpAllocWatchStop(
+    PSPLP_ALLOC_COUNT pCount )
+{
+    SplpAllocWatching = 0;
+    pCount->allocs = SplpAllocCounts[ SPLP_ALLOC_MALLOC ];
+    pCount->reallocs = SplpAllocCounts[ SPLP_ALLOC_REALLOC ];
+    pCount->frees = SplpAllocCounts[ SPLP_ALLOC_FREE ];
+}
@@ -0,0 +1,67 @@
+/*
+* SPLPALLOC.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the allocation counter. It counts
+* calls to the heap allocator made by the calling thread between
+* SplpAllocWatchStart( ) and SplpAllocWatchStop( ), to prove that timed
+* loops never allocate.
+*
+* With glibc the allocator functions, including the aligned ones, are
+* interposed in this executable and forwarded to glibc when it is built
+* with SPLP_ALLOC_CHECK defined; other builds leave the allocator alone,
+* e.g. for AddressSanitizer. With MSVC the debug CRT allocation hook is
+* used, release builds can't count.
+*/
+#ifndef SPLPALLOC_H
+#define SPLPALLOC_H
+
+#include <stdlib.h>
+
+#if defined( __GLIBC__ )
+#if defined( SPLP_ALLOC_CHECK )
+#define SPLP_ALLOC_INTERPOSE
+#endif
+#elif defined( _MSC_VER ) && defined( _DEBUG )
+#define SPLP_ALLOC_CRT_HOOK
+#endif
+
+
+
+
+typedef struct _SPLP_ALLOC_COUNT
+{
+    unsigned long long allocs;      /* malloc( ), calloc( ) and aligned */
+    unsigned long long reallocs;
+    unsigned long long frees;
+
+}SPLP_ALLOC_COUNT, *PSPLP_ALLOC_COUNT;
+
+
+
+
+/* SplpAllocSupported
+* Returns nonzero if allocations can be counted in this build.
+*/
+int SplpAllocSupported( void );
+
+
+
+
+void SplpAllocWatchStart( void );
+
+
+
+
+void SplpAllocWatchStop(
+    PSPLP_ALLOC_COUNT pCount );
+
+
+
+
+static __inline unsigned long long SplpAllocTotal(
+    const SPLP_ALLOC_COUNT* pCount )
+{
+    return pCount->allocs + pCount->reallocs + pCount->frees;
+}
+
+#endif /* SPLPALLOC_H */
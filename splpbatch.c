@@ -0,0 +1,70 @@
+/*
+* SPLPBATCH.c
+* The file is part of practical task for System programming course.
+* This file contains the adaptive batch size controller. Validating a
+* batch amortizes the queue synchronization and the time stamps over
+* its messages, but every message of a batch waits for the whole batch.
+*/
+#include <string.h>
+#include "splpbatch.h"
+
+
+
+void SplpBatchInit(
+    PSPLP_BATCH_CONTROL pControl,
+    unsigned long long sloTicks )
+{
+    memset( pControl, 0, sizeof( *pControl ) );
+    pControl->size = 1;
+    pControl->limit = SPLP_BATCH_MAX_SIZE;
+    pControl->sloTicks = sloTicks;
+}
+
+
+
+
+unsigned int SplpBatchSize(
+    PSPLP_BATCH_CONTROL pControl,
+    unsigned int depth )
+{
+    if ( depth > pControl->size && pControl->size * 2 <= pControl->limit )
+    {
+        pControl->size *= 2;
+        pControl->grows++;
+    }
+    else if ( pControl->size > 1 && ( depth < pControl->size / 2 || pControl->size > pControl->limit ) )
+    {
+        pControl->size /= 2;
+        pControl->shrinks++;
+    }
+
+    if ( pControl->size > pControl->largest )
+        pControl->largest = pControl->size;
+    return depth < pControl->size ? depth : pControl->size;
+}
+
+
+
+
+void SplpBatchDone(
+    PSPLP_BATCH_CONTROL pControl,
+    unsigned int count,
+    unsigned long long ticks )
+{
+    double limit;
+
+    if ( count == 0 )
+        return;
+
+    pControl->batches++;
+    pControl->messages += count;
+
+    /* 1/8 weight, the first batch sets the average */
+    if ( pControl->messageTicks == 0 )
+        pControl->messageTicks = (double) ticks / count;
+    else
+        pControl->messageTicks += ( (double) ticks / count - pControl->messageTicks ) / 8;
+
+    limit = pControl->sloTicks / 2 / ( pControl->messageTicks > 1 ? pControl->messageTicks : 1 );
+    pControl->limit = limit < 1 ? 1 : limit > SPLP_BATCH_MAX_SIZE ? SPLP_BATCH_MAX_SIZE : (unsigned int) limit;
+}
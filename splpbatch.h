@@ -0,0 +1,71 @@
+/*
+* SPLPBATCH.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the adaptive batch size controller
+* of a validator thread which takes messages from a queue.
+*/
+#ifndef SPLPBATCH_H
+#define SPLPBATCH_H
+
+#include "splptest.h"
+
+
+
+#define SPLP_BATCH_MAX_SIZE       256     /* messages, power of 2 */
+#define DEFAULT_BATCH_SLO_USEC    100
+
+
+
+
+/* SPLP_BATCH_CONTROL
+* The batch size doubles while the queue holds more than a batch and
+* halves, down to 1, while it holds less than half of one. Either way
+* the batch takes at most half of the latency SLO to validate, at the
+* measured cost of a message, so the other half is left for queueing.
+*/
+typedef struct _SPLP_BATCH_CONTROL
+{
+    unsigned int       size;
+    unsigned int       limit;          /* largest size within the SLO */
+    unsigned long long sloTicks;
+    double             messageTicks;   /* moving average cost of a message */
+
+    /* decisions, for the report */
+    unsigned long long batches;
+    unsigned long long messages;
+    unsigned long long grows;
+    unsigned long long shrinks;
+    unsigned int       largest;
+
+}SPLP_BATCH_CONTROL, *PSPLP_BATCH_CONTROL;
+
+
+
+
+void SplpBatchInit(
+    PSPLP_BATCH_CONTROL pControl,
+    unsigned long long sloTicks );
+
+
+
+
+/* SplpBatchSize
+* Size of the next batch for depth queued messages, never more than
+* depth.
+*/
+unsigned int SplpBatchSize(
+    PSPLP_BATCH_CONTROL pControl,
+    unsigned int depth );
+
+
+
+
+/* SplpBatchDone
+* Feeds back the cost of a batch of count messages.
+*/
+void SplpBatchDone(
+    PSPLP_BATCH_CONTROL pControl,
+    unsigned int count,
+    unsigned long long ticks );
+
+#endif /* SPLPBATCH_H */
@@ -0,0 +1,445 @@
+/*
+* SPLPBENCH.c
+* The file is part of practical task for System programming course.
+* This file contains the micro benchmarks of validate_message( ), one
+* per state transition, payload size and family of invalid messages.
+*/
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "splpbench.h"
+#include "splplog.h"
+
+
+
+#define SPLP_BENCH_CAPACITY       64
+#define SPLP_BENCH_INVALID_SIZE   4096    /* payload size of invalid payload benchmarks */
+
+
+
+
+static const unsigned int SplpBenchPayloadSizes[ ] =
+{
+    1, 16, 256, 4096, 65536, 1048576
+};
+
+
+
+
+double SplpTscTicksPerSecond( void )
+{
+    static double ticksPerSecond = 0;
+    unsigned long long tscStart;
+    clock_t start;
+
+    if ( ticksPerSecond == 0 )
+    {
+        start = clock( );
+        while ( clock( ) == start )
+            ;
+        start = clock( );
+        tscStart = SplpReadTsc( );
+        while ( clock( ) - start < CLOCKS_PER_SEC / 10 )
+            ;
+        ticksPerSecond = (double) ( SplpReadTsc( ) - tscStart ) * CLOCKS_PER_SEC / (double) ( clock( ) - start );
+    }
+    return ticksPerSecond;
+}
+
+
+
+
+/* SplpBenchAdd
+* Adds a scenario, text is owned by the suite afterwards.
+*/
+static SPLP_STATUS SplpBenchAdd(
+    PSPLP_BENCH pBench,
+    const char* name,
+    enum State state,
+    enum Direction direction,
+    enum test_status expected,
+    char* text )
+{
+    PSPLP_BENCH_SCENARIO pScenario;
+
+    if ( !text || pBench->count == pBench->capacity )
+    {
+        free( text );
+        return SPLP_STATUS_ERROR;
+    }
+
+    pScenario = &pBench->pScenarios[ pBench->count++ ];
+    strncpy( pScenario->name, name, SPLP_BENCH_NAME_SIZE - 1 );
+    pScenario->state = state;
+    pScenario->expected = expected;
+    pScenario->msg.direction = direction;
+    pScenario->msg.text_message = text;
+    pScenario->length = (unsigned int) strlen( text );
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+static char* SplpBenchCopy(
+    const char* text )
+{
+    char* copy = (char*) malloc( strlen( text ) + 1 );
+    if ( copy )
+        strcpy( copy, text );
+    return copy;
+}
+
+
+
+
+/* SplpBenchMakeData
+* Builds "cmd data cmd" with size payload bytes. If bad is set the last
+* payload byte is replaced by a character outside of the allowed set.
+*/
+static char* SplpBenchMakeData(
+    const char* cmd,
+    unsigned int size,
+    int bad )
+{
+    static const char alphabet[ ] = "abcdefghijklmnopqrstuvwxyz0123456789.";
+    size_t cmdLength = strlen( cmd );
+    char* text = (char*) malloc( 2 * cmdLength + size + 3 );
+    unsigned int i;
+
+    if ( !text )
+        return NULL;
+
+    memcpy( text, cmd, cmdLength );
+    text[ cmdLength ] = ' ';
+    for ( i = 0; i < size; i++ )
+        text[ cmdLength + 1 + i ] = alphabet[ i % ( sizeof( alphabet ) - 1 ) ];
+    if ( bad && size )
+        text[ cmdLength + size ] = 'A';
+    text[ cmdLength + 1 + size ] = ' ';
+    memcpy( text + cmdLength + 2 + size, cmd, cmdLength + 1 );
+    return text;
+}
+
+
+
+
+/* SplpBenchMakeB64
+* Builds "B64: data" with size base64 characters, the last one is a
+* '=' pad. If bad is set a character outside of base64 is put near the
+* end.
+*/
+static char* SplpBenchMakeB64(
+    unsigned int size,
+    int bad )
+{
+    static const char alphabet[ ] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char* text = (char*) malloc( size + 6 );
+    unsigned int i;
+
+    if ( !text )
+        return NULL;
+
+    memcpy( text, "B64: ", 5 );
+    for ( i = 0; i < size; i++ )
+        text[ 5 + i ] = alphabet[ i % ( sizeof( alphabet ) - 1 ) ];
+    if ( size >= 4 )
+        text[ 5 + size - 1 ] = '=';
+    if ( bad && size >= 4 )
+        text[ 5 + size - 4 ] = '!';
+    text[ 5 + size ] = 0;
+    return text;
+}
+
+
+
+
+SPLP_STATUS SplpBenchInit(
+    PSPLP_BENCH pBench )
+{
+    static const struct
+    {
+        const char*      name;
+        enum State       state;
+        enum Direction   direction;
+        enum test_status expected;
+        const char*      text;
+    } fixed[ ] =
+    {
+        { "connect",                 INIT,             A_TO_B, MESSAGE_VALID,   "CONNECT" },
+        { "connect_ok",              CONNECTING,       B_TO_A, MESSAGE_VALID,   "CONNECT_OK" },
+        { "get_ver",                 CONNECTED,        A_TO_B, MESSAGE_VALID,   "GET_VER" },
+        { "get_data",                CONNECTED,        A_TO_B, MESSAGE_VALID,   "GET_DATA" },
+        { "get_file",                CONNECTED,        A_TO_B, MESSAGE_VALID,   "GET_FILE" },
+        { "get_command",             CONNECTED,        A_TO_B, MESSAGE_VALID,   "GET_COMMAND" },
+        { "get_b64",                 CONNECTED,        A_TO_B, MESSAGE_VALID,   "GET_B64" },
+        { "disconnect",              CONNECTED,        A_TO_B, MESSAGE_VALID,   "DISCONNECT" },
+        { "disconnect_ok",           DISCONNECTING,    B_TO_A, MESSAGE_VALID,   "DISCONNECT_OK" },
+        { "version",                 WAITING_VER,      B_TO_A, MESSAGE_VALID,   "VERSION 2" },
+        { "version/long",            WAITING_VER,      B_TO_A, MESSAGE_VALID,   "VERSION 1234567890" },
+        { "invalid/direction",       INIT,             B_TO_A, MESSAGE_INVALID, "CONNECT" },
+        { "invalid/unexpected",      CONNECTED,        A_TO_B, MESSAGE_INVALID, "GET_VERSION" },
+        { "invalid/near_miss",       CONNECTING,       B_TO_A, MESSAGE_INVALID, "CONNECT_OX" },
+        { "invalid/out_of_state",    WAITING_VER,      B_TO_A, MESSAGE_INVALID, "CONNECT_OK" },
+        { "invalid/version_char",    WAITING_VER,      B_TO_A, MESSAGE_INVALID, "VERSION 2a" },
+        { "invalid/version_space",   WAITING_VER,      B_TO_A, MESSAGE_INVALID, "VERSION  2" },
+        { "invalid/data_suffix",     WAITING_DATA,     B_TO_A, MESSAGE_INVALID, "GET_DATA abc GET_FILE" },
+        { "invalid/b64_prefix",      WAITING_B64_DATA, B_TO_A, MESSAGE_INVALID, "B65: SGVsbG8=" },
+    };
+    char name[ SPLP_BENCH_NAME_SIZE ];
+    SPLP_STATUS status = SPLP_STATUS_OK;
+    unsigned int i;
+
+    memset( pBench, 0, sizeof( *pBench ) );
+    pBench->capacity = SPLP_BENCH_CAPACITY;
+    pBench->pScenarios = (PSPLP_BENCH_SCENARIO) calloc( pBench->capacity, sizeof( SPLP_BENCH_SCENARIO ) );
+    pBench->pResults = (PSPLP_BENCH_RESULT) calloc( pBench->capacity, sizeof( SPLP_BENCH_RESULT ) );
+    if ( !pBench->pScenarios || !pBench->pResults )
+        return SPLP_STATUS_ERROR;
+
+    for ( i = 0; i < sizeof( fixed ) / sizeof( fixed[ 0 ] ) && status == SPLP_STATUS_OK; i++ )
+    {
+        status = SplpBenchAdd( pBench, fixed[ i ].name, fixed[ i ].state, fixed[ i ].direction,
+            fixed[ i ].expected, SplpBenchCopy( fixed[ i ].text ) );
+    }
+
+    /* the control messages of the states with one legal message, through validate_session_batch( ) */
+    for ( i = 0; i < 2 && status == SPLP_STATUS_OK; i++ )
+    {
+        sprintf( name, "batch/%s", fixed[ i ].name );
+        status = SplpBenchAdd( pBench, name, fixed[ i ].state, fixed[ i ].direction,
+            fixed[ i ].expected, SplpBenchCopy( fixed[ i ].text ) );
+        if ( status == SPLP_STATUS_OK )
+            pBench->pScenarios[ pBench->count - 1 ].batch = 1;
+    }
+    if ( status == SPLP_STATUS_OK )
+        status = SplpBenchAdd( pBench, "batch/disconnect_ok", DISCONNECTING, B_TO_A, MESSAGE_VALID,
+            SplpBenchCopy( "DISCONNECT_OK" ) );
+    if ( status == SPLP_STATUS_OK )
+        pBench->pScenarios[ pBench->count - 1 ].batch = 1;
+
+    for ( i = 0; i < sizeof( SplpBenchPayloadSizes ) / sizeof( SplpBenchPayloadSizes[ 0 ] ) && status == SPLP_STATUS_OK; i++ )
+    {
+        unsigned int size = SplpBenchPayloadSizes[ i ];
+
+        sprintf( name, "data/%u", size );
+        status = SplpBenchAdd( pBench, name, WAITING_DATA, B_TO_A, MESSAGE_VALID,
+            SplpBenchMakeData( "GET_DATA", size, 0 ) );
+
+        /* base64 needs a multiple of 4 characters */
+        sprintf( name, "b64/%u", size );
+        if ( status == SPLP_STATUS_OK )
+            status = SplpBenchAdd( pBench, name, WAITING_B64_DATA, B_TO_A, MESSAGE_VALID,
+                SplpBenchMakeB64( ( size + 3 ) & ~3u, 0 ) );
+    }
+
+    if ( status == SPLP_STATUS_OK )
+        status = SplpBenchAdd( pBench, "data/command/4096", WAITING_DATA, B_TO_A, MESSAGE_VALID,
+            SplpBenchMakeData( "GET_COMMAND", SPLP_BENCH_INVALID_SIZE, 0 ) );
+    if ( status == SPLP_STATUS_OK )
+        status = SplpBenchAdd( pBench, "invalid/data_char", WAITING_DATA, B_TO_A, MESSAGE_INVALID,
+            SplpBenchMakeData( "GET_DATA", SPLP_BENCH_INVALID_SIZE, 1 ) );
+    if ( status == SPLP_STATUS_OK )
+        status = SplpBenchAdd( pBench, "invalid/b64_char", WAITING_B64_DATA, B_TO_A, MESSAGE_INVALID,
+            SplpBenchMakeB64( SPLP_BENCH_INVALID_SIZE, 1 ) );
+    if ( status == SPLP_STATUS_OK )
+        status = SplpBenchAdd( pBench, "invalid/b64_length", WAITING_B64_DATA, B_TO_A, MESSAGE_INVALID,
+            SplpBenchMakeB64( SPLP_BENCH_INVALID_SIZE - 2, 0 ) );
+
+    return status;
+}
+
+
+
+
+/* SplpBenchSampleBatch
+* Validates iterations messages SPLP_BENCH_BATCH at a time, one per
+* session. The sessions are put back into the scenario state before
+* every batch, which is part of the time.
+*/
+static double SplpBenchSampleBatch(
+    const SPLP_BENCH_SCENARIO* pScenario,
+    unsigned int iterations )
+{
+    struct Session sessions[ SPLP_BENCH_BATCH ];
+    struct Session* pSessions[ SPLP_BENCH_BATCH ];
+    struct Message msg = pScenario->msg;
+    struct Message* pMessages[ SPLP_BENCH_BATCH ];
+    enum test_status results[ SPLP_BENCH_BATCH ];
+    unsigned long long begin;
+    unsigned int i;
+    unsigned int j;
+
+    for ( j = 0; j < SPLP_BENCH_BATCH; j++ )
+    {
+        pSessions[ j ] = &sessions[ j ];
+        pMessages[ j ] = &msg;
+        sessions[ j ].reason = REASON_NONE;
+    }
+
+    begin = SplpReadTsc( );
+    for ( i = 0; i < iterations; i += SPLP_BENCH_BATCH )
+    {
+        for ( j = 0; j < SPLP_BENCH_BATCH; j++ )
+            sessions[ j ].state = (unsigned char) pScenario->state;
+        validate_session_batch( pSessions, pMessages, results, SPLP_BENCH_BATCH );
+    }
+    return (double) ( SplpReadTsc( ) - begin );
+}
+
+
+
+
+static double SplpBenchSample(
+    const SPLP_BENCH_SCENARIO* pScenario,
+    unsigned int iterations )
+{
+    struct Message msg = pScenario->msg;
+    unsigned long long begin;
+    unsigned int i;
+
+    if ( pScenario->batch )
+        return SplpBenchSampleBatch( pScenario, iterations );
+
+    begin = SplpReadTsc( );
+    for ( i = 0; i < iterations; i++ )
+    {
+        set_state( pScenario->state );
+        validate_message( &msg );
+    }
+    return (double) ( SplpReadTsc( ) - begin );
+}
+
+
+
+
+static int SplpBenchCompareDouble(
+    const void* pLeft,
+    const void* pRight )
+{
+    double left = *(const double*) pLeft;
+    double right = *(const double*) pRight;
+    return left < right ? -1 : left > right ? 1 : 0;
+}
+
+
+
+
+SPLP_STATUS SplpBenchRun(
+    PSPLP_BENCH pBench,
+    const char* filter )
+{
+    double sampleTicks;
+    unsigned int i;
+    unsigned int sampleIdx;
+    unsigned int counter;
+
+    pBench->ticksPerSecond = SplpTscTicksPerSecond( );
+    pBench->started = time( NULL );
+    sampleTicks = pBench->ticksPerSecond * SPLP_BENCH_SAMPLE_SECONDS;
+    SplpPerfOpen( &pBench->perf );
+
+    for ( i = 0; i < pBench->count; i++ )
+    {
+        PSPLP_BENCH_SCENARIO pScenario = &pBench->pScenarios[ i ];
+        PSPLP_BENCH_RESULT pResult = &pBench->pResults[ i ];
+        double sorted[ SPLP_BENCH_SAMPLES ];
+        unsigned int iterations = pScenario->batch ? SPLP_BENCH_BATCH : 1;
+
+        pResult->pScenario = pScenario;
+        if ( filter && !strstr( pScenario->name, filter ) )
+            continue;
+
+        /* a benchmark of a wrong verdict measures the wrong path */
+        set_state( pScenario->state );
+        if ( validate_message( &pScenario->msg ) != pScenario->expected )
+        {
+            printf( "***ERROR*** Benchmark \"%s\" returned %s\n", pScenario->name,
+                pScenario->expected == MESSAGE_VALID ? "MESSAGE_INVALID" : "MESSAGE_VALID" );
+            SplpPerfClose( &pBench->perf );
+            return SPLP_STATUS_ERROR;
+        }
+
+        while ( SplpBenchSample( pScenario, iterations ) < sampleTicks && iterations < 0x40000000 )
+            iterations *= 2;
+
+        SplpPerfStart( &pBench->perf );
+        for ( sampleIdx = 0; sampleIdx < SPLP_BENCH_SAMPLES; sampleIdx++ )
+        {
+            pResult->samples[ sampleIdx ] =
+                SplpBenchSample( pScenario, iterations ) * 1e9 / pBench->ticksPerSecond / iterations;
+            sorted[ sampleIdx ] = pResult->samples[ sampleIdx ];
+        }
+        SplpPerfStop( &pBench->perf );
+
+        for ( counter = 0; counter < SPLP_PERF_COUNTER_COUNT; counter++ )
+        {
+            pResult->counters[ counter ] = SplpPerfAvailable( &pBench->perf, (SPLP_PERF_COUNTER) counter ) ?
+                (double) pBench->perf.value[ counter ] / ( (double) iterations * SPLP_BENCH_SAMPLES ) : -1;
+        }
+
+        qsort( sorted, SPLP_BENCH_SAMPLES, sizeof( sorted[ 0 ] ), SplpBenchCompareDouble );
+        pResult->iterations = iterations;
+        pResult->median = sorted[ SPLP_BENCH_SAMPLES / 2 ];
+        pResult->bytesPerSecond = pResult->median > 0 ? pScenario->length * 1e9 / pResult->median : 0;
+    }
+
+    reset_state( );
+    SplpPerfClose( &pBench->perf );
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+void SplpBenchPrint(
+    PSPLP_BENCH pBench )
+{
+    unsigned int i;
+
+    printf(
+        "======================================================================\n"
+        " MICRO BENCHMARKS:\n"
+        "======================================================================\n"
+        "\tTSC frequency:    \t%14.0f Hz\n"
+        "\tSamples:          \t%14u\n\n",
+        pBench->ticksPerSecond,
+        SPLP_BENCH_SAMPLES );
+
+    printf( "\t%-22s %-17s %9s %12s %12s\n", "Benchmark", "State", "Bytes", "ns/op", "MB/s" );
+    for ( i = 0; i < pBench->count; i++ )
+    {
+        PSPLP_BENCH_RESULT pResult = &pBench->pResults[ i ];
+        if ( pResult->iterations == 0 )
+            continue;
+        printf( "\t%-22s %-17s %9u %12.2f %12.2f\n",
+            pResult->pScenario->name,
+            SplpLogStateName( pResult->pScenario->state ),
+            pResult->pScenario->length,
+            pResult->median,
+            pResult->bytesPerSecond / 1024.0 / 1024.0 );
+    }
+
+    printf( "======================================================================\n" );
+}
+
+
+
+
+void SplpBenchFree(
+    PSPLP_BENCH pBench )
+{
+    unsigned int i;
+
+    if ( pBench->pScenarios )
+    {
+        for ( i = 0; i < pBench->count; i++ )
+            free( pBench->pScenarios[ i ].msg.text_message );
+    }
+    free( pBench->pScenarios );
+    free( pBench->pResults );
+    memset( pBench, 0, sizeof( *pBench ) );
+}
@@ -0,0 +1,104 @@
+/*
+* SPLPBENCH.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the micro benchmarks. Every
+* benchmark times a single message class validated in a fixed state.
+*/
+#ifndef SPLPBENCH_H
+#define SPLPBENCH_H
+
+#include <time.h>
+#include "splpv1.h"
+#include "splptest.h"
+#include "splpperf.h"
+
+
+
+#define SPLP_BENCH_SAMPLES        9       /* timed samples per benchmark */
+#define SPLP_BENCH_SAMPLE_SECONDS 0.005   /* minimal duration of a sample */
+#define SPLP_BENCH_NAME_SIZE      48
+#define SPLP_BENCH_BATCH          64      /* messages per validate_session_batch( ) call */
+
+
+
+
+/* SPLP_BENCH_SCENARIO
+* A message validated in a fixed state, with its expected verdict.
+*/
+typedef struct _SPLP_BENCH_SCENARIO
+{
+    char               name[ SPLP_BENCH_NAME_SIZE ];
+    enum State         state;
+    enum test_status   expected;
+    struct Message     msg;
+    unsigned int       length;
+    int                batch;          /* validated SPLP_BENCH_BATCH at a time */
+
+}SPLP_BENCH_SCENARIO, *PSPLP_BENCH_SCENARIO;
+
+
+
+
+/* SPLP_BENCH_RESULT
+* Timing of one scenario. Samples are ns per message.
+*/
+typedef struct _SPLP_BENCH_RESULT
+{
+    const SPLP_BENCH_SCENARIO* pScenario;
+    unsigned int       iterations;     /* messages per sample */
+    double             samples[ SPLP_BENCH_SAMPLES ];
+    double             median;         /* ns per message */
+    double             bytesPerSecond;
+    double             counters[ SPLP_PERF_COUNTER_COUNT ];    /* per message, < 0 if unavailable */
+
+}SPLP_BENCH_RESULT, *PSPLP_BENCH_RESULT;
+
+
+
+
+/* SPLP_BENCH
+* The benchmark suite with its results.
+*/
+typedef struct _SPLP_BENCH
+{
+    PSPLP_BENCH_SCENARIO pScenarios;
+    PSPLP_BENCH_RESULT   pResults;
+    unsigned int         count;
+    unsigned int         capacity;
+    double               ticksPerSecond;
+    time_t               started;        /* of the run, to check that runs interleave */
+    SPLP_PERF            perf;
+
+}SPLP_BENCH, *PSPLP_BENCH;
+
+
+
+
+SPLP_STATUS SplpBenchInit(
+    PSPLP_BENCH pBench );
+
+
+
+
+SPLP_STATUS SplpBenchRun(
+    PSPLP_BENCH pBench,
+    const char* filter );
+
+
+
+
+void SplpBenchPrint(
+    PSPLP_BENCH pBench );
+
+
+
+
+void SplpBenchFree(
+    PSPLP_BENCH pBench );
+
+
+
+
+double SplpTscTicksPerSecond( void );
+
+#endif /* SPLPBENCH_H */
@@ -0,0 +1,212 @@
+/*
+ * SPLPbranchless.c
+ * The file is part of practical task for System programming course.
+ * This file contains the branchless validator of SPLPv1 protocol.
+ *
+ * validate_message() decides with nested, data dependent branches and
+ * leaves as soon as the verdict is known, which mispredicts on mixed
+ * valid and invalid traffic. Here every check of every state is
+ * evaluated as a 0/1 value, every character check is reduced over its
+ * whole range without exit, and the outcome of the current state is
+ * selected at the end. The only branches left are the loops over the
+ * message bytes, whose trip counts depend on the length only, the
+ * strlen() before them, and the range check of the session state.
+ *
+ * Verdicts, reasons and transitions are those of the reference
+ * validator (SPLPREF.c), including bytes >= 0x80 and short base64
+ * payloads.
+ */
+
+#include "splpbranchless.h"
+#include "splpclass.h"
+#include <string.h>
+
+
+#define HEAD_SIZE	16		// longer than every keyword and its terminator
+
+enum keyword
+{
+	KW_CONNECT, KW_CONNECT_OK, KW_GET_VER, KW_GET_DATA, KW_GET_FILE, KW_GET_COMMAND,
+	KW_GET_B64, KW_DISCONNECT, KW_DISCONNECT_OK, KW_VERSION, KW_B64, KW_COUNT
+};
+
+// a message head or a keyword zero padded to HEAD_SIZE, compared as two words
+union head
+{
+	unsigned char		bytes[HEAD_SIZE];
+	unsigned long long	words[HEAD_SIZE / 8];
+};
+
+#define FF4		"\xff\xff\xff\xff"
+#define FF7		FF4 "\xff\xff\xff"
+#define FF8		FF4 FF4
+#define FF10	FF8 "\xff\xff"
+#define FF11	FF10 "\xff"
+#define FF13	FF11 "\xff\xff"
+
+// constant data, so concurrent validators share the tables without any
+// initialisation
+static const union head keyword_word[KW_COUNT] =
+{
+	{ "CONNECT" }, { "CONNECT_OK" }, { "GET_VER" }, { "GET_DATA" }, { "GET_FILE" }, { "GET_COMMAND" },
+	{ "GET_B64" }, { "DISCONNECT" }, { "DISCONNECT_OK" }, { "VERSION" }, { "B64:" }
+};
+
+// 0xff over the length of every keyword
+static const union head keyword_mask[KW_COUNT] =
+{
+	{ FF7 }, { FF10 }, { FF7 }, { FF8 }, { FF8 }, { FF11 },
+	{ FF7 }, { FF10 }, { FF13 }, { FF7 }, { FF4 }
+};
+
+
+// b if c is 0, a if c is 1
+static unsigned int pick(unsigned int c, unsigned int a, unsigned int b)
+{
+	return b ^ ((a ^ b) & (0u - c));
+}
+
+
+// 1 if the message starts with keyword k
+static unsigned int match(const unsigned long long* head, int k)
+{
+	return (((head[0] ^ keyword_word[k].words[0]) & keyword_mask[k].words[0]) |
+		((head[1] ^ keyword_word[k].words[1]) & keyword_mask[k].words[1])) == 0;
+}
+
+
+// 1 if the message is keyword k; head is zero padded, so the
+// terminator is compared too
+static unsigned int equals(const unsigned long long* head, int k)
+{
+	return ((head[0] ^ keyword_word[k].words[0]) | (head[1] ^ keyword_word[k].words[1])) == 0;
+}
+
+
+enum test_status validate_session_message_branchless(struct Session* session, struct Message* msg)
+{
+	const unsigned char* text = (const unsigned char*)msg->text_message;
+	unsigned long long head[HEAD_SIZE / 8] = { 0 };
+	const unsigned char* head_bytes = (const unsigned char*)head;
+	size_t length = strlen(msg->text_message);
+	size_t i;
+	unsigned int a_to_b = msg->direction == A_TO_B;
+	unsigned int b_to_a = msg->direction == B_TO_A;
+	unsigned int is_get_data, is_get_file, is_get_command, is_data_prefix;
+	unsigned int data_offset, command_length, command;
+	unsigned int seen_space, bad_data, bad_digit, bad_b64;
+	unsigned int data_bits, digit_bits, b64_bits;
+	size_t space;
+	unsigned long long suffix[HEAD_SIZE / 8] = { 0 };
+	size_t suffix_start, suffix_length;
+	unsigned int valid[DISCONNECTING + 1], reason[DISCONNECTING + 1], next[DISCONNECTING + 1];
+	unsigned int state = session->state;
+	unsigned int format, character, ok, last1, last2, last_ok;
+
+	// a session in no state is left alone, as by validate_session_message()
+	if (state > DISCONNECTING)
+		return MESSAGE_VALID;
+
+	memcpy(head, text, length < HEAD_SIZE ? length : HEAD_SIZE);
+
+	// which data command the message starts with decides where its payload starts
+	is_get_data = match(head, KW_GET_DATA);
+	is_get_file = match(head, KW_GET_FILE);
+	is_get_command = match(head, KW_GET_COMMAND);
+	is_data_prefix = is_get_data | is_get_file | is_get_command;
+	command = KW_GET_DATA + is_get_file + 2 * is_get_command;
+	command_length = pick(is_get_command, 11, 8);
+	data_offset = command_length + 1;
+
+	// the payload ends at its first space; scanning backwards leaves the
+	// lowest index, with a select as the only loop carried dependency
+	space = length;
+	for (i = length; i > data_offset; i--)
+		space = text[i - 1] == ' ' ? i - 1 : space;
+	seen_space = space != length;
+
+	// each class check is an AND over its range of bytes
+	data_bits = SPLP_CLASS_DATA;
+	for (i = data_offset; i < space; i++)
+		data_bits &= splp_char_class[text[i]];
+	digit_bits = SPLP_CLASS_DIGIT;
+	for (i = 8; i < length; i++)
+		digit_bits &= splp_char_class[text[i]];
+	b64_bits = SPLP_CLASS_B64;
+	for (i = 5; i + 2 < length; i++)
+		b64_bits &= splp_char_class[text[i]];
+	bad_data = data_bits == 0;
+	bad_digit = digit_bits == 0;
+	bad_b64 = b64_bits == 0;
+
+	// "CMD data CMD": the text after the first payload space is the command again
+	suffix_start = seen_space ? space + 1 : length;
+	suffix_length = length - suffix_start;
+	memcpy(suffix, text + suffix_start, suffix_length < HEAD_SIZE ? suffix_length : HEAD_SIZE);
+
+	// INIT
+	ok = equals(head, KW_CONNECT);
+	valid[INIT] = ok & a_to_b;
+	reason[INIT] = pick(ok, REASON_DIRECTION, REASON_UNEXPECTED);
+	next[INIT] = CONNECTING;
+
+	// CONNECTING
+	ok = equals(head, KW_CONNECT_OK);
+	valid[CONNECTING] = ok & b_to_a;
+	reason[CONNECTING] = pick(ok, REASON_DIRECTION, REASON_UNEXPECTED);
+	next[CONNECTING] = CONNECTED;
+
+	// CONNECTED, an unknown request keeps the state
+	{
+		unsigned int to_data = equals(head, KW_GET_DATA) | equals(head, KW_GET_FILE) | equals(head, KW_GET_COMMAND);
+		unsigned int to_disconnect = equals(head, KW_DISCONNECT);
+		unsigned int to_b64 = equals(head, KW_GET_B64);
+		unsigned int to_ver = equals(head, KW_GET_VER);
+		valid[CONNECTED] = a_to_b & (to_data | to_disconnect | to_b64 | to_ver);
+		reason[CONNECTED] = pick(a_to_b, REASON_UNEXPECTED, REASON_DIRECTION);
+		next[CONNECTED] = pick(to_data, WAITING_DATA, 0) | pick(to_disconnect, DISCONNECTING, 0) |
+			pick(to_b64, WAITING_B64_DATA, 0) | pick(to_ver, WAITING_VER, 0);
+	}
+
+	// WAITING_VER
+	ok = match(head, KW_VERSION);
+	format = head_bytes[7] != ' ';
+	valid[WAITING_VER] = b_to_a & ok & (format ^ 1) & (bad_digit ^ 1);
+	reason[WAITING_VER] = pick(b_to_a ^ 1, REASON_DIRECTION,
+		pick(ok ^ 1, REASON_UNEXPECTED, pick(format, REASON_FORMAT, REASON_CHARACTER)));
+	next[WAITING_VER] = CONNECTED;
+
+	// WAITING_DATA, an unknown response is accepted and keeps the state
+	format = head_bytes[command_length] != ' ';
+	valid[WAITING_DATA] = b_to_a & ((is_data_prefix ^ 1) | ((format | bad_data | (seen_space ^ 1) | (equals(suffix, command) ^ 1)) ^ 1));
+	reason[WAITING_DATA] = pick(b_to_a ^ 1, REASON_DIRECTION,
+		pick(format, REASON_FORMAT, pick(bad_data, REASON_CHARACTER, REASON_FORMAT)));
+	next[WAITING_DATA] = pick(is_data_prefix, CONNECTED, WAITING_DATA);
+
+	// WAITING_B64_DATA
+	ok = match(head, KW_B64);
+	format = head_bytes[4] != ' ';
+	last1 = text[length >= 2 ? length - 2 : 0];
+	last2 = text[length >= 1 ? length - 1 : 0];
+	last_ok = (((splp_char_class[last1] & SPLP_CLASS_B64) != 0) & ((splp_char_class[last2] & SPLP_CLASS_B64_PAD) != 0)) |
+		((last1 == '=') & (last2 == '='));
+	character = (length < 7) | bad_b64 | (last_ok ^ 1);
+	valid[WAITING_B64_DATA] = b_to_a & ok & (format ^ 1) & (character ^ 1) & ((length - 5) % 4 == 0);
+	reason[WAITING_B64_DATA] = pick(b_to_a ^ 1, REASON_DIRECTION,
+		pick(ok ^ 1, REASON_UNEXPECTED, pick(format, REASON_FORMAT, pick(character, REASON_CHARACTER, REASON_LENGTH))));
+	next[WAITING_B64_DATA] = CONNECTED;
+
+	// DISCONNECTING
+	ok = equals(head, KW_DISCONNECT_OK);
+	valid[DISCONNECTING] = ok & b_to_a;
+	reason[DISCONNECTING] = pick(ok, REASON_DIRECTION, REASON_UNEXPECTED);
+	next[DISCONNECTING] = INIT;
+
+	// rejects go back to INIT, except an unknown request in CONNECTED
+	ok = valid[state];
+	session->state = (unsigned char)pick(ok, next[state],
+		pick((state == CONNECTED) & a_to_b, CONNECTED, INIT));
+	session->reason = (unsigned char)pick(ok, session->reason, reason[state]);
+
+	return (enum test_status)pick(ok, MESSAGE_VALID, MESSAGE_INVALID);
+}
@@ -0,0 +1,15 @@
+/*
+ * SPLPBRANCHLESS.h
+ * The file is part of practical task for System programming course.
+ * This file contains declaration of the branchless SPLPv1 validator.
+ */
+#ifndef SPLPBRANCHLESS_H
+#define SPLPBRANCHLESS_H
+
+#include "splpv1.h"
+
+/* Same verdicts, reasons and transitions as validate_session_message(),
+ * computed with masks over the whole message instead of early exits */
+extern enum test_status validate_session_message_branchless( struct Session* pSession, struct Message* pMessage );
+
+#endif /* SPLPBRANCHLESS_H */
@@ -0,0 +1,453 @@
+/*
+* SPLPCAP.c
+* The file is part of practical task for System programming course.
+* This file contains the reject capture: rate limited recording of
+* rejected messages into rotating ring files and their export into
+* the test file format.
+*/
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "splpcap.h"
+
+
+
+
+/* SPLP_CAPTURE_STEP
+* A canonical message used to drive the validator into the state a
+* captured message was rejected in.
+*/
+typedef struct _SPLP_CAPTURE_STEP
+{
+    const char*    text;
+    enum Direction direction;
+
+}SPLP_CAPTURE_STEP;
+
+
+
+
+static const SPLP_CAPTURE_STEP SplpCaptureHandshake[ ] =
+{
+    { "CONNECT",    A_TO_B },
+    { "CONNECT_OK", B_TO_A }
+};
+
+
+
+
+/* Request which moves CONNECTED into the given state. validate_message( )
+* doesn't distinguish the GET_* request which opened WAITING_DATA, so
+* GET_DATA stands for all of them.
+*/
+static const SPLP_CAPTURE_STEP SplpCaptureRequest[ ] =
+{
+    { NULL,         A_TO_B },   /* INIT */
+    { NULL,         A_TO_B },   /* CONNECTING */
+    { NULL,         A_TO_B },   /* CONNECTED */
+    { "GET_VER",    A_TO_B },   /* WAITING_VER */
+    { "GET_DATA",   A_TO_B },   /* WAITING_DATA */
+    { "GET_B64",    A_TO_B },   /* WAITING_B64_DATA */
+    { "DISCONNECT", A_TO_B }    /* DISCONNECTING */
+};
+
+
+
+
+static const SPLP_CAPTURE_STEP SplpCaptureTeardown[ ] =
+{
+    { "DISCONNECT",    A_TO_B },
+    { "DISCONNECT_OK", B_TO_A }
+};
+
+
+
+
+static void SplpCaptureFileName(
+    char* buffer,
+    const char* prefix,
+    unsigned int fileIdx )
+{
+    snprintf( buffer, SPLP_CAPTURE_NAME_SIZE + 16, "%s.%u.cap", prefix, fileIdx );
+}
+
+
+
+
+static SPLP_STATUS SplpCaptureWriteHeader(
+    PSPLP_CAPTURE pCapture )
+{
+    if ( 0 != fseek( pCapture->fOutput, 0, SEEK_SET ) ||
+        1 != fwrite( &pCapture->header, sizeof( pCapture->header ), 1, pCapture->fOutput ) )
+    {
+        return SPLP_STATUS_ERROR;
+    }
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+/* SplpCaptureSelectFile
+* Makes fileIdx the current ring file and marks it empty. The oldest
+* captures are overwritten this way once all files were used. The
+* header of the file left behind is completed first.
+*/
+static SPLP_STATUS SplpCaptureSelectFile(
+    PSPLP_CAPTURE pCapture,
+    unsigned int fileIdx )
+{
+    SPLP_STATUS status = SPLP_STATUS_OK;
+
+    if ( pCapture->fOutput )
+    {
+        status = SplpCaptureWriteHeader( pCapture );
+    }
+
+    pCapture->fOutput = pCapture->pFiles[ fileIdx ];
+    pCapture->fileIdx = fileIdx;
+    pCapture->header.recordCount = 0;
+    pCapture->header.firstSequence = pCapture->sequence;
+
+    if ( SPLP_STATUS_OK != SplpCaptureWriteHeader( pCapture ) )
+        status = SPLP_STATUS_ERROR;
+
+    return status;
+}
+
+
+
+
+static void SplpCaptureCloseFiles(
+    PSPLP_CAPTURE pCapture,
+    SPLP_STATUS* pStatus )
+{
+    unsigned int fileIdx;
+
+    for ( fileIdx = 0; fileIdx < pCapture->fileCount; fileIdx++ )
+    {
+        if ( pCapture->pFiles[ fileIdx ] && 0 != fclose( pCapture->pFiles[ fileIdx ] ) )
+            *pStatus = SPLP_STATUS_ERROR;
+    }
+
+    free( pCapture->pFiles );
+    pCapture->pFiles = NULL;
+    pCapture->fOutput = NULL;
+}
+
+
+
+
+SPLP_STATUS SplpCaptureOpen(
+    PSPLP_CAPTURE pCapture,
+    const char* prefix,
+    unsigned int fileCount,
+    unsigned int slotCount,
+    unsigned int sampleRate,
+    unsigned int ratePerSecond )
+{
+    char fileName[ SPLP_CAPTURE_NAME_SIZE + 16 ];
+    unsigned int fileIdx;
+    SPLP_STATUS status = SPLP_STATUS_OK;
+
+    memset( pCapture, 0, sizeof( *pCapture ) );
+    if ( strlen( prefix ) >= SPLP_CAPTURE_NAME_SIZE )
+        return SPLP_STATUS_ERROR;
+
+    strcpy( pCapture->prefix, prefix );
+    pCapture->fileCount = fileCount ? fileCount : DEFAULT_CAPTURE_FILES;
+    pCapture->slotCount = slotCount ? slotCount : DEFAULT_CAPTURE_SLOTS;
+    pCapture->sampleRate = sampleRate ? sampleRate : 1;
+    pCapture->ratePerSecond = ratePerSecond ? ratePerSecond : DEFAULT_CAPTURE_RATE;
+    pCapture->tokens = pCapture->ratePerSecond;
+    pCapture->lastRefill = clock( );
+    pCapture->sequence = 1;
+
+    memcpy( pCapture->header.magic, SPLP_CAPTURE_MAGIC, sizeof( pCapture->header.magic ) );
+    pCapture->header.slotSize = SPLP_CAPTURE_SLOT_SIZE;
+    pCapture->header.slotCount = pCapture->slotCount;
+
+    pCapture->pFiles = (FILE**) calloc( pCapture->fileCount, sizeof( FILE* ) );
+    if ( !pCapture->pFiles )
+        return SPLP_STATUS_ERROR;
+
+    /* pre-allocate and open every ring file, nothing is opened or grows
+    * while capturing; the header write also makes the stream allocate
+    * its buffer here instead of in the timed loop
+    */
+    for ( fileIdx = 0; fileIdx < pCapture->fileCount; fileIdx++ )
+    {
+        FILE* fRing;
+        long long ringSize = (long long) ( pCapture->slotCount + 1 ) * SPLP_CAPTURE_SLOT_SIZE;
+
+        SplpCaptureFileName( fileName, prefix, fileIdx );
+        fRing = fopen( fileName, "w+b" );
+        pCapture->pFiles[ fileIdx ] = fRing;
+        if ( !fRing ||
+            1 != fwrite( &pCapture->header, sizeof( pCapture->header ), 1, fRing ) ||
+            0 != fseek( fRing, (long) ( ringSize - 1 ), SEEK_SET ) ||
+            EOF == fputc( 0, fRing ) ||
+            0 != fflush( fRing ) )
+        {
+            printf( "***ERROR*** Capture file \"%s\" can't be created\n", fileName );
+            SplpCaptureCloseFiles( pCapture, &status );
+            return SPLP_STATUS_ERROR;
+        }
+    }
+
+    if ( SPLP_STATUS_OK != SplpCaptureSelectFile( pCapture, 0 ) )
+    {
+        SplpCaptureCloseFiles( pCapture, &status );
+        return SPLP_STATUS_ERROR;
+    }
+
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+void SplpCaptureReject(
+    PSPLP_CAPTURE pCapture,
+    const struct Message* pMsg,
+    unsigned int length,
+    enum State state )
+{
+    SPLP_CAPTURE_RECORD_HEADER record;
+
+    if ( !pCapture->fOutput || ++pCapture->sampleCounter < pCapture->sampleRate )
+        return;
+    pCapture->sampleCounter = 0;
+
+    /* a cut text wouldn't be rejected for the same reason on export, such
+    * messages are counted instead; one byte is left for the terminator
+    */
+    if ( length >= SPLP_CAPTURE_TEXT_SIZE )
+    {
+        pCapture->oversized++;
+        return;
+    }
+
+    /* token bucket, clock( ) is only consulted once the bucket is empty */
+    if ( pCapture->tokens == 0 )
+    {
+        clock_t now = clock( );
+        unsigned long long refill = (unsigned long long) ( now - pCapture->lastRefill ) *
+            pCapture->ratePerSecond / CLOCKS_PER_SEC;
+
+        if ( refill == 0 )
+        {
+            pCapture->dropped++;
+            return;
+        }
+        pCapture->tokens = refill < pCapture->ratePerSecond ? (unsigned int) refill : pCapture->ratePerSecond;
+        pCapture->lastRefill = now;
+    }
+    pCapture->tokens--;
+
+    if ( pCapture->header.recordCount == pCapture->slotCount &&
+        SPLP_STATUS_OK != SplpCaptureSelectFile( pCapture, ( pCapture->fileIdx + 1 ) % pCapture->fileCount ) )
+    {
+        return;
+    }
+
+    record.sequence = pCapture->sequence++;
+    record.timestamp = SplpReadTsc( );
+    record.length = length;
+    record.state = (unsigned char) state;
+    record.stateAfter = (unsigned char) get_state( );
+    record.reason = (unsigned char) get_reason( );
+    record.direction = (unsigned char) pMsg->direction;
+
+    if ( 0 != fseek( pCapture->fOutput,
+            (long) ( pCapture->header.recordCount + 1 ) * SPLP_CAPTURE_SLOT_SIZE, SEEK_SET ) ||
+        1 != fwrite( &record, sizeof( record ), 1, pCapture->fOutput ) ||
+        length != fwrite( pMsg->text_message, 1, length, pCapture->fOutput ) )
+    {
+        return;
+    }
+
+    pCapture->header.recordCount++;
+}
+
+
+
+
+SPLP_STATUS SplpCaptureClose(
+    PSPLP_CAPTURE pCapture )
+{
+    SPLP_STATUS status = SPLP_STATUS_OK;
+
+    if ( pCapture->fOutput && SPLP_STATUS_OK != SplpCaptureWriteHeader( pCapture ) )
+    {
+        status = SPLP_STATUS_ERROR;
+    }
+    if ( pCapture->pFiles )
+    {
+        SplpCaptureCloseFiles( pCapture, &status );
+    }
+
+    return status;
+}
+
+
+
+
+static void SplpCaptureWriteStep(
+    FILE* fOutput,
+    const SPLP_CAPTURE_STEP* pStep )
+{
+    fprintf( fOutput, "1\t%d\t%s\n", pStep->direction == B_TO_A ? 1 : 0, pStep->text );
+}
+
+
+
+
+/* SplpCaptureExportRecord
+* Writes the steps leading to the captured state, the rejected message
+* and the steps back to INIT. Returns the number of test lines, with
+* fOutput == NULL only counts them.
+*/
+static unsigned int SplpCaptureExportRecord(
+    FILE* fOutput,
+    const SPLP_CAPTURE_RECORD_HEADER* pRecord,
+    const char* text )
+{
+    unsigned int lines = 1;
+    unsigned int i;
+
+    if ( pRecord->state > DISCONNECTING )
+        return 0;
+
+    if ( pRecord->state != INIT )
+    {
+        for ( i = 0; i < sizeof( SplpCaptureHandshake ) / sizeof( SplpCaptureHandshake[ 0 ] ); i++ )
+        {
+            if ( pRecord->state == CONNECTING && i == 1 )
+                break;
+            if ( fOutput )
+                SplpCaptureWriteStep( fOutput, &SplpCaptureHandshake[ i ] );
+            lines++;
+        }
+    }
+
+    if ( SplpCaptureRequest[ pRecord->state ].text )
+    {
+        if ( fOutput )
+            SplpCaptureWriteStep( fOutput, &SplpCaptureRequest[ pRecord->state ] );
+        lines++;
+    }
+
+    /* the rejected message is expected to be invalid, flip it to 1 if
+    * it turns out to be a false positive
+    */
+    if ( fOutput )
+        fprintf( fOutput, "0\t%d\t%s\n", pRecord->direction == B_TO_A ? 1 : 0, text );
+
+    if ( pRecord->stateAfter == CONNECTED )
+    {
+        for ( i = 0; i < sizeof( SplpCaptureTeardown ) / sizeof( SplpCaptureTeardown[ 0 ] ); i++ )
+        {
+            if ( fOutput )
+                SplpCaptureWriteStep( fOutput, &SplpCaptureTeardown[ i ] );
+            lines++;
+        }
+    }
+
+    return lines;
+}
+
+
+
+
+/* SplpCaptureReadRecord
+* Reads a record and its text. Returns SPLP_STATUS_ERROR for records
+* which can't be represented in the test file format.
+*/
+static SPLP_STATUS SplpCaptureReadRecord(
+    FILE* fInput,
+    unsigned int slotIdx,
+    PSPLP_CAPTURE_RECORD_HEADER pRecord,
+    char* text )
+{
+    if ( 0 != fseek( fInput, (long) ( slotIdx + 1 ) * SPLP_CAPTURE_SLOT_SIZE, SEEK_SET ) ||
+        1 != fread( pRecord, sizeof( *pRecord ), 1, fInput ) ||
+        pRecord->length >= SPLP_CAPTURE_TEXT_SIZE ||
+        pRecord->length != fread( text, 1, pRecord->length, fInput ) )
+    {
+        return SPLP_STATUS_ERROR;
+    }
+
+    text[ pRecord->length ] = 0;
+    if ( strlen( text ) != pRecord->length || strpbrk( text, "\r\n" ) )
+        return SPLP_STATUS_ERROR;
+
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+SPLP_STATUS SplpCaptureExport(
+    const char* fileName,
+    FILE* fOutput )
+{
+    SPLP_CAPTURE_FILE_HEADER header;
+    SPLP_CAPTURE_RECORD_HEADER record;
+    unsigned int lineCount = 0;
+    unsigned int skipped = 0;
+    unsigned int slotIdx;
+    char* text;
+    FILE* fInput = fopen( fileName, "rb" );
+
+    if ( !fInput )
+    {
+        fprintf( stderr, "***ERROR*** Capture file \"%s\" can't be opened\n", fileName );
+        return SPLP_STATUS_ERROR;
+    }
+
+    if ( 1 != fread( &header, sizeof( header ), 1, fInput ) ||
+        0 != memcmp( header.magic, SPLP_CAPTURE_MAGIC, sizeof( header.magic ) ) ||
+        header.slotSize != SPLP_CAPTURE_SLOT_SIZE ||
+        header.recordCount > header.slotCount )
+    {
+        fprintf( stderr, "***ERROR*** File \"%s\" is not a capture file\n", fileName );
+        fclose( fInput );
+        return SPLP_STATUS_ERROR;
+    }
+
+    text = (char*) malloc( SPLP_CAPTURE_SLOT_SIZE );
+    if ( !text )
+    {
+        fclose( fInput );
+        return SPLP_STATUS_ERROR;
+    }
+
+    /* the test file starts with the message count, so count first */
+    for ( slotIdx = 0; slotIdx < header.recordCount; slotIdx++ )
+    {
+        if ( SPLP_STATUS_OK == SplpCaptureReadRecord( fInput, slotIdx, &record, text ) )
+            lineCount += SplpCaptureExportRecord( NULL, &record, text );
+        else
+            skipped++;
+    }
+
+    fprintf( fOutput, "%u\n", lineCount );
+    for ( slotIdx = 0; slotIdx < header.recordCount; slotIdx++ )
+    {
+        if ( SPLP_STATUS_OK == SplpCaptureReadRecord( fInput, slotIdx, &record, text ) )
+            SplpCaptureExportRecord( fOutput, &record, text );
+    }
+
+    if ( skipped )
+    {
+        fprintf( stderr, "***WARNING*** %u truncated or multi-line records of \"%s\" were skipped\n",
+            skipped, fileName );
+    }
+
+    free( text );
+    fclose( fInput );
+    return SPLP_STATUS_OK;
+}
@@ -0,0 +1,124 @@
+/*
+* SPLPCAP.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the reject capture. Sampled
+* rejected messages are stored in a set of rotating ring files which
+* can be exported back into the test file format.
+*/
+#ifndef SPLPCAP_H
+#define SPLPCAP_H
+
+#include <stdio.h>
+#include <time.h>
+#include "splpv1.h"
+#include "splptest.h"
+
+
+
+#define SPLP_CAPTURE_MAGIC          "SPLPCAP1"
+#define SPLP_CAPTURE_SLOT_SIZE      8192    /* bytes per record, fixed */
+#define SPLP_CAPTURE_TEXT_SIZE      ( SPLP_CAPTURE_SLOT_SIZE - sizeof( SPLP_CAPTURE_RECORD_HEADER ) )
+#define SPLP_CAPTURE_NAME_SIZE      512
+
+#define DEFAULT_CAPTURE_FILES       4
+#define DEFAULT_CAPTURE_SLOTS       1024
+#define DEFAULT_CAPTURE_RATE        100     /* captures per second */
+
+
+
+
+/* SPLP_CAPTURE_FILE_HEADER
+* Occupies the first slot of every ring file.
+*/
+typedef struct _SPLP_CAPTURE_FILE_HEADER
+{
+    char               magic[ 8 ];
+    unsigned int       slotSize;
+    unsigned int       slotCount;      /* record slots after the header */
+    unsigned int       recordCount;    /* slots in use */
+    unsigned int       reserved;
+    unsigned long long firstSequence;
+
+}SPLP_CAPTURE_FILE_HEADER, *PSPLP_CAPTURE_FILE_HEADER;
+
+
+
+
+/* SPLP_CAPTURE_RECORD_HEADER
+* Session context stored in front of the message text of every slot.
+*/
+typedef struct _SPLP_CAPTURE_RECORD_HEADER
+{
+    unsigned long long sequence;       /* number of the capture */
+    unsigned long long timestamp;      /* SplpReadTsc( ) */
+    unsigned int       length;         /* original message length */
+    unsigned char      state;          /* state before the message */
+    unsigned char      stateAfter;     /* state after the rejection */
+    unsigned char      reason;         /* enum Reason */
+    unsigned char      direction;      /* enum Direction */
+
+}SPLP_CAPTURE_RECORD_HEADER, *PSPLP_CAPTURE_RECORD_HEADER;
+
+
+
+
+/* SPLP_CAPTURE
+* Capture state. All ring files are created at full size and stay open
+* from SplpCaptureOpen( ) to SplpCaptureClose( ), so a capture is one
+* fseek( ) and one fwrite( ) of a slot. The header of a file is written
+* when the ring rotates away from it and on close.
+*/
+typedef struct _SPLP_CAPTURE
+{
+    char               prefix[ SPLP_CAPTURE_NAME_SIZE ];
+    FILE**             pFiles;         /* fileCount ring files */
+    FILE*              fOutput;        /* pFiles[ fileIdx ] */
+    unsigned int       fileCount;
+    unsigned int       fileIdx;
+    unsigned int       slotCount;
+    unsigned int       sampleRate;     /* consider every sampleRate-th reject */
+    unsigned int       sampleCounter;
+    unsigned int       ratePerSecond;  /* token bucket refill */
+    unsigned int       tokens;
+    clock_t            lastRefill;
+    SPLP_CAPTURE_FILE_HEADER header;   /* header of the current file */
+    unsigned long long sequence;
+    unsigned long long dropped;        /* rejects skipped by the rate limit */
+    unsigned long long oversized;      /* rejects too long for a slot */
+
+}SPLP_CAPTURE, *PSPLP_CAPTURE;
+
+
+
+
+SPLP_STATUS SplpCaptureOpen(
+    PSPLP_CAPTURE pCapture,
+    const char* prefix,
+    unsigned int fileCount,
+    unsigned int slotCount,
+    unsigned int sampleRate,
+    unsigned int ratePerSecond );
+
+
+
+
+void SplpCaptureReject(
+    PSPLP_CAPTURE pCapture,
+    const struct Message* pMsg,
+    unsigned int length,
+    enum State state );
+
+
+
+
+SPLP_STATUS SplpCaptureClose(
+    PSPLP_CAPTURE pCapture );
+
+
+
+
+SPLP_STATUS SplpCaptureExport(
+    const char* fileName,
+    FILE* fOutput );
+
+#endif /* SPLPCAP_H */
@@ -0,0 +1,20 @@
+/*
+ * SPLPCLASS.h
+ * The file is part of practical task for System programming course.
+ * This file contains the character classes of SPLPv1 payloads, shared
+ * by all validation engines.
+ */
+#ifndef SPLPCLASS_H
+#define SPLPCLASS_H
+
+#define SPLP_CLASS_DATA		0x01	/* [a-z0-9.], payload of a data response  */
+#define SPLP_CLASS_B64		0x02	/* [A-Za-z0-9+/]                          */
+#define SPLP_CLASS_B64_PAD	0x04	/* [A-Za-z0-9+/=], last byte of a base64  */
+#define SPLP_CLASS_DIGIT	0x08	/* [0-9], version number                  */
+#define SPLP_CLASS_SPACE	0x10	/* ' ', separator                         */
+
+/* Class bits of every byte value, indexed by unsigned char; bytes >= 0x80
+ * belong to no class. Defined in SPLPv1.c, one copy per program */
+extern const unsigned char splp_char_class[256];
+
+#endif /* SPLPCLASS_H */
@@ -0,0 +1,250 @@
+/*
+* SPLPCONC.c
+* The file is part of practical task for System programming course.
+* This file contains the benchmark of the concurrent session tables.
+* Every thread picks random sessions out of a shared table, reads the
+* state and validates the next message of the conversation, the way
+* the client and the server side of a session do when they are served
+* by different cores. A session read by one thread may move on before
+* its message is validated; such messages are rejected, and in the
+* lock-free table they are also the compare and swap retries.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "splpv1.h"
+#include "splpconc.h"
+#include "splptable.h"
+#include "splpscale.h"
+#include "splpbench.h"
+
+
+
+typedef enum _SPLP_CONC_TABLE
+{
+    SPLP_CONC_TABLE_SHARDED,
+    SPLP_CONC_TABLE_LOCK_FREE,
+    SPLP_CONC_TABLE_COUNT
+} SPLP_CONC_TABLE;
+
+
+
+
+typedef struct _SPLP_CONC
+{
+    SPLP_CONC_TABLE        kind;
+    SPLP_TABLE             table;
+    SPLP_SHARDED_TABLE     sharded;
+    unsigned int           sessions;
+    unsigned int           messages;       /* per thread */
+    volatile unsigned int  start;
+
+}SPLP_CONC, *PSPLP_CONC;
+
+
+
+
+/* SPLP_CONC_WORKER
+* Counters are private to the thread and padded, so counting does not
+* add sharing of its own.
+*/
+typedef struct _SPLP_CONC_WORKER
+{
+    PSPLP_CONC             pConc;
+    SPLP_THREAD            thread;
+    unsigned long long     seed;
+    unsigned int           invalid;
+    unsigned int           retries;
+    char                   padding[ SPLP_TABLE_CACHE_LINE ];
+
+}SPLP_CONC_WORKER, *PSPLP_CONC_WORKER;
+
+
+
+
+static SPLP_THREAD_ROUTINE( SplpConcWorker, arg )
+{
+    PSPLP_CONC_WORKER pWorker = (PSPLP_CONC_WORKER) arg;
+    PSPLP_CONC pConc = pWorker->pConc;
+    unsigned long long seed = pWorker->seed;
+    unsigned int i;
+
+    while ( !SplpLoadAcquire( &pConc->start ) )
+        SplpThreadYield( );
+
+    for ( i = 0; i < pConc->messages; i++ )
+    {
+        unsigned long long random;
+        unsigned int id;
+        enum test_status result;
+
+        seed ^= seed >> 12;
+        seed ^= seed << 25;
+        seed ^= seed >> 27;
+        random = seed * 2685821657736338717ull;
+        id = (unsigned int) ( ( ( random >> 32 ) * pConc->sessions ) >> 32 );
+
+        if ( pConc->kind == SPLP_CONC_TABLE_SHARDED )
+        {
+            enum State state = SplpShardedState( &pConc->sharded, id );
+            result = SplpShardedValidate( &pConc->sharded, id,
+                (struct Message*) &SplpScaleScript[ state ][ random & ( SPLP_SCALE_VARIANTS - 1 ) ] );
+        }
+        else
+        {
+            PSPLP_TABLE_SLOT pSlot = SplpTableLookup( &pConc->table, id );
+            result = pSlot ? SplpTableValidate( pSlot,
+                (struct Message*) &SplpScaleScript[ SplpTableState( pSlot ) ][ random & ( SPLP_SCALE_VARIANTS - 1 ) ],
+                &pWorker->retries ) : MESSAGE_INVALID;
+        }
+        if ( result != MESSAGE_VALID )
+            pWorker->invalid++;
+    }
+
+    SPLP_THREAD_RETURN;
+}
+
+
+
+
+/* SplpConcRun
+* Runs threadCount workers on a fresh table. Returns TSC ticks from the
+* start signal until the last worker is done, 0 on error.
+*/
+static unsigned long long SplpConcRun(
+    PSPLP_CONC pConc,
+    PSPLP_CONC_WORKER pWorkers,
+    unsigned int threadCount,
+    unsigned long long* pInvalid,
+    unsigned long long* pRetries )
+{
+    unsigned long long begin;
+    unsigned long long ticks;
+    unsigned int started;
+    unsigned int i;
+    SPLP_STATUS status;
+
+    status = pConc->kind == SPLP_CONC_TABLE_SHARDED ?
+        SplpShardedInit( &pConc->sharded, SPLP_CONC_SHARDS, pConc->sessions ) :
+        SplpTableInit( &pConc->table, pConc->sessions );
+    if ( status != SPLP_STATUS_OK )
+    {
+        printf( "***ERROR*** Not enough memory for the session table\n" );
+        SplpShardedFree( &pConc->sharded );
+        SplpTableFree( &pConc->table );
+        return 0;
+    }
+
+    pConc->messages = SPLP_CONC_MESSAGES / threadCount;
+    pConc->start = 0;
+    for ( started = 0; started < threadCount; started++ )
+    {
+        memset( &pWorkers[ started ], 0, sizeof( pWorkers[ started ] ) );
+        pWorkers[ started ].pConc = pConc;
+        pWorkers[ started ].seed = 0x2545f4914f6cdd1dull + 0x9e3779b97f4a7c15ull * ( started + 1 );
+        if ( 0 != SplpThreadCreate( &pWorkers[ started ].thread, SplpConcWorker, &pWorkers[ started ] ) )
+        {
+            printf( "***ERROR*** Cannot start a benchmark thread\n" );
+            break;
+        }
+    }
+
+    begin = SplpReadTsc( );
+    SplpStoreRelease( &pConc->start, 1 );
+    for ( i = 0; i < started; i++ )
+        SplpThreadJoin( pWorkers[ i ].thread );
+    ticks = SplpReadTsc( ) - begin;
+
+    *pInvalid = 0;
+    *pRetries = 0;
+    for ( i = 0; i < started; i++ )
+    {
+        *pInvalid += pWorkers[ i ].invalid;
+        *pRetries += pWorkers[ i ].retries;
+    }
+
+    if ( pConc->kind == SPLP_CONC_TABLE_SHARDED )
+        SplpShardedFree( &pConc->sharded );
+    else
+        SplpTableFree( &pConc->table );
+    return started == threadCount ? ticks : 0;
+}
+
+
+
+
+SPLP_STATUS SplpConcurrentBenchmark(
+    PSPLP_TEST_OPTIONS pOptions )
+{
+    static SPLP_CONC_WORKER workers[ SPLP_CONC_MAX_THREADS ];
+    static SPLP_CONC conc;
+    unsigned int threads[ SPLP_CONC_MAX_POINTS ];
+    unsigned int threadCount = 0;
+    const char* pThreads = pOptions->concurrentThreads ? pOptions->concurrentThreads : DEFAULT_CONC_THREADS;
+    double ticksPerSecond;
+    unsigned int i;
+
+    while ( *pThreads && threadCount < SPLP_CONC_MAX_POINTS )
+    {
+        char* pEnd;
+        unsigned long count = strtoul( pThreads, &pEnd, 10 );
+        if ( pEnd == pThreads || count == 0 || count > SPLP_CONC_MAX_THREADS )
+        {
+            printf( "***ERROR*** Bad thread count list \"%s\", 1..%u threads\n",
+                pOptions->concurrentThreads, SPLP_CONC_MAX_THREADS );
+            return SPLP_STATUS_ERROR;
+        }
+        threads[ threadCount++ ] = (unsigned int) count;
+        pThreads = *pEnd == ',' ? pEnd + 1 : pEnd;
+    }
+
+    memset( &conc, 0, sizeof( conc ) );
+    conc.sessions = pOptions->concurrentSessions;
+    ticksPerSecond = SplpTscTicksPerSecond( );
+
+    printf(
+        "======================================================================\n"
+        " CONCURRENT SESSION TABLES (M msg/s):\n"
+        "======================================================================\n"
+        "\tMessages/point:   \t%14u\n"
+        "\tSessions:         \t%14u\n"
+        "\tShards:           \t%14u\n\n",
+        SPLP_CONC_MESSAGES,
+        conc.sessions,
+        SPLP_CONC_SHARDS );
+
+    printf( "\t%8s %12s %12s %10s %10s %12s\n",
+        "Threads", "Sharded", "Lock-free", "Speedup", "Invalid %", "Retries/Mmsg" );
+
+    for ( i = 0; i < threadCount; i++ )
+    {
+        double rate[ SPLP_CONC_TABLE_COUNT ];
+        unsigned long long invalid = 0;
+        unsigned long long retries = 0;
+        unsigned int messages = SPLP_CONC_MESSAGES / threads[ i ] * threads[ i ];
+        unsigned int kind;
+
+        for ( kind = 0; kind < SPLP_CONC_TABLE_COUNT; kind++ )
+        {
+            unsigned long long ticks;
+
+            conc.kind = (SPLP_CONC_TABLE) kind;
+            ticks = SplpConcRun( &conc, workers, threads[ i ], &invalid, &retries );
+            if ( ticks == 0 )
+                return SPLP_STATUS_ERROR;
+            rate[ kind ] = messages * ticksPerSecond / ticks / 1e6;
+        }
+
+        /* invalid and retries are those of the lock-free run */
+        printf( "\t%8u %12.2f %12.2f %9.2fx %10.2f %12.1f\n",
+            threads[ i ],
+            rate[ SPLP_CONC_TABLE_SHARDED ],
+            rate[ SPLP_CONC_TABLE_LOCK_FREE ],
+            rate[ SPLP_CONC_TABLE_LOCK_FREE ] / rate[ SPLP_CONC_TABLE_SHARDED ],
+            invalid * 100.0 / messages,
+            retries * 1e6 / messages );
+    }
+
+    printf( "======================================================================\n" );
+    return SPLP_STATUS_OK;
+}
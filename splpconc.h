@@ -0,0 +1,27 @@
+/*
+* SPLPCONC.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the benchmark of the concurrent
+* session tables.
+*/
+#ifndef SPLPCONC_H
+#define SPLPCONC_H
+
+#include "splptest.h"
+
+
+
+#define DEFAULT_CONC_THREADS      "1,2,4,8,16,32,64"
+#define DEFAULT_CONC_SESSIONS     65536
+#define SPLP_CONC_MESSAGES        ( 1u << 22 )    /* messages per point, over all threads */
+#define SPLP_CONC_SHARDS          64
+#define SPLP_CONC_MAX_THREADS     64
+#define SPLP_CONC_MAX_POINTS      16
+
+
+
+
+SPLP_STATUS SplpConcurrentBenchmark(
+    PSPLP_TEST_OPTIONS pOptions );
+
+#endif /* SPLPCONC_H */
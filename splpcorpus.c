@@ -0,0 +1,620 @@
+/*
+* SPLPCORPUS.c
+* The file is part of practical task for System programming course.
+* This file contains the corpus reader. gzip support needs zlib and
+* SPLP_WITH_ZLIB defined, zstd support libzstd and SPLP_WITH_ZSTD;
+* without them such files are refused with a message.
+*
+* A gzip member can only be found by inflating everything before it,
+* so gzip corpora are inflated by the reading thread. The end of a zstd
+* frame can be found from its block headers, so the reading thread cuts
+* the input into frames and hands them to worker threads, which
+* decompress them while the loader parses the earlier ones. From the
+* first frame without a content size in the header, or larger than
+* SPLP_CORPUS_MAX_FRAME, the reading thread streams instead.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "splpcorpus.h"
+#if defined( SPLP_WITH_ZLIB )
+#include <zlib.h>
+#endif
+#if defined( SPLP_WITH_ZSTD )
+#include <zstd.h>
+#endif
+
+
+
+static unsigned int SplpCorpusThreads = 0;
+
+
+
+
+void SplpCorpusSetThreads(
+    unsigned int threadCount )
+{
+    SplpCorpusThreads = threadCount;
+}
+
+
+
+
+#if defined( SPLP_WITH_ZSTD )
+
+/* a frame of at most SPLP_CORPUS_MAX_FRAME bytes fits the input buffer */
+#define SPLP_CORPUS_MAX_INPUT     ( ZSTD_COMPRESSBOUND( SPLP_CORPUS_MAX_FRAME ) + SPLP_CORPUS_CHUNK )
+#define SPLP_CORPUS_HEADER_SIZE   18      /* ZSTD_FRAMEHEADERSIZE_MAX */
+
+
+
+
+static SPLP_THREAD_ROUTINE( SplpCorpusWorker, arg )
+{
+    PSPLP_CORPUS_SLOT pSlot = (PSPLP_CORPUS_SLOT) arg;
+    PSPLP_CORPUS pCorpus = pSlot->pCorpus;
+    ZSTD_DCtx* pContext = ZSTD_createDCtx( );
+
+    for ( ;; )
+    {
+        unsigned long long contentSize;
+        size_t result;
+
+        while ( SplpLoadAcquire( &pSlot->ready ) != SPLP_CORPUS_SLOT_QUEUED && !SplpLoadAcquire( &pCorpus->stop ) )
+            SplpThreadYield( );
+        /* a frame queued before the stop is still decompressed */
+        if ( SplpLoadAcquire( &pSlot->ready ) != SPLP_CORPUS_SLOT_QUEUED )
+            break;
+
+        contentSize = ZSTD_getFrameContentSize( pSlot->pSource, pSlot->sourceSize );
+        if ( contentSize > pSlot->capacity )
+        {
+            free( pSlot->pData );
+            pSlot->capacity = (size_t) contentSize;
+            pSlot->pData = (char*) malloc( pSlot->capacity ? pSlot->capacity : 1 );
+        }
+
+        result = pContext && pSlot->pData ?
+            ZSTD_decompressDCtx( pContext, pSlot->pData, pSlot->capacity, pSlot->pSource, pSlot->sourceSize ) : (size_t) -1;
+        pSlot->error = ZSTD_isError( result ) || !pContext || !pSlot->pData;
+        pSlot->size = pSlot->error ? 0 : result;
+        SplpStoreRelease( &pSlot->ready, SPLP_CORPUS_SLOT_DONE );
+    }
+
+    ZSTD_freeDCtx( pContext );
+    SPLP_THREAD_RETURN;
+}
+
+
+
+
+/* SplpCorpusReadInput
+* Moves the unread input to the front of pInput and reads more, growing
+* pInput if it is full, up to SPLP_CORPUS_MAX_INPUT. Returns the number
+* of bytes read, 0 at the end of the file, if pInput can't grow, or on
+* an error, which sets pCorpus->error.
+*/
+static size_t SplpCorpusReadInput(
+    PSPLP_CORPUS pCorpus )
+{
+    size_t read;
+
+    if ( pCorpus->inputPosition )
+    {
+        memmove( pCorpus->pInput, pCorpus->pInput + pCorpus->inputPosition, pCorpus->inputSize - pCorpus->inputPosition );
+        pCorpus->inputSize -= pCorpus->inputPosition;
+        pCorpus->inputPosition = 0;
+    }
+
+    if ( pCorpus->inputSize == pCorpus->inputCapacity )
+    {
+        unsigned char* pInput;
+
+        if ( pCorpus->inputCapacity * 2 > SPLP_CORPUS_MAX_INPUT )
+            return 0;
+        pInput = (unsigned char*) realloc( pCorpus->pInput, pCorpus->inputCapacity * 2 );
+        if ( !pInput )
+        {
+            printf( "***ERROR*** Not enough memory to read \"%s\"\n", pCorpus->pFileName );
+            pCorpus->error = 1;
+            return 0;
+        }
+        pCorpus->pInput = pInput;
+        pCorpus->inputCapacity *= 2;
+    }
+
+    read = fread( pCorpus->pInput + pCorpus->inputSize, 1, pCorpus->inputCapacity - pCorpus->inputSize, pCorpus->pFile );
+    pCorpus->inputSize += read;
+    pCorpus->compressedBytes += read;
+    if ( read == 0 )
+        pCorpus->endOfFile = 1;
+    return read;
+}
+
+
+
+
+/* SplpCorpusNextFrame
+* Reads input until it holds the whole next frame. Returns 1 and its
+* compressed size if a worker can decompress it, 0 at the end of the
+* file or on an error, -1 if the rest of the file must be streamed. A
+* damaged or truncated frame is streamed too, so the stream reports it.
+*/
+static int SplpCorpusNextFrame(
+    PSPLP_CORPUS pCorpus,
+    size_t* pFrameSize )
+{
+    for ( ;; )
+    {
+        const unsigned char* pSource = pCorpus->pInput + pCorpus->inputPosition;
+        size_t available = pCorpus->inputSize - pCorpus->inputPosition;
+
+        if ( available )
+        {
+            unsigned long long contentSize = ZSTD_getFrameContentSize( pSource, available );
+            size_t frameSize = ZSTD_findFrameCompressedSize( pSource, available );
+
+            /* an incomplete header is an error until more input is read,
+             * SPLP_CORPUS_HEADER_SIZE bytes hold any header */
+            if ( contentSize == ZSTD_CONTENTSIZE_UNKNOWN ||
+                ( contentSize == ZSTD_CONTENTSIZE_ERROR && available >= SPLP_CORPUS_HEADER_SIZE ) ||
+                ( contentSize != ZSTD_CONTENTSIZE_ERROR && contentSize > SPLP_CORPUS_MAX_FRAME ) )
+                return -1;
+            if ( !ZSTD_isError( frameSize ) && contentSize != ZSTD_CONTENTSIZE_ERROR )
+            {
+                *pFrameSize = frameSize;
+                return 1;
+            }
+        }
+
+        if ( pCorpus->endOfFile )
+            return available ? -1 : 0;
+        if ( !SplpCorpusReadInput( pCorpus ) )
+            return pCorpus->error ? 0 : -1;
+    }
+}
+
+
+
+
+/* SplpCorpusOpenZstd
+* Starts the workers if the first frame can be decompressed by one.
+*/
+static SPLP_STATUS SplpCorpusOpenZstd(
+    PSPLP_CORPUS pCorpus )
+{
+    size_t frameSize;
+    unsigned int i;
+
+    pCorpus->inputCapacity = SPLP_CORPUS_CHUNK;
+    pCorpus->pInput = (unsigned char*) malloc( pCorpus->inputCapacity );
+    pCorpus->pChunk = (char*) malloc( SPLP_CORPUS_CHUNK );
+    pCorpus->pStream = ZSTD_createDStream( );
+    if ( !pCorpus->pInput || !pCorpus->pChunk || !pCorpus->pStream ||
+        ZSTD_isError( ZSTD_initDStream( (ZSTD_DStream*) pCorpus->pStream ) ) )
+        return SPLP_STATUS_ERROR;
+
+    pCorpus->threadCount = SplpCorpusThreads ? SplpCorpusThreads : SplpCpuCount( );
+    if ( pCorpus->threadCount > SPLP_CORPUS_MAX_THREADS )
+        pCorpus->threadCount = SPLP_CORPUS_MAX_THREADS;
+    if ( pCorpus->threadCount < 2 || 1 != SplpCorpusNextFrame( pCorpus, &frameSize ) )
+    {
+        pCorpus->threadCount = 0;
+        pCorpus->streaming = 1;
+        return pCorpus->error ? SPLP_STATUS_ERROR : SPLP_STATUS_OK;
+    }
+
+    for ( i = 0; i < pCorpus->threadCount; i++ )
+    {
+        pCorpus->slots[ i ].pCorpus = pCorpus;
+        if ( 0 != SplpThreadCreate( &pCorpus->slots[ i ].thread, SplpCorpusWorker, &pCorpus->slots[ i ] ) )
+        {
+            printf( "***ERROR*** Cannot start a decompression thread\n" );
+            pCorpus->threadCount = i;
+            return SPLP_STATUS_ERROR;
+        }
+    }
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+/* SplpCorpusQueueFrames
+* Hands the next frames to free slots, so the workers stay threadCount
+* frames ahead of the reader.
+*/
+static void SplpCorpusQueueFrames(
+    PSPLP_CORPUS pCorpus )
+{
+    while ( !SplpLoadAcquire( &pCorpus->stop ) && pCorpus->queuedFrames < pCorpus->nextFrame + pCorpus->threadCount )
+    {
+        PSPLP_CORPUS_SLOT pSlot = &pCorpus->slots[ pCorpus->queuedFrames % pCorpus->threadCount ];
+        size_t frameSize;
+        int next = SplpCorpusNextFrame( pCorpus, &frameSize );
+
+        if ( next != 1 )
+        {
+            /* the workers finish the queued frames and exit */
+            pCorpus->streaming = next < 0;
+            SplpStoreRelease( &pCorpus->stop, 1 );
+            break;
+        }
+
+        if ( frameSize > pSlot->sourceCapacity )
+        {
+            free( pSlot->pSource );
+            pSlot->sourceCapacity = frameSize;
+            pSlot->pSource = (unsigned char*) malloc( frameSize );
+            if ( !pSlot->pSource )
+            {
+                printf( "***ERROR*** Not enough memory to read \"%s\"\n", pCorpus->pFileName );
+                pSlot->sourceCapacity = 0;
+                pCorpus->error = 1;
+                SplpStoreRelease( &pCorpus->stop, 1 );
+                break;
+            }
+        }
+        memcpy( pSlot->pSource, pCorpus->pInput + pCorpus->inputPosition, frameSize );
+        pSlot->sourceSize = frameSize;
+        pCorpus->inputPosition += frameSize;
+        pCorpus->queuedFrames++;
+        SplpStoreRelease( &pSlot->ready, SPLP_CORPUS_SLOT_QUEUED );
+    }
+}
+
+
+
+
+static int SplpCorpusFillStream(
+    PSPLP_CORPUS pCorpus )
+{
+    ZSTD_inBuffer input;
+    ZSTD_outBuffer output;
+
+    output.dst = pCorpus->pChunk;
+    output.size = SPLP_CORPUS_CHUNK;
+    output.pos = 0;
+
+    for ( ;; )
+    {
+        size_t result;
+
+        input.src = pCorpus->pInput;
+        input.size = pCorpus->inputSize;
+        input.pos = pCorpus->inputPosition;
+
+        /* also called without input, to flush what the last call kept */
+        result = ZSTD_decompressStream( (ZSTD_DStream*) pCorpus->pStream, &output, &input );
+        if ( ZSTD_isError( result ) )
+        {
+            printf( "***ERROR*** File \"%s\" has damaged zstd data: %s\n", pCorpus->pFileName, ZSTD_getErrorName( result ) );
+            pCorpus->error = 1;
+            return 0;
+        }
+        if ( input.pos != pCorpus->inputPosition || output.pos )
+            pCorpus->partial = result != 0;
+        pCorpus->inputPosition = input.pos;
+
+        if ( output.pos )
+            break;
+        if ( pCorpus->inputPosition == pCorpus->inputSize && !SplpCorpusReadInput( pCorpus ) )
+            break;
+    }
+
+    if ( !output.pos && pCorpus->partial && !pCorpus->error )
+    {
+        printf( "***ERROR*** File \"%s\" ends inside a zstd frame\n", pCorpus->pFileName );
+        pCorpus->error = 1;
+    }
+
+    pCorpus->pBuffer = pCorpus->pChunk;
+    pCorpus->position = 0;
+    pCorpus->size = output.pos;
+    return output.pos != 0;
+}
+
+
+
+
+/* SplpCorpusFillZstd
+* Frees the slot of the previous frame, queues the next frames and waits
+* for the frame the reader takes next.
+*/
+static int SplpCorpusFillZstd(
+    PSPLP_CORPUS pCorpus )
+{
+    while ( !pCorpus->streaming || pCorpus->nextFrame < pCorpus->queuedFrames )
+    {
+        PSPLP_CORPUS_SLOT pSlot;
+
+        if ( pCorpus->nextFrame )
+        {
+            pSlot = &pCorpus->slots[ ( pCorpus->nextFrame - 1 ) % pCorpus->threadCount ];
+            if ( SplpLoadAcquire( &pSlot->ready ) == SPLP_CORPUS_SLOT_DONE )
+                SplpStoreRelease( &pSlot->ready, SPLP_CORPUS_SLOT_FREE );
+        }
+
+        SplpCorpusQueueFrames( pCorpus );
+        if ( pCorpus->error || pCorpus->nextFrame == pCorpus->queuedFrames )
+            break;
+
+        pSlot = &pCorpus->slots[ pCorpus->nextFrame % pCorpus->threadCount ];
+        while ( SplpLoadAcquire( &pSlot->ready ) != SPLP_CORPUS_SLOT_DONE )
+            SplpThreadYield( );
+
+        if ( pSlot->error )
+        {
+            printf( "***ERROR*** File \"%s\" has a damaged zstd frame %u\n", pCorpus->pFileName, pCorpus->nextFrame );
+            pCorpus->error = 1;
+            return 0;
+        }
+
+        pCorpus->nextFrame++;
+        pCorpus->pBuffer = pSlot->pData;
+        pCorpus->position = 0;
+        pCorpus->size = pSlot->size;
+        if ( pSlot->size )
+            return 1;
+    }
+
+    if ( pCorpus->error || !pCorpus->streaming )
+        return 0;
+    return SplpCorpusFillStream( pCorpus );
+}
+#endif
+
+
+
+
+#if defined( SPLP_WITH_ZLIB )
+static int SplpCorpusFillGzip(
+    PSPLP_CORPUS pCorpus )
+{
+    z_stream* pStream = (z_stream*) pCorpus->pStream;
+
+    pStream->next_out = (Bytef*) pCorpus->pChunk;
+    pStream->avail_out = SPLP_CORPUS_CHUNK;
+
+    while ( pStream->avail_out == SPLP_CORPUS_CHUNK )
+    {
+        int result;
+
+        if ( pStream->avail_in == 0 )
+        {
+            pStream->avail_in = (uInt) fread( pCorpus->pInput, 1, SPLP_CORPUS_CHUNK, pCorpus->pFile );
+            pStream->next_in = pCorpus->pInput;
+            pCorpus->compressedBytes += pStream->avail_in;
+            if ( pStream->avail_in == 0 )
+                break;
+        }
+
+        result = inflate( pStream, Z_NO_FLUSH );
+        pCorpus->partial = result != Z_STREAM_END;
+        if ( result == Z_STREAM_END )
+        {
+            /* concatenated members, as written by parallel gzip tools */
+            inflateReset( pStream );
+        }
+        else if ( result != Z_OK && result != Z_BUF_ERROR )
+        {
+            printf( "***ERROR*** File \"%s\" has damaged gzip data: %s\n",
+                pCorpus->pFileName, pStream->msg ? pStream->msg : "inflate failed" );
+            pCorpus->error = 1;
+            return 0;
+        }
+    }
+
+    if ( pStream->avail_out == SPLP_CORPUS_CHUNK && pCorpus->partial )
+    {
+        printf( "***ERROR*** File \"%s\" ends inside a gzip member\n", pCorpus->pFileName );
+        pCorpus->error = 1;
+        return 0;
+    }
+
+    pCorpus->pBuffer = pCorpus->pChunk;
+    pCorpus->position = 0;
+    pCorpus->size = SPLP_CORPUS_CHUNK - pStream->avail_out;
+    return pCorpus->size != 0;
+}
+#endif
+
+
+
+
+SPLP_STATUS SplpCorpusOpen(
+    PSPLP_CORPUS pCorpus,
+    const char* fileName )
+{
+    unsigned char magic[ 4 ] = { 0, 0, 0, 0 };
+    SPLP_STATUS status = SPLP_STATUS_OK;
+
+    memset( pCorpus, 0, sizeof( *pCorpus ) );
+    pCorpus->pFileName = fileName;
+
+    if ( 0 != fopen_s( &pCorpus->pFile, fileName, "rb" ) )
+    {
+        printf( "***ERROR*** File \"%s\" can't be opened\n", fileName );
+        return SPLP_STATUS_ERROR;
+    }
+
+    fread( magic, 1, sizeof( magic ), pCorpus->pFile );
+    fseek( pCorpus->pFile, 0, SEEK_SET );
+    if ( magic[ 0 ] == 0x1f && magic[ 1 ] == 0x8b )
+        pCorpus->format = SPLP_CORPUS_GZIP;
+    else if ( magic[ 0 ] == 0x28 && magic[ 1 ] == 0xb5 && magic[ 2 ] == 0x2f && magic[ 3 ] == 0xfd )
+        pCorpus->format = SPLP_CORPUS_ZSTD;
+
+    switch ( pCorpus->format )
+    {
+    case SPLP_CORPUS_GZIP:
+#if defined( SPLP_WITH_ZLIB )
+        pCorpus->pStream = calloc( 1, sizeof( z_stream ) );
+        pCorpus->pInput = (unsigned char*) malloc( SPLP_CORPUS_CHUNK );
+        pCorpus->pChunk = (char*) malloc( SPLP_CORPUS_CHUNK );
+        if ( !pCorpus->pStream || !pCorpus->pInput || !pCorpus->pChunk ||
+            Z_OK != inflateInit2( (z_stream*) pCorpus->pStream, 15 + 32 ) )
+        {
+            free( pCorpus->pStream );
+            pCorpus->pStream = NULL;
+            status = SPLP_STATUS_ERROR;
+        }
+#else
+        printf( "***ERROR*** File \"%s\" is gzip compressed, this build has no SPLP_WITH_ZLIB\n", fileName );
+        status = SPLP_STATUS_ERROR;
+#endif
+        break;
+
+    case SPLP_CORPUS_ZSTD:
+#if defined( SPLP_WITH_ZSTD )
+        status = SplpCorpusOpenZstd( pCorpus );
+#else
+        printf( "***ERROR*** File \"%s\" is zstd compressed, this build has no SPLP_WITH_ZSTD\n", fileName );
+        status = SPLP_STATUS_ERROR;
+#endif
+        break;
+
+    default:
+        pCorpus->pChunk = (char*) malloc( SPLP_CORPUS_CHUNK );
+        if ( !pCorpus->pChunk )
+            status = SPLP_STATUS_ERROR;
+        break;
+    }
+
+    if ( status != SPLP_STATUS_OK )
+        SplpCorpusClose( pCorpus );
+    return status;
+}
+
+
+
+
+void SplpCorpusClose(
+    PSPLP_CORPUS pCorpus )
+{
+    unsigned int i;
+
+    SplpStoreRelease( &pCorpus->stop, 1 );
+    for ( i = 0; i < pCorpus->threadCount; i++ )
+    {
+        SplpThreadJoin( pCorpus->slots[ i ].thread );
+        free( pCorpus->slots[ i ].pSource );
+        free( pCorpus->slots[ i ].pData );
+    }
+
+#if defined( SPLP_WITH_ZLIB )
+    if ( pCorpus->format == SPLP_CORPUS_GZIP && pCorpus->pStream )
+    {
+        inflateEnd( (z_stream*) pCorpus->pStream );
+        free( pCorpus->pStream );
+    }
+#endif
+#if defined( SPLP_WITH_ZSTD )
+    if ( pCorpus->format == SPLP_CORPUS_ZSTD )
+        ZSTD_freeDStream( (ZSTD_DStream*) pCorpus->pStream );
+#endif
+
+    if ( pCorpus->pFile )
+        fclose( pCorpus->pFile );
+    free( pCorpus->pChunk );
+    free( pCorpus->pInput );
+    memset( pCorpus, 0, sizeof( *pCorpus ) );
+}
+
+
+
+
+int SplpCorpusFill(
+    PSPLP_CORPUS pCorpus )
+{
+    int filled = 0;
+
+    if ( pCorpus->error )
+        return 0;
+
+    switch ( pCorpus->format )
+    {
+#if defined( SPLP_WITH_ZLIB )
+    case SPLP_CORPUS_GZIP:
+        filled = SplpCorpusFillGzip( pCorpus );
+        break;
+#endif
+#if defined( SPLP_WITH_ZSTD )
+    case SPLP_CORPUS_ZSTD:
+        filled = SplpCorpusFillZstd( pCorpus );
+        break;
+#endif
+    default:
+        pCorpus->pBuffer = pCorpus->pChunk;
+        pCorpus->position = 0;
+        pCorpus->size = fread( pCorpus->pChunk, 1, SPLP_CORPUS_CHUNK, pCorpus->pFile );
+        pCorpus->compressedBytes += pCorpus->size;
+        filled = pCorpus->size != 0;
+        break;
+    }
+
+    if ( filled )
+        pCorpus->textBytes += pCorpus->size;
+    return filled;
+}
+
+
+
+
+void SplpCorpusSkipSpace(
+    PSPLP_CORPUS pCorpus )
+{
+    int c;
+
+    while ( ( c = SplpCorpusPeek( pCorpus ) ) == ' ' || ( c >= '\t' && c <= '\r' ) )
+        pCorpus->position++;
+}
+
+
+
+
+int SplpCorpusScanInt(
+    PSPLP_CORPUS pCorpus,
+    int* pValue )
+{
+    int negative = 0;
+    int digits = 0;
+    int value = 0;
+    int c;
+
+    SplpCorpusSkipSpace( pCorpus );
+    c = SplpCorpusPeek( pCorpus );
+    if ( c == '-' || c == '+' )
+    {
+        negative = c == '-';
+        pCorpus->position++;
+    }
+
+    while ( ( c = SplpCorpusPeek( pCorpus ) ) >= '0' && c <= '9' )
+    {
+        value = value * 10 + ( c - '0' );
+        pCorpus->position++;
+        digits++;
+    }
+
+    *pValue = negative ? -value : value;
+    return digits != 0;
+}
+
+
+
+
+char* SplpCorpusGets(
+    PSPLP_CORPUS pCorpus,
+    char* pBuffer,
+    int size )
+{
+    int length = 0;
+    int c = 0;
+
+    while ( length < size - 1 && c != '\n' && ( c = SplpCorpusGetc( pCorpus ) ) != EOF )
+        pBuffer[ length++ ] = (char) c;
+
+    pBuffer[ length ] = '\0';
+    return length ? pBuffer : NULL;
+}
@@ -0,0 +1,191 @@
+/*
+* SPLPCORPUS.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the corpus reader, which gives the
+* test file loader the text of a plain, gzip or zstd compressed test
+* file as one buffered stream.
+*/
+#ifndef SPLPCORPUS_H
+#define SPLPCORPUS_H
+
+#include <stdio.h>
+#include "splptest.h"
+#include "splpthread.h"
+
+
+
+#define SPLP_CORPUS_CHUNK         ( 1u << 20 )    /* bytes read or inflated at a time */
+#define SPLP_CORPUS_MAX_THREADS   16
+#define SPLP_CORPUS_MAX_FRAME     ( 256u << 20 )  /* larger zstd frames are streamed */
+
+#define SPLP_CORPUS_SLOT_FREE     0
+#define SPLP_CORPUS_SLOT_QUEUED   1
+#define SPLP_CORPUS_SLOT_DONE     2
+
+
+
+
+typedef enum _SPLP_CORPUS_FORMAT
+{
+    SPLP_CORPUS_TEXT,
+    SPLP_CORPUS_GZIP,             /* needs SPLP_WITH_ZLIB */
+    SPLP_CORPUS_ZSTD              /* needs SPLP_WITH_ZSTD */
+} SPLP_CORPUS_FORMAT;
+
+
+
+
+/* SPLP_CORPUS_SLOT
+* Frame of a zstd corpus decompressed by a worker thread. The reader
+* copies the compressed frame to pSource and queues the slot, the worker
+* decompresses it to pData and sets it done. The slot is free again when
+* the reader is done with the data.
+*/
+typedef struct _SPLP_CORPUS_SLOT
+{
+    struct _SPLP_CORPUS*   pCorpus;
+    SPLP_THREAD            thread;
+    unsigned char*         pSource;
+    size_t                 sourceSize;
+    size_t                 sourceCapacity;
+    char*                  pData;
+    size_t                 size;
+    size_t                 capacity;
+    int                    error;
+    volatile unsigned int  ready;          /* SPLP_CORPUS_SLOT_FREE... */
+    char                   padding[ 64 ];
+
+}SPLP_CORPUS_SLOT, *PSPLP_CORPUS_SLOT;
+
+
+
+
+/* SPLP_CORPUS
+* Decompressed text is read from pBuffer[ position..size ). Compressed
+* input is read SPLP_CORPUS_CHUNK bytes at a time into pInput, which
+* grows only to hold a whole zstd frame. zstd frames are decompressed in
+* parallel, at most threadCount frames ahead of the reader, up to the
+* first frame without a content size or larger than
+* SPLP_CORPUS_MAX_FRAME; from there on, and for gzip and plain files, the
+* reading thread streams. Nothing is written to disk.
+*/
+typedef struct _SPLP_CORPUS
+{
+    FILE*                  pFile;
+    const char*            pFileName;
+    SPLP_CORPUS_FORMAT     format;
+    const char*            pBuffer;
+    size_t                 position;
+    size_t                 size;
+    char*                  pChunk;         /* owned buffer of the streamed formats */
+    unsigned char*         pInput;         /* compressed input */
+    size_t                 inputSize;
+    size_t                 inputPosition;
+    size_t                 inputCapacity;
+    int                    endOfFile;
+    void*                  pStream;        /* z_stream or ZSTD_DStream */
+    int                    partial;        /* the stream ended inside a gzip member or zstd frame */
+    int                    error;
+    unsigned long long     compressedBytes;
+    unsigned long long     textBytes;
+
+    /* parallel zstd frames */
+    unsigned int           queuedFrames;   /* frames handed to the workers */
+    unsigned int           nextFrame;      /* frame the reader takes next */
+    unsigned int           threadCount;
+    int                    streaming;      /* the rest of the file is streamed */
+    volatile unsigned int  stop;           /* no more frames will be queued */
+    SPLP_CORPUS_SLOT       slots[ SPLP_CORPUS_MAX_THREADS ];
+
+}SPLP_CORPUS, *PSPLP_CORPUS;
+
+
+
+
+/* SplpCorpusSetThreads
+* Decompression threads of the next SplpCorpusOpen( ), 0 for one per
+* processor.
+*/
+void SplpCorpusSetThreads(
+    unsigned int threadCount );
+
+
+
+
+/* SplpCorpusOpen
+* Opens a test file, compressed or not, by its first bytes. Prints the
+* reason if it can't be read.
+*/
+SPLP_STATUS SplpCorpusOpen(
+    PSPLP_CORPUS pCorpus,
+    const char* fileName );
+
+
+
+
+void SplpCorpusClose(
+    PSPLP_CORPUS pCorpus );
+
+
+
+
+/* SplpCorpusFill
+* Makes the next decompressed bytes available. Returns 0 at the end of
+* the text or on an error, which sets pCorpus->error. A compressed file
+* which ends inside a gzip member or zstd frame is an error.
+*/
+int SplpCorpusFill(
+    PSPLP_CORPUS pCorpus );
+
+
+
+
+static __inline int SplpCorpusPeek(
+    PSPLP_CORPUS pCorpus )
+{
+    if ( pCorpus->position == pCorpus->size && !SplpCorpusFill( pCorpus ) )
+        return EOF;
+    return (unsigned char) pCorpus->pBuffer[ pCorpus->position ];
+}
+
+
+
+
+static __inline int SplpCorpusGetc(
+    PSPLP_CORPUS pCorpus )
+{
+    int c = SplpCorpusPeek( pCorpus );
+    if ( c != EOF )
+        pCorpus->position++;
+    return c;
+}
+
+
+
+
+/* SplpCorpusScanInt
+* Skips white space and reads a decimal number, as fscanf( "%d" ) does.
+* Returns 0 if there is no number.
+*/
+int SplpCorpusScanInt(
+    PSPLP_CORPUS pCorpus,
+    int* pValue );
+
+
+
+
+void SplpCorpusSkipSpace(
+    PSPLP_CORPUS pCorpus );
+
+
+
+
+/* SplpCorpusGets
+* Reads a line, as fgets( ) does.
+*/
+char* SplpCorpusGets(
+    PSPLP_CORPUS pCorpus,
+    char* pBuffer,
+    int size );
+
+#endif /* SPLPCORPUS_H */
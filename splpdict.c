@@ -0,0 +1,231 @@
+/*
+* SPLPDICT.c
+* The file is part of practical task for System programming course.
+* This file contains the message dictionary. Captures repeat a handful
+* of texts, CONNECT, GET_VER, VERSION 2 and the like, millions of
+* times; with every text stored once and the messages replayed as 4
+* byte entries, the replay working set is the dictionary and the entry
+* stream instead of millions of separate heap blocks.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "splpv1.h"
+#include "splpdict.h"
+
+
+
+static unsigned int SplpDictionaryHash(
+    const char* text,
+    unsigned int length )
+{
+    unsigned int hash = 2166136261u;
+    unsigned int i;
+
+    for ( i = 0; i < length; i++ )
+    {
+        hash ^= (unsigned char) text[ i ];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+
+
+
+SPLP_STATUS SplpDictionaryInit(
+    PSPLP_DICTIONARY pDictionary )
+{
+    memset( pDictionary, 0, sizeof( *pDictionary ) );
+    pDictionary->pSlots = (unsigned int*) calloc( SPLP_DICT_MIN_SLOTS, sizeof( unsigned int ) );
+    pDictionary->slotMask = SPLP_DICT_MIN_SLOTS - 1;
+    return pDictionary->pSlots ? SPLP_STATUS_OK : SPLP_STATUS_ERROR;
+}
+
+
+
+
+void SplpDictionaryFree(
+    PSPLP_DICTIONARY pDictionary )
+{
+    unsigned int i;
+
+    for ( i = 0; i < pDictionary->blockCount; i++ )
+        free( pDictionary->ppBlocks[ i ] );
+    free( pDictionary->ppBlocks );
+    free( pDictionary->ppTexts );
+    free( pDictionary->pLengths );
+    free( pDictionary->pSlots );
+    memset( pDictionary, 0, sizeof( *pDictionary ) );
+}
+
+
+
+
+/* SplpDictionaryGrow
+* Doubles the hash table when it is half full, and the index arrays
+* when they are full.
+*/
+static SPLP_STATUS SplpDictionaryGrow(
+    PSPLP_DICTIONARY pDictionary )
+{
+    if ( pDictionary->count == pDictionary->capacity )
+    {
+        unsigned int capacity = pDictionary->capacity ? pDictionary->capacity * 2 : 256;
+        char** ppTexts = (char**) realloc( pDictionary->ppTexts, capacity * sizeof( char* ) );
+        unsigned int* pLengths;
+
+        if ( !ppTexts )
+            return SPLP_STATUS_ERROR;
+        pDictionary->ppTexts = ppTexts;
+        pLengths = (unsigned int*) realloc( pDictionary->pLengths, capacity * sizeof( unsigned int ) );
+        if ( !pLengths )
+            return SPLP_STATUS_ERROR;
+        pDictionary->pLengths = pLengths;
+        pDictionary->capacity = capacity;
+    }
+
+    if ( ( pDictionary->count + 1 ) * 2 > pDictionary->slotMask + 1 )
+    {
+        unsigned int slotMask = pDictionary->slotMask * 2 + 1;
+        unsigned int* pSlots = (unsigned int*) calloc( slotMask + 1, sizeof( unsigned int ) );
+        unsigned int i;
+
+        if ( !pSlots )
+            return SPLP_STATUS_ERROR;
+        for ( i = 0; i < pDictionary->count; i++ )
+        {
+            unsigned int slot = SplpDictionaryHash( pDictionary->ppTexts[ i ], pDictionary->pLengths[ i ] ) & slotMask;
+            while ( pSlots[ slot ] )
+                slot = ( slot + 1 ) & slotMask;
+            pSlots[ slot ] = i + 1;
+        }
+        free( pDictionary->pSlots );
+        pDictionary->pSlots = pSlots;
+        pDictionary->slotMask = slotMask;
+    }
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+/* SplpDictionaryStore
+* Copies a text into the arena. Texts longer than a block get a block
+* of their own.
+*/
+static char* SplpDictionaryStore(
+    PSPLP_DICTIONARY pDictionary,
+    const char* text,
+    unsigned int length )
+{
+    char* pText;
+
+    if ( pDictionary->blockCount == 0 || pDictionary->blockSize - pDictionary->blockUsed < length + 1 )
+    {
+        unsigned int size = length + 1 > SPLP_DICT_BLOCK_BYTES ? length + 1 : SPLP_DICT_BLOCK_BYTES;
+        char** ppBlocks = (char**) realloc( pDictionary->ppBlocks, ( pDictionary->blockCount + 1 ) * sizeof( char* ) );
+
+        if ( !ppBlocks )
+            return NULL;
+        pDictionary->ppBlocks = ppBlocks;
+        if ( NULL == ( ppBlocks[ pDictionary->blockCount ] = (char*) malloc( size ) ) )
+            return NULL;
+        pDictionary->blockCount++;
+        pDictionary->blockSize = size;
+        pDictionary->blockUsed = 0;
+    }
+
+    pText = pDictionary->ppBlocks[ pDictionary->blockCount - 1 ] + pDictionary->blockUsed;
+    memcpy( pText, text, length );
+    pText[ length ] = '\0';
+    pDictionary->blockUsed += length + 1;
+    pDictionary->bytes += length;
+    return pText;
+}
+
+
+
+
+SPLP_STATUS SplpDictionaryIntern(
+    PSPLP_DICTIONARY pDictionary,
+    const char* text,
+    unsigned int length,
+    unsigned int* pIndex )
+{
+    unsigned int slot;
+
+    if ( SPLP_STATUS_OK != SplpDictionaryGrow( pDictionary ) )
+        return SPLP_STATUS_ERROR;
+
+    for ( slot = SplpDictionaryHash( text, length ) & pDictionary->slotMask;
+        pDictionary->pSlots[ slot ];
+        slot = ( slot + 1 ) & pDictionary->slotMask )
+    {
+        unsigned int index = pDictionary->pSlots[ slot ] - 1;
+        if ( pDictionary->pLengths[ index ] == length && 0 == memcmp( pDictionary->ppTexts[ index ], text, length ) )
+        {
+            *pIndex = index;
+            return SPLP_STATUS_OK;
+        }
+    }
+
+    if ( NULL == ( pDictionary->ppTexts[ pDictionary->count ] = SplpDictionaryStore( pDictionary, text, length ) ) )
+        return SPLP_STATUS_ERROR;
+    pDictionary->pLengths[ pDictionary->count ] = length;
+    pDictionary->pSlots[ slot ] = pDictionary->count + 1;
+    *pIndex = pDictionary->count++;
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+SPLP_STATUS SplpTestDataDeduplicate(
+    PSPLP_TEST_DATA pData )
+{
+    PSPLP_DICTIONARY pDictionary = (PSPLP_DICTIONARY) malloc( sizeof( SPLP_DICTIONARY ) );
+    PSPLP_TEST_ENTRY pEntries = (PSPLP_TEST_ENTRY) malloc( pData->size * sizeof( SPLP_TEST_ENTRY ) );
+    unsigned int msgIdx;
+
+    if ( !pDictionary || !pEntries || SPLP_STATUS_OK != SplpDictionaryInit( pDictionary ) )
+    {
+        printf( "***ERROR*** Not enough memory for the message dictionary\n" );
+        free( pDictionary );
+        free( pEntries );
+        return SPLP_STATUS_ERROR;
+    }
+
+    for ( msgIdx = 0; msgIdx < pData->size; msgIdx++ )
+    {
+        PSPLP_TEST_MESSAGE pMsg = &pData->MessageArray[ msgIdx ];
+        unsigned int index;
+
+        if ( SPLP_STATUS_OK != SplpDictionaryIntern( pDictionary, pMsg->msg.text_message, pMsg->length, &index ) ||
+            index > SPLP_TEST_ENTRY_MAX_INDEX )
+        {
+            printf( "***ERROR*** Message %u can't be added to the message dictionary\n", msgIdx );
+            break;
+        }
+        pEntries[ msgIdx ].index = index;
+        pEntries[ msgIdx ].direction = pMsg->msg.direction == B_TO_A;
+        pEntries[ msgIdx ].valid = pMsg->expectedTestStatus == MESSAGE_VALID;
+    }
+
+    if ( msgIdx != pData->size )
+    {
+        SplpDictionaryFree( pDictionary );
+        free( pDictionary );
+        free( pEntries );
+        return SPLP_STATUS_ERROR;
+    }
+
+    for ( msgIdx = 0; msgIdx < pData->size; msgIdx++ )
+    {
+        free( pData->MessageArray[ msgIdx ].msg.text_message );
+        pData->MessageArray[ msgIdx ].msg.text_message = pDictionary->ppTexts[ pEntries[ msgIdx ].index ];
+    }
+    pData->pDictionary = pDictionary;
+    pData->pEntries = pEntries;
+    return SPLP_STATUS_OK;
+}
@@ -0,0 +1,75 @@
+/*
+* SPLPDICT.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the message dictionary, which
+* keeps every distinct message text of a test file once.
+*/
+#ifndef SPLPDICT_H
+#define SPLPDICT_H
+
+#include "splptest.h"
+
+
+
+#define SPLP_DICT_BLOCK_BYTES     65536   /* arena block, texts are packed back to back */
+#define SPLP_DICT_MIN_SLOTS       1024
+
+
+
+
+/* SPLP_DICTIONARY
+* Texts are found by a FNV-1a hash in an open addressing table of
+* index + 1, 0 for a free slot.
+*/
+typedef struct _SPLP_DICTIONARY
+{
+    char**             ppTexts;        /* by index */
+    unsigned int*      pLengths;
+    unsigned int       count;
+    unsigned int       capacity;
+    unsigned int*      pSlots;
+    unsigned int       slotMask;
+    char**             ppBlocks;
+    unsigned int       blockCount;
+    unsigned int       blockUsed;      /* bytes used in the last block */
+    unsigned int       blockSize;      /* of the last block */
+    unsigned long long bytes;          /* of the distinct texts, without terminators */
+
+}SPLP_DICTIONARY, *PSPLP_DICTIONARY;
+
+
+
+
+SPLP_STATUS SplpDictionaryInit(
+    PSPLP_DICTIONARY pDictionary );
+
+
+
+
+void SplpDictionaryFree(
+    PSPLP_DICTIONARY pDictionary );
+
+
+
+
+/* SplpDictionaryIntern
+* Returns the index of text in *pIndex, adding it if it is new.
+*/
+SPLP_STATUS SplpDictionaryIntern(
+    PSPLP_DICTIONARY pDictionary,
+    const char* text,
+    unsigned int length,
+    unsigned int* pIndex );
+
+
+
+
+/* SplpTestDataDeduplicate
+* Interns the texts of all messages, points the messages at the
+* dictionary copies, frees the loaded ones, and fills pData->pEntries.
+* SplpTestDataFree( ) knows about both.
+*/
+SPLP_STATUS SplpTestDataDeduplicate(
+    PSPLP_TEST_DATA pData );
+
+#endif /* SPLPDICT_H */
@@ -0,0 +1,151 @@
+/*
+* SPLPEMBED.c
+* The file is part of practical task for System programming course.
+* This file contains the benchmark of the validator embedded into a
+* receive loop. The library loop calls validate_session_message( ) in
+* another translation unit for every message; the inline loop is the
+* same loop with the core of splpinline.h expanded into it, so the
+* state dispatch, the probes and the session stay in registers of the
+* loop.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "splpinline.h"
+#include "splpembed.h"
+#include "splpbench.h"
+
+
+
+
+/* SPLP_EMBED_LOOP
+* Result of one pass over the test messages.
+*/
+typedef struct _SPLP_EMBED_LOOP
+{
+    unsigned long long ticks;
+    unsigned long long valid;          /* MESSAGE_VALID verdicts */
+    unsigned long long wrong;          /* verdicts other than expected */
+
+}SPLP_EMBED_LOOP, *PSPLP_EMBED_LOOP;
+
+
+
+
+static void SplpEmbedLibrary(
+    PSPLP_TEST_DATA pData,
+    unsigned int cycles,
+    PSPLP_EMBED_LOOP pLoop )
+{
+    struct Session session = { INIT, REASON_NONE };
+    unsigned long long begin = SplpReadTsc( );
+    unsigned int cycle;
+    unsigned int msgIdx;
+
+    for ( cycle = 0; cycle < cycles; cycle++ )
+    {
+        for ( msgIdx = 0; msgIdx < pData->size; msgIdx++ )
+        {
+            PSPLP_TEST_MESSAGE pMsg = &pData->MessageArray[ msgIdx ];
+            enum test_status result = validate_session_message( &session, &pMsg->msg );
+
+            pLoop->valid += result == MESSAGE_VALID;
+            pLoop->wrong += result != pMsg->expectedTestStatus;
+        }
+    }
+    pLoop->ticks = SplpReadTsc( ) - begin;
+}
+
+
+
+
+static void SplpEmbedInline(
+    PSPLP_TEST_DATA pData,
+    unsigned int cycles,
+    PSPLP_EMBED_LOOP pLoop )
+{
+    struct Session session = { INIT, REASON_NONE };
+    unsigned long long begin = SplpReadTsc( );
+    unsigned int cycle;
+    unsigned int msgIdx;
+
+    for ( cycle = 0; cycle < cycles; cycle++ )
+    {
+        for ( msgIdx = 0; msgIdx < pData->size; msgIdx++ )
+        {
+            PSPLP_TEST_MESSAGE pMsg = &pData->MessageArray[ msgIdx ];
+            enum test_status result = splp_validate_session_inline( &session, &pMsg->msg );
+
+            pLoop->valid += result == MESSAGE_VALID;
+            pLoop->wrong += result != pMsg->expectedTestStatus;
+        }
+    }
+    pLoop->ticks = SplpReadTsc( ) - begin;
+}
+
+
+
+
+SPLP_STATUS SplpEmbedBenchmark(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_DATA pData )
+{
+    SPLP_EMBED_LOOP best[ 2 ];
+    double ticksPerSecond = SplpTscTicksPerSecond( );
+    double messages = (double) pOptions->cycleCount * pData->size;
+    double ns[ 2 ];
+    unsigned int round;
+    unsigned int loop;
+
+    if ( pData->size == 0 || pOptions->cycleCount == 0 )
+    {
+        printf( "***ERROR*** The embedding benchmark needs test messages\n" );
+        return SPLP_STATUS_ERROR;
+    }
+
+    memset( best, 0, sizeof( best ) );
+    for ( round = 0; round < SPLP_EMBED_ROUNDS; round++ )
+    {
+        SPLP_EMBED_LOOP result[ 2 ];
+
+        memset( result, 0, sizeof( result ) );
+        SplpEmbedLibrary( pData, pOptions->cycleCount, &result[ 0 ] );
+        SplpEmbedInline( pData, pOptions->cycleCount, &result[ 1 ] );
+        for ( loop = 0; loop < 2; loop++ )
+        {
+            if ( round == 0 || result[ loop ].ticks < best[ loop ].ticks )
+                best[ loop ] = result[ loop ];
+        }
+    }
+
+    for ( loop = 0; loop < 2; loop++ )
+        ns[ loop ] = best[ loop ].ticks * 1e9 / ticksPerSecond / messages;
+
+    printf(
+        "======================================================================\n"
+        " EMBEDDED RECEIVE LOOP:\n"
+        "======================================================================\n"
+        "\tMessages per pass:\t%14.0f\n"
+        "\tPasses:           \t%14u\n\n",
+        messages,
+        SPLP_EMBED_ROUNDS );
+    printf( "\t%-10s %12s %12s %14s %10s\n", "Loop", "ns/msg", "Mmsg/s", "Valid", "Wrong" );
+    for ( loop = 0; loop < 2; loop++ )
+    {
+        printf( "\t%-10s %12.2f %12.2f %14llu %10llu\n",
+            loop == 0 ? "library" : "inline",
+            ns[ loop ],
+            ns[ loop ] > 0 ? 1e3 / ns[ loop ] : 0,
+            best[ loop ].valid,
+            best[ loop ].wrong );
+    }
+    printf( "\n\tInline speedup:   \t%14.2fx\n", ns[ 1 ] > 0 ? ns[ 0 ] / ns[ 1 ] : 0 );
+    printf( "======================================================================\n" );
+
+    if ( best[ 0 ].wrong || best[ 1 ].wrong )
+    {
+        printf( "***ERROR*** The receive loops returned wrong verdicts\n" );
+        return SPLP_STATUS_ERROR;
+    }
+    return SPLP_STATUS_OK;
+}
@@ -0,0 +1,29 @@
+/*
+* SPLPEMBED.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the benchmark of the validator
+* embedded into a receive loop, see splpinline.h.
+*/
+#ifndef SPLPEMBED_H
+#define SPLPEMBED_H
+
+#include "splptest.h"
+
+
+
+#define SPLP_EMBED_ROUNDS         5       /* passes of each loop, the fastest counts */
+
+
+
+
+/* SplpEmbedBenchmark
+* Runs the test messages pOptions->cycleCount times through a receive
+* loop which calls validate_session_message( ) of SPLPv1.c and through
+* the same loop with the validator of splpinline.h expanded into it,
+* and prints the time per message of both.
+*/
+SPLP_STATUS SplpEmbedBenchmark(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_DATA pData );
+
+#endif /* SPLPEMBED_H */
@@ -0,0 +1,141 @@
+/*
+* SPLPENGINE.c
+* The file is part of practical task for System programming course.
+* This file contains the list of validation engines.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "splpengine.h"
+#include "splpbranchless.h"
+#include "splptable.h"
+
+
+
+#define SPLP_ENGINE_SLICE         3       /* payload bytes per slice of the sliced engine */
+#define SPLP_ENGINE_LANES         4       /* copies of the session in the batch engine */
+
+
+
+
+/* SplpEngineSliced
+* validate_session_slice( ) run to completion in slices of a few bytes,
+* so most payloads are suspended and resumed at least once.
+*/
+static enum test_status SplpEngineSliced(
+    struct Session* pSession,
+    struct Message* pMsg )
+{
+    struct Scan scan = { 0 };
+    enum test_status result;
+    int done;
+
+    do
+    {
+        result = validate_session_slice( pSession, pMsg, &scan, SPLP_ENGINE_SLICE, &done );
+    } while ( !done );
+
+    return result;
+}
+
+
+
+
+/* SplpEngineBounded
+* validate_session_message_n( ) of a copy of the text in a heap block of
+* exactly its length, without the terminator, so address sanitizer
+* catches a read past the end.
+*/
+static enum test_status SplpEngineBounded(
+    struct Session* pSession,
+    struct Message* pMsg )
+{
+    size_t length = strlen( pMsg->text_message );
+    char* pText = (char*) malloc( length ? length : 1 );
+    enum test_status result;
+
+    if ( !pText )
+        abort( );
+    memcpy( pText, pMsg->text_message, length );
+    result = validate_session_message_n( pSession, pMsg->direction, pText, length );
+    free( pText );
+
+    return result;
+}
+
+
+
+
+/* SplpEngineBatch
+* validate_session_batch( ) of the message in SPLP_ENGINE_LANES copies
+* of the session, different sessions in one call, so the control states
+* go through the compare of several messages at once. Copies which
+* disagree are reported as a verdict which is neither MESSAGE_VALID nor
+* MESSAGE_INVALID.
+*/
+static enum test_status SplpEngineBatch(
+    struct Session* pSession,
+    struct Message* pMsg )
+{
+    struct Session sessions[ SPLP_ENGINE_LANES ];
+    struct Session* pSessions[ SPLP_ENGINE_LANES ];
+    struct Message* pMessages[ SPLP_ENGINE_LANES ];
+    enum test_status results[ SPLP_ENGINE_LANES ];
+    unsigned int i;
+
+    for ( i = 0; i < SPLP_ENGINE_LANES; i++ )
+    {
+        sessions[ i ] = *pSession;
+        pSessions[ i ] = &sessions[ i ];
+        pMessages[ i ] = pMsg;
+    }
+
+    validate_session_batch( pSessions, pMessages, results, SPLP_ENGINE_LANES );
+
+    *pSession = sessions[ 0 ];
+    for ( i = 1; i < SPLP_ENGINE_LANES; i++ )
+    {
+        if ( results[ i ] != results[ 0 ] || sessions[ i ].state != sessions[ 0 ].state ||
+             sessions[ i ].reason != sessions[ 0 ].reason )
+            return (enum test_status) -1;
+    }
+    return results[ 0 ];
+}
+
+
+
+
+/* SplpEngineTable
+* SplpTableValidate( ) on a slot which holds the session, the compare
+* and swap commit of the lock-free table without other threads.
+*/
+static enum test_status SplpEngineTable(
+    struct Session* pSession,
+    struct Message* pMsg )
+{
+    SPLP_TABLE_SLOT slot;
+    unsigned int retries = 0;
+    enum test_status result;
+
+    slot.key = 1;
+    slot.word = pSession->state | (unsigned int) pSession->reason << 8;
+    result = SplpTableValidate( &slot, pMsg, &retries );
+    pSession->state = (unsigned char) ( slot.word & 0xff );
+    pSession->reason = (unsigned char) ( slot.word >> 8 );
+
+    return result;
+}
+
+
+
+
+const SPLP_ENGINE SplpEngines[ ] =
+{
+    { "early-exit", validate_session_message },
+    { "branchless", validate_session_message_branchless },
+    { "sliced",     SplpEngineSliced },
+    { "bounded",    SplpEngineBounded },
+    { "batch",      SplpEngineBatch },
+    { "table",      SplpEngineTable },
+};
+
+const unsigned int SplpEngineCount = sizeof( SplpEngines ) / sizeof( SplpEngines[ 0 ] );
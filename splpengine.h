@@ -0,0 +1,31 @@
+/*
+* SPLPENGINE.h
+* The file is part of practical task for System programming course.
+* This file contains the list of validation engines. Every engine must
+* give the same verdicts, reasons and transitions; the fuzz target and
+* the engine benchmark run all of them.
+*/
+#ifndef SPLPENGINE_H
+#define SPLPENGINE_H
+
+#include "splpv1.h"
+
+
+
+/* SPLP_ENGINE
+* A validator which keeps its state in the session it is given.
+*/
+typedef struct _SPLP_ENGINE
+{
+    const char*        name;
+    enum test_status ( *validate )( struct Session* pSession, struct Message* pMsg );
+
+}SPLP_ENGINE, *PSPLP_ENGINE;
+
+
+
+
+extern const SPLP_ENGINE  SplpEngines[ ];
+extern const unsigned int SplpEngineCount;
+
+#endif /* SPLPENGINE_H */
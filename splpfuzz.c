@@ -0,0 +1,248 @@
+/*
+* SPLPFUZZ.c
+* The file is part of practical task for System programming course.
+* This file contains the differential fuzz target. Every input is a
+* sequence of messages which is validated by the reference validator
+* and by every engine of SPLPENGINE.c, and by validate_message( ), each
+* with its own session.
+* The target aborts as soon as an engine disagrees with the reference
+* on the verdict, the reject reason or the state after a message.
+*
+* Input uses the test file format, one message per line:
+*     <expected>\t<direction>\t<text>
+* The expected verdict is ignored. Lines of other shape are taken as
+* the text, the lowest bit of their first byte selects the direction.
+* Test files are therefore ready-made seeds.
+*
+* The file is not part of test.vcxproj, it has its own entry point:
+*     clang -g -O1 -fsanitize=fuzzer,address splpfuzz.c splpref.c \
+*         splpengine.c splpv1.c splpbranchless.c splptable.c
+*     ./a.out -dict=... seeds/            (seeds/ holds test files)
+* AFL++ builds the same target with afl-clang-fast and -fsanitize=fuzzer.
+* With SPLP_FUZZ_STANDALONE defined, main( ) replays the files given on
+* the command line, or stdin, through the target, e.g. to reproduce a
+* crash file without libFuzzer.
+*/
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "splpv1.h"
+#include "splpref.h"
+#include "splpengine.h"
+
+
+
+#define SPLP_FUZZ_MAX_MESSAGES    256     /* longer inputs are cut */
+
+
+
+
+/* SplpFuzzValidateGlobal
+* validate_message( ) with the built-in session, swapped in and out.
+*/
+static enum test_status SplpFuzzValidateGlobal(
+    struct Session* pSession,
+    struct Message* pMsg )
+{
+    enum test_status result;
+
+    set_state( (enum State) pSession->state );
+    result = validate_message( pMsg );
+    pSession->state = (unsigned char) get_state( );
+    if ( result == MESSAGE_INVALID )
+        pSession->reason = (unsigned char) get_reason( );
+    return result;
+}
+
+
+
+
+#define SPLP_FUZZ_MAX_ENGINES     16
+
+
+
+
+static void SplpFuzzReport(
+    const char* engine,
+    unsigned int msgIdx,
+    const struct Message* pMsg,
+    const char* what,
+    unsigned int expected,
+    unsigned int actual )
+{
+    fprintf( stderr,
+        "***ERROR*** %s diverges from the reference at message %u\n"
+        "\tDirection: %s\n"
+        "\tMessage:   \"%s\"\n"
+        "\t%s: reference %u, engine %u\n",
+        engine,
+        msgIdx,
+        pMsg->direction == A_TO_B ? "A->B" : "B->A",
+        pMsg->text_message,
+        what,
+        expected,
+        actual );
+    abort( );
+}
+
+
+
+
+/* SplpFuzzNextMessage
+* Cuts the next line of the input into a message. The text is copied
+* into a buffer of its exact size, so reads past the terminator are
+* caught by AddressSanitizer.
+*/
+static size_t SplpFuzzNextMessage(
+    const unsigned char* pData,
+    size_t size,
+    struct Message* pMsg )
+{
+    const unsigned char* pLine = pData;
+    const unsigned char* pEnd = (const unsigned char*) memchr( pData, '\n', size );
+    size_t lineSize = pEnd ? (size_t) ( pEnd - pData ) : size;
+    size_t consumed = pEnd ? lineSize + 1 : lineSize;
+
+    if ( lineSize >= 4 && pLine[ 1 ] == '\t' && pLine[ 3 ] == '\t' )
+    {
+        pMsg->direction = pLine[ 2 ] == '1' ? B_TO_A : A_TO_B;
+        pLine += 4;
+        lineSize -= 4;
+    }
+    else if ( lineSize > 0 )
+    {
+        pMsg->direction = ( pLine[ 0 ] & 1 ) ? B_TO_A : A_TO_B;
+        pLine++;
+        lineSize--;
+    }
+    else
+    {
+        pMsg->direction = A_TO_B;
+    }
+
+    pMsg->text_message = (char*) malloc( lineSize + 1 );
+    if ( !pMsg->text_message )
+        abort( );
+    memcpy( pMsg->text_message, pLine, lineSize );
+    pMsg->text_message[ lineSize ] = '\0';
+    return consumed;
+}
+
+
+
+
+int LLVMFuzzerTestOneInput(
+    const unsigned char* pData,
+    size_t size )
+{
+    struct Session reference = { INIT, REASON_NONE };
+    struct Session sessions[ SPLP_FUZZ_MAX_ENGINES ];
+    SPLP_ENGINE engines[ SPLP_FUZZ_MAX_ENGINES ];
+    unsigned int engineCount = 0;
+    unsigned int msgIdx;
+    unsigned int i;
+
+    for ( i = 0; i < SplpEngineCount && engineCount < SPLP_FUZZ_MAX_ENGINES - 1; i++ )
+        engines[ engineCount++ ] = SplpEngines[ i ];
+    engines[ engineCount ].name = "validate_message";
+    engines[ engineCount ].validate = SplpFuzzValidateGlobal;
+    engineCount++;
+
+    memset( sessions, 0, sizeof( sessions ) );
+
+    for ( msgIdx = 0; size > 0 && msgIdx < SPLP_FUZZ_MAX_MESSAGES; msgIdx++ )
+    {
+        struct Message msg;
+        enum test_status expected;
+        size_t consumed = SplpFuzzNextMessage( pData, size, &msg );
+
+        pData += consumed;
+        size -= consumed;
+
+        expected = validate_reference_message( &reference, &msg );
+
+        for ( i = 0; i < engineCount; i++ )
+        {
+            enum test_status actual = engines[ i ].validate( &sessions[ i ], &msg );
+
+            if ( actual != expected )
+                SplpFuzzReport( engines[ i ].name, msgIdx, &msg, "Verdict", expected, actual );
+            if ( sessions[ i ].state != reference.state )
+                SplpFuzzReport( engines[ i ].name, msgIdx, &msg, "State", reference.state, sessions[ i ].state );
+            if ( expected == MESSAGE_INVALID && sessions[ i ].reason != reference.reason )
+                SplpFuzzReport( engines[ i ].name, msgIdx, &msg, "Reason", reference.reason, sessions[ i ].reason );
+        }
+
+        free( msg.text_message );
+    }
+
+    return 0;
+}
+
+
+
+
+#if defined( SPLP_FUZZ_STANDALONE )
+
+static int SplpFuzzRunFile(
+    FILE* fInput )
+{
+    unsigned char* pData = NULL;
+    size_t size = 0;
+    size_t capacity = 0;
+    size_t read;
+
+    do
+    {
+        if ( size == capacity )
+        {
+            unsigned char* pGrown;
+            capacity = capacity ? capacity * 2 : 65536;
+            pGrown = (unsigned char*) realloc( pData, capacity );
+            if ( !pGrown )
+            {
+                free( pData );
+                return 1;
+            }
+            pData = pGrown;
+        }
+        read = fread( pData + size, 1, capacity - size, fInput );
+        size += read;
+    } while ( read > 0 );
+
+    LLVMFuzzerTestOneInput( pData, size );
+    free( pData );
+    return 0;
+}
+
+
+
+
+int main( int argc, char* argv[ ] )
+{
+    int i;
+
+    if ( argc < 2 )
+        return SplpFuzzRunFile( stdin );
+
+    for ( i = 1; i < argc; i++ )
+    {
+        FILE* fInput = fopen( argv[ i ], "rb" );
+        if ( !fInput )
+        {
+            printf( "***ERROR*** File \"%s\" can't be opened\n", argv[ i ] );
+            return 1;
+        }
+        if ( SplpFuzzRunFile( fInput ) )
+        {
+            fclose( fInput );
+            return 1;
+        }
+        fclose( fInput );
+    }
+    return 0;
+}
+
+#endif
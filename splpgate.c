@@ -0,0 +1,576 @@
+/*
+* SPLPGATE.c
+* The file is part of practical task for System programming course.
+* This file contains the performance regression gate. Every scenario
+* keeps its raw samples in the JSON results. The gate reads the results
+* of several process runs of the baseline and of the current build,
+* takes the median of every run as one sample, and tests whether the
+* current runs come from a slower distribution (Mann-Whitney U). Samples
+* of one run share its code layout, frequency and neighbours and say
+* nothing about the variance between runs, so they are not compared
+* directly.
+*/
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "splpgate.h"
+#include "splplog.h"
+
+
+
+#define SPLP_GATE_LINE_SIZE       4096
+#define SPLP_GATE_NAME_SIZE       512
+
+
+
+
+/* SPLP_GATE_SCENARIO
+* One scenario collected from all results files, one median per run.
+*/
+typedef struct _SPLP_GATE_SCENARIO
+{
+    char               name[ SPLP_BENCH_NAME_SIZE ];
+    double             runs[ 2 ][ SPLP_GATE_MAX_RUNS ];    /* baseline, current */
+    unsigned int       runCount[ 2 ];
+    double             p;              /* one-sided p of a slowdown */
+
+}SPLP_GATE_SCENARIO, *PSPLP_GATE_SCENARIO;
+
+
+
+
+/* SPLP_GATE_RUNS
+* Scenarios of the compared runs and the time span of every side.
+*/
+typedef struct _SPLP_GATE_RUNS
+{
+    PSPLP_GATE_SCENARIO pScenarios;
+    unsigned int       count;
+    unsigned int       capacity;
+    unsigned int       files[ 2 ];
+    long long          first[ 2 ];     /* earliest and latest start of a run */
+    long long          last[ 2 ];
+
+}SPLP_GATE_RUNS, *PSPLP_GATE_RUNS;
+
+
+
+
+static int SplpGateCompareDouble(
+    const void* pLeft,
+    const void* pRight )
+{
+    double left = *(const double*) pLeft;
+    double right = *(const double*) pRight;
+    return left < right ? -1 : left > right ? 1 : 0;
+}
+
+
+
+
+static double SplpGateMedian(
+    const double* pSamples,
+    unsigned int count )
+{
+    double sorted[ SPLP_GATE_MAX_RUNS > SPLP_BENCH_SAMPLES ? SPLP_GATE_MAX_RUNS : SPLP_BENCH_SAMPLES ];
+
+    memcpy( sorted, pSamples, count * sizeof( double ) );
+    qsort( sorted, count, sizeof( double ), SplpGateCompareDouble );
+    return count % 2 ? sorted[ count / 2 ] : ( sorted[ count / 2 - 1 ] + sorted[ count / 2 ] ) / 2;
+}
+
+
+
+
+/* SplpGateBootstrap
+* 95% confidence interval of the median by the percentile bootstrap.
+*/
+static void SplpGateBootstrap(
+    const double* pSamples,
+    unsigned int count,
+    double* pLow,
+    double* pHigh )
+{
+    static double medians[ SPLP_GATE_BOOTSTRAP ];
+    double resample[ SPLP_GATE_MAX_RUNS > SPLP_BENCH_SAMPLES ? SPLP_GATE_MAX_RUNS : SPLP_BENCH_SAMPLES ];
+    unsigned long long seed = 0x853c49e6748fea9bull;
+    unsigned int i;
+    unsigned int j;
+
+    for ( i = 0; i < SPLP_GATE_BOOTSTRAP; i++ )
+    {
+        for ( j = 0; j < count; j++ )
+        {
+            seed ^= seed >> 12;
+            seed ^= seed << 25;
+            seed ^= seed >> 27;
+            resample[ j ] = pSamples[ ( ( seed * 2685821657736338717ull ) >> 33 ) % count ];
+        }
+        medians[ i ] = SplpGateMedian( resample, count );
+    }
+
+    qsort( medians, SPLP_GATE_BOOTSTRAP, sizeof( double ), SplpGateCompareDouble );
+    *pLow = medians[ SPLP_GATE_BOOTSTRAP * 25 / 1000 ];
+    *pHigh = medians[ SPLP_GATE_BOOTSTRAP * 975 / 1000 - 1 ];
+}
+
+
+
+
+/* SplpGateMannWhitney
+* One-sided p-value of the hypothesis that current samples are not
+* larger than baseline samples. The few runs of a gate are too few for
+* the normal approximation of U, so the exact distribution is used:
+* the number of orderings with U = u is the coefficient of q^u of the
+* Gaussian binomial [ n + m, n ]. A tie counts one half and U is then
+* rounded down, which only makes the p-value larger.
+*/
+static double SplpGateMannWhitney(
+    const double* pCurrent,
+    unsigned int currentCount,
+    const double* pBaseline,
+    unsigned int baselineCount )
+{
+    static double ways[ SPLP_GATE_MAX_RUNS * SPLP_GATE_MAX_RUNS + 1 ];
+    unsigned int maxU = currentCount * baselineCount;
+    unsigned int u2 = 0;
+    double tail = 0;
+    double total = 0;
+    unsigned int i;
+    unsigned int j;
+    unsigned int k;
+
+    for ( i = 0; i < currentCount; i++ )
+    {
+        for ( j = 0; j < baselineCount; j++ )
+            u2 += pCurrent[ i ] > pBaseline[ j ] ? 2 : pCurrent[ i ] == pBaseline[ j ] ? 1 : 0;
+    }
+
+    /* prod over i of ( 1 - q^( m + i ) ) / ( 1 - q^i ), i = 1..n */
+    memset( ways, 0, ( maxU + 1 ) * sizeof( ways[ 0 ] ) );
+    ways[ 0 ] = 1;
+    for ( i = 1; i <= currentCount; i++ )
+    {
+        for ( k = maxU; k >= baselineCount + i && k <= maxU; k-- )
+            ways[ k ] -= ways[ k - baselineCount - i ];
+        for ( k = i; k <= maxU; k++ )
+            ways[ k ] += ways[ k - i ];
+    }
+
+    for ( k = 0; k <= maxU; k++ )
+    {
+        total += ways[ k ];
+        if ( k >= u2 / 2 )
+            tail += ways[ k ];
+    }
+    return tail / total;
+}
+
+
+
+
+SPLP_STATUS SplpGateWrite(
+    PSPLP_BENCH pBench,
+    const char* fileName )
+{
+    FILE* fOutput = fopen( fileName, "w" );
+    const char* separator = "";
+    unsigned int i;
+    unsigned int j;
+
+    if ( !fOutput )
+    {
+        printf( "***ERROR*** Results file \"%s\" can't be created\n", fileName );
+        return SPLP_STATUS_ERROR;
+    }
+
+    fprintf( fOutput,
+        "{\n"
+        "  \"build\": \"%s\",\n"
+        "  \"started\": %lld,\n"
+        "  \"tsc_hz\": %.0f,\n"
+        "  \"samples_per_scenario\": %u,\n"
+        "  \"scenarios\": [\n",
+        SPLP_BUILD_ID,
+        (long long) pBench->started,
+        pBench->ticksPerSecond,
+        SPLP_BENCH_SAMPLES );
+
+    /* one scenario per line, SplpGateReadRuns( ) depends on it */
+    for ( i = 0; i < pBench->count; i++ )
+    {
+        PSPLP_BENCH_RESULT pResult = &pBench->pResults[ i ];
+        double low;
+        double high;
+
+        if ( pResult->iterations == 0 )
+            continue;
+
+        SplpGateBootstrap( pResult->samples, SPLP_BENCH_SAMPLES, &low, &high );
+        fprintf( fOutput, "%s    {\"name\": \"%s\", \"state\": \"%s\", \"bytes\": %u, "
+            "\"median_ns\": %.4f, \"ci95_low_ns\": %.4f, \"ci95_high_ns\": %.4f, \"counters\": {",
+            separator,
+            pResult->pScenario->name,
+            SplpLogStateName( pResult->pScenario->state ),
+            pResult->pScenario->length,
+            pResult->median,
+            low,
+            high );
+
+        for ( j = 0; j < SPLP_PERF_COUNTER_COUNT; j++ )
+        {
+            if ( pResult->counters[ j ] < 0 )
+                fprintf( fOutput, "%s\"%s\": null", j ? ", " : "", SplpPerfCounterName( (SPLP_PERF_COUNTER) j ) );
+            else
+                fprintf( fOutput, "%s\"%s\": %.4f", j ? ", " : "", SplpPerfCounterName( (SPLP_PERF_COUNTER) j ), pResult->counters[ j ] );
+        }
+
+        fprintf( fOutput, "}, \"samples_ns\": [" );
+        for ( j = 0; j < SPLP_BENCH_SAMPLES; j++ )
+            fprintf( fOutput, "%s%.4f", j ? ", " : "", pResult->samples[ j ] );
+        fprintf( fOutput, "]}" );
+        separator = ",\n";
+    }
+
+    fprintf( fOutput, "\n  ]\n}\n" );
+
+    if ( fclose( fOutput ) != 0 )
+    {
+        printf( "***ERROR*** Results file \"%s\" can't be written\n", fileName );
+        return SPLP_STATUS_ERROR;
+    }
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+/* SplpGateParseScenario
+* Reads name and samples from a scenario line of a results file.
+* Returns 0 if the line is not a scenario.
+*/
+static int SplpGateParseScenario(
+    const char* line,
+    char* name,
+    double* pSamples,
+    unsigned int* pCount )
+{
+    const char* pName = strstr( line, "\"name\": \"" );
+    const char* pValues = strstr( line, "\"samples_ns\": [" );
+    const char* pEnd;
+    size_t nameLength;
+
+    if ( !pName || !pValues )
+        return 0;
+
+    pName += 9;
+    pEnd = strchr( pName, '"' );
+    nameLength = pEnd ? (size_t) ( pEnd - pName ) : 0;
+    if ( nameLength == 0 || nameLength >= SPLP_BENCH_NAME_SIZE )
+        return 0;
+    memcpy( name, pName, nameLength );
+    name[ nameLength ] = '\0';
+
+    pValues += 15;
+    *pCount = 0;
+    while ( *pCount < SPLP_BENCH_SAMPLES )
+    {
+        char* pNext;
+        double sample = strtod( pValues, &pNext );
+        if ( pNext == pValues )
+            break;
+        pSamples[ ( *pCount )++ ] = sample;
+        pValues = *pNext == ',' ? pNext + 1 : pNext;
+    }
+    return *pCount > 0;
+}
+
+
+
+
+static PSPLP_GATE_SCENARIO SplpGateFindScenario(
+    PSPLP_GATE_RUNS pRuns,
+    const char* name )
+{
+    unsigned int i;
+
+    for ( i = 0; i < pRuns->count; i++ )
+    {
+        if ( 0 == strcmp( pRuns->pScenarios[ i ].name, name ) )
+            return &pRuns->pScenarios[ i ];
+    }
+
+    if ( pRuns->count == pRuns->capacity )
+    {
+        unsigned int capacity = pRuns->capacity ? pRuns->capacity * 2 : 64;
+        PSPLP_GATE_SCENARIO pScenarios = (PSPLP_GATE_SCENARIO) realloc( pRuns->pScenarios,
+            capacity * sizeof( SPLP_GATE_SCENARIO ) );
+        if ( !pScenarios )
+            return NULL;
+        pRuns->pScenarios = pScenarios;
+        pRuns->capacity = capacity;
+    }
+
+    memset( &pRuns->pScenarios[ pRuns->count ], 0, sizeof( SPLP_GATE_SCENARIO ) );
+    strcpy( pRuns->pScenarios[ pRuns->count ].name, name );
+    return &pRuns->pScenarios[ pRuns->count++ ];
+}
+
+
+
+
+/* SplpGateReadRuns
+* Adds the median of every scenario of a comma separated list of
+* results files to one side of the comparison, one file per run.
+*/
+static SPLP_STATUS SplpGateReadRuns(
+    PSPLP_GATE_RUNS pRuns,
+    unsigned int side,
+    const char* fileNames )
+{
+    char fileName[ SPLP_GATE_NAME_SIZE ];
+    char line[ SPLP_GATE_LINE_SIZE ];
+    char name[ SPLP_BENCH_NAME_SIZE ];
+    double samples[ SPLP_BENCH_SAMPLES ];
+    unsigned int sampleCount;
+
+    while ( *fileNames )
+    {
+        const char* pComma = strchr( fileNames, ',' );
+        size_t length = pComma ? (size_t) ( pComma - fileNames ) : strlen( fileNames );
+        long long started = -1;
+        FILE* fInput;
+
+        if ( length == 0 || length >= sizeof( fileName ) )
+        {
+            printf( "***ERROR*** Bad results file name in \"%s\"\n", fileNames );
+            return SPLP_STATUS_ERROR;
+        }
+        memcpy( fileName, fileNames, length );
+        fileName[ length ] = '\0';
+        fileNames += pComma ? length + 1 : length;
+
+        if ( pRuns->files[ side ] == SPLP_GATE_MAX_RUNS )
+        {
+            printf( "***ERROR*** More than %u results files on one side\n", SPLP_GATE_MAX_RUNS );
+            return SPLP_STATUS_ERROR;
+        }
+
+        fInput = fopen( fileName, "r" );
+        if ( !fInput )
+        {
+            printf( "***ERROR*** Results file \"%s\" can't be opened\n", fileName );
+            return SPLP_STATUS_ERROR;
+        }
+
+        while ( fgets( line, sizeof( line ), fInput ) )
+        {
+            const char* pStarted = strstr( line, "\"started\": " );
+            PSPLP_GATE_SCENARIO pScenario;
+
+            if ( pStarted )
+            {
+                started = strtoll( pStarted + 11, NULL, 10 );
+                continue;
+            }
+            if ( !SplpGateParseScenario( line, name, samples, &sampleCount ) )
+                continue;
+
+            pScenario = SplpGateFindScenario( pRuns, name );
+            if ( !pScenario )
+            {
+                fclose( fInput );
+                return SPLP_STATUS_ERROR;
+            }
+            if ( pScenario->runCount[ side ] < SPLP_GATE_MAX_RUNS )
+                pScenario->runs[ side ][ pScenario->runCount[ side ]++ ] = SplpGateMedian( samples, sampleCount );
+        }
+        fclose( fInput );
+
+        if ( pRuns->files[ side ] == 0 || started < pRuns->first[ side ] )
+            pRuns->first[ side ] = started;
+        if ( pRuns->files[ side ] == 0 || started > pRuns->last[ side ] )
+            pRuns->last[ side ] = started;
+        pRuns->files[ side ]++;
+    }
+
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+static int SplpGateCompareP(
+    const void* pLeft,
+    const void* pRight )
+{
+    return SplpGateCompareDouble( &( *(const PSPLP_GATE_SCENARIO*) pLeft )->p,
+        &( *(const PSPLP_GATE_SCENARIO*) pRight )->p );
+}
+
+
+
+
+/* SplpGateHolm
+* Holm's step-down correction: the scenarios are tested from the
+* smallest p-value up, the k-th of n against significance / ( n - k ),
+* and testing stops at the first which is not significant. Sets
+* pSignificant[ i ] for the scenarios which keep their significance.
+*/
+static SPLP_STATUS SplpGateHolm(
+    PSPLP_GATE_RUNS pRuns,
+    unsigned int* pSignificant )
+{
+    PSPLP_GATE_SCENARIO* pOrder = (PSPLP_GATE_SCENARIO*) malloc( pRuns->count * sizeof( PSPLP_GATE_SCENARIO ) + 1 );
+    unsigned int tested = 0;
+    unsigned int i;
+
+    if ( !pOrder )
+        return SPLP_STATUS_ERROR;
+
+    for ( i = 0; i < pRuns->count; i++ )
+    {
+        pSignificant[ i ] = 0;
+        if ( pRuns->pScenarios[ i ].runCount[ 0 ] && pRuns->pScenarios[ i ].runCount[ 1 ] )
+            pOrder[ tested++ ] = &pRuns->pScenarios[ i ];
+    }
+
+    qsort( pOrder, tested, sizeof( pOrder[ 0 ] ), SplpGateCompareP );
+    for ( i = 0; i < tested; i++ )
+    {
+        if ( pOrder[ i ]->p > SPLP_GATE_SIGNIFICANCE / ( tested - i ) )
+            break;
+        pSignificant[ pOrder[ i ] - pRuns->pScenarios ] = 1;
+    }
+
+    free( pOrder );
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+SPLP_STATUS SplpGateCompare(
+    const char* baselineFileNames,
+    const char* currentFileNames,
+    unsigned int threshold,
+    unsigned int* pRegressions )
+{
+    SPLP_GATE_RUNS runs;
+    unsigned int* pSignificant = NULL;
+    unsigned int compared = 0;
+    unsigned int i;
+    SPLP_STATUS status;
+
+    *pRegressions = 0;
+    memset( &runs, 0, sizeof( runs ) );
+
+    status = SplpGateReadRuns( &runs, 0, baselineFileNames );
+    if ( SPLP_STATUS_OK == status )
+        status = SplpGateReadRuns( &runs, 1, currentFileNames );
+    if ( SPLP_STATUS_OK == status && ( runs.files[ 0 ] < SPLP_GATE_MIN_RUNS || runs.files[ 1 ] < SPLP_GATE_MIN_RUNS ) )
+    {
+        printf( "***ERROR*** The gate needs results of at least %u runs of each build, got %u and %u\n",
+            SPLP_GATE_MIN_RUNS, runs.files[ 0 ], runs.files[ 1 ] );
+        status = SPLP_STATUS_ERROR;
+    }
+    if ( SPLP_STATUS_OK == status )
+    {
+        pSignificant = (unsigned int*) malloc( runs.count * sizeof( unsigned int ) + 1 );
+        if ( !pSignificant )
+            status = SPLP_STATUS_ERROR;
+    }
+    if ( SPLP_STATUS_OK != status )
+    {
+        free( runs.pScenarios );
+        return status;
+    }
+
+    for ( i = 0; i < runs.count; i++ )
+    {
+        PSPLP_GATE_SCENARIO pScenario = &runs.pScenarios[ i ];
+        pScenario->p = SplpGateMannWhitney( pScenario->runs[ 1 ], pScenario->runCount[ 1 ],
+            pScenario->runs[ 0 ], pScenario->runCount[ 0 ] );
+    }
+    status = SplpGateHolm( &runs, pSignificant );
+
+    printf(
+        "======================================================================\n"
+        " REGRESSION GATE:\n"
+        "======================================================================\n"
+        "\tBaseline runs:    \t%14u\n"
+        "\tCurrent runs:     \t%14u\n"
+        "\tThreshold:        \t%13u%%\n"
+        "\tSignificance:     \t%14.2f (Holm)\n\n",
+        runs.files[ 0 ],
+        runs.files[ 1 ],
+        threshold,
+        SPLP_GATE_SIGNIFICANCE );
+
+    /* runs of one build in a row share the state of the machine */
+    if ( runs.last[ 0 ] < runs.first[ 1 ] || runs.last[ 1 ] < runs.first[ 0 ] )
+    {
+        printf( "***WARNING*** The runs of the two builds weren't interleaved\n\n" );
+    }
+
+    printf( "\t%-22s %10s %10s %8s %8s  %s\n", "Benchmark", "Base ns", "Now ns", "Change", "p", "Verdict" );
+
+    for ( i = 0; SPLP_STATUS_OK == status && i < runs.count; i++ )
+    {
+        PSPLP_GATE_SCENARIO pScenario = &runs.pScenarios[ i ];
+        const char* verdict = "ok";
+        double base;
+        double now;
+        double change;
+        double baseLow;
+        double baseHigh;
+        double nowLow;
+        double nowHigh;
+
+        if ( !pScenario->runCount[ 0 ] || !pScenario->runCount[ 1 ] )
+            continue;
+
+        base = SplpGateMedian( pScenario->runs[ 0 ], pScenario->runCount[ 0 ] );
+        now = SplpGateMedian( pScenario->runs[ 1 ], pScenario->runCount[ 1 ] );
+        change = base > 0 ? ( now / base - 1 ) * 100 : 0;
+        SplpGateBootstrap( pScenario->runs[ 0 ], pScenario->runCount[ 0 ], &baseLow, &baseHigh );
+        SplpGateBootstrap( pScenario->runs[ 1 ], pScenario->runCount[ 1 ], &nowLow, &nowHigh );
+
+        /* a regression must be significant after the correction, larger
+        * than the threshold and large against the noise of the medians
+        */
+        if ( pSignificant[ i ] && change > threshold && nowLow > baseHigh )
+        {
+            verdict = "REGRESSION";
+            ( *pRegressions )++;
+        }
+        else if ( change < -(double) threshold && nowHigh < baseLow )
+        {
+            verdict = "faster";
+        }
+
+        printf( "\t%-22s %10.2f %10.2f %+7.1f%% %8.4f  %s\n",
+            pScenario->name, base, now, change, pScenario->p, verdict );
+        compared++;
+    }
+
+    printf( "\n\tCompared:         \t%14u\n"
+        "\tRegressions:      \t%14u\n"
+        "======================================================================\n",
+        compared,
+        *pRegressions );
+
+    free( pSignificant );
+    free( runs.pScenarios );
+
+    if ( SPLP_STATUS_OK == status && compared == 0 )
+    {
+        printf( "***ERROR*** The baseline and current results have no common benchmarks\n" );
+        return SPLP_STATUS_ERROR;
+    }
+    return status;
+}
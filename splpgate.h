@@ -0,0 +1,52 @@
+/*
+* SPLPGATE.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the performance regression gate.
+* Results of the micro benchmarks are saved as JSON, one file per run,
+* and the runs of two builds are compared scenario by scenario.
+*/
+#ifndef SPLPGATE_H
+#define SPLPGATE_H
+
+#include "splpbench.h"
+
+
+
+#define DEFAULT_GATE_THRESHOLD    5       /* percent the median may grow by */
+#define SPLP_GATE_SIGNIFICANCE    0.01    /* family-wise, one-sided Mann-Whitney U */
+#define SPLP_GATE_BOOTSTRAP       2000    /* resamples for the median CI */
+#define SPLP_GATE_MIN_RUNS        8       /* results files per build; 8 + 8 runs reach p = 1 / C( 16, 8 ) */
+#define SPLP_GATE_MAX_RUNS        32
+
+/* Build identification written to the results; define it on the
+* compiler command line, e.g. /DSPLP_BUILD_ID=\"<commit>\" */
+#if !defined( SPLP_BUILD_ID )
+#define SPLP_BUILD_ID             __DATE__ " " __TIME__
+#endif
+
+
+
+
+SPLP_STATUS SplpGateWrite(
+    PSPLP_BENCH pBench,
+    const char* fileName );
+
+
+
+
+/* SplpGateCompare
+* Compares the runs of a baseline build with the runs of the current
+* build, both comma separated lists of files written by SplpGateWrite( ),
+* and prints the comparison. The runs of the two builds should be taken
+* in turns. *pRegressions receives the number of scenarios which are
+* slower by more than threshold percent, significantly after Holm's
+* correction over all scenarios, and whose bootstrap confidence
+* intervals of the median don't overlap.
+*/
+SPLP_STATUS SplpGateCompare(
+    const char* baselineFileNames,
+    const char* currentFileNames,
+    unsigned int threshold,
+    unsigned int* pRegressions );
+
+#endif /* SPLPGATE_H */
@@ -0,0 +1,468 @@
+/*
+ * SPLPinline.h
+ * The file is part of practical task for System programming course.
+ * This file contains the SPLPv1 validator core as static inline
+ * functions. validate_session_message() in SPLPv1.c is this core
+ * behind a call; a packet loop which includes the header validates
+ * without the call, and the compiler can fold the state switch into
+ * the loop.
+ *
+ * Files built with SPLP_HEADER_ONLY defined get validate_session_message()
+ * as a macro for splp_validate_session_inline(), so the same source
+ * calls or expands the validator by a compiler flag. The character
+ * class table is defined in SPLPv1.c either way, one copy per program.
+ * The protocol keywords are spelled out here only.
+ *
+ * The core reads text up to end, or up to its terminator if end is NULL.
+ * Callers pass a constant NULL for NUL terminated text, and the compiler
+ * drops the bound checks from the inlined copy.
+ */
+#ifndef SPLPINLINE_H
+#define SPLPINLINE_H
+
+#include "splpv1.h"
+#include "splpprobe.h"
+#include "splpclass.h"
+#include <string.h>
+#include <stdint.h>
+#include "stdbool.h"
+
+// the literal compare loads 16 bytes of a message whatever its length,
+// which address sanitizer reports; such builds use strcmp() instead
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define SPLP_NO_LITERAL_SIMD
+#endif
+#endif
+#if (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)) && \
+	!defined(__SANITIZE_ADDRESS__) && !defined(SPLP_NO_LITERAL_SIMD)
+#define SPLP_LITERAL_SIMD
+#include <emmintrin.h>
+#endif
+
+// the state switch is expanded once for NUL terminated and once for
+// bounded text; a shared copy would test the bound on every byte
+#if defined(_MSC_VER)
+#define SPLP_ALWAYS_INLINE static __forceinline
+#elif defined(__GNUC__)
+#define SPLP_ALWAYS_INLINE static __inline __attribute__((always_inline))
+#else
+#define SPLP_ALWAYS_INLINE static __inline
+#endif
+
+
+struct splp_literal /* the only message allowed in a state */
+{
+	char			text[16];         /* zero padded for the 16 byte compare */
+	unsigned int	length;           /* 0 if the state allows other messages */
+	enum Direction	direction;
+	enum State		next;
+};
+
+static const struct splp_literal splp_literals[DISCONNECTING + 1] =
+{
+	{ "CONNECT",       7,  A_TO_B, CONNECTING },	// INIT
+	{ "CONNECT_OK",    10, B_TO_A, CONNECTED },		// CONNECTING
+	{ "", 0, A_TO_B, INIT },					// CONNECTED
+	{ "", 0, A_TO_B, INIT },					// WAITING_VER
+	{ "", 0, A_TO_B, INIT },					// WAITING_DATA
+	{ "", 0, A_TO_B, INIT },					// WAITING_B64_DATA
+	{ "DISCONNECT_OK", 13, B_TO_A, INIT },			// DISCONNECTING
+};
+
+
+// bytes >= 0x80 belong to no class
+static __inline bool splp_allowed(unsigned char set, char c)
+{
+	return (splp_char_class[(unsigned char)c] & set) != 0;
+}
+
+
+// true while pointer is inside the text; with a bound, a NUL byte is
+// text like any other, and no class allows it
+static __inline bool splp_more(const char* pointer, const char* end)
+{
+	return end ? pointer < end : *pointer != '\0';
+}
+
+
+// text[index], '\0' past the end; index is at most one past the bytes
+// checked before
+static __inline char splp_char(const char* text, const char* end, size_t index)
+{
+	return splp_more(text + index, end) ? text[index] : '\0';
+}
+
+
+// strncmp(text, prefix, length) == 0
+static __inline bool splp_starts(const char* text, const char* end, const char* prefix, size_t length)
+{
+	if (end)
+	{
+		return (size_t)(end - text) >= length && memcmp(text, prefix, length) == 0;
+	}
+	return strncmp(text, prefix, length) == 0;
+}
+
+
+// strcmp(text, literal) == 0
+static __inline bool splp_is(const char* text, const char* end, const char* literal, size_t length)
+{
+	if (end)
+	{
+		return (size_t)(end - text) == length && memcmp(text, literal, length) == 0;
+	}
+	return strcmp(text, literal) == 0;
+}
+
+
+// the data command the message starts with and its length, NULL if
+// none; every byte of the keyword is compared once
+static __inline const char* splp_data_command(const char* text, const char* end, size_t* length)
+{
+	if (!splp_starts(text, end, "GET_", 4))
+	{
+		return NULL;
+	}
+	switch (splp_char(text, end, 4))
+	{
+	case 'D':
+		*length = 8;
+		return splp_starts(text + 5, end, "ATA", 3) ? "GET_DATA" : NULL;
+	case 'F':
+		*length = 8;
+		return splp_starts(text + 5, end, "ILE", 3) ? "GET_FILE" : NULL;
+	case 'C':
+		*length = 11;
+		return splp_starts(text + 5, end, "OMMAND", 6) ? "GET_COMMAND" : NULL;
+	default:
+		return NULL;
+	}
+}
+
+
+// offset of the payload of a server response in WAITING_DATA or
+// WAITING_B64_DATA, after its keyword and the space; 0 if the message
+// doesn't start like a response of the state
+static __inline size_t splp_payload_start(enum State state, const char* text, const char* end)
+{
+	size_t commandLength;
+
+	if (state == WAITING_DATA)
+	{
+		return splp_data_command(text, end, &commandLength) != NULL && splp_char(text, end, commandLength) == ' ' ?
+			commandLength + 1 : 0;
+	}
+	if (state == WAITING_B64_DATA)
+	{
+		return splp_starts(text, end, "B64:", 4) && splp_char(text, end, 4) == ' ' ? 5 : 0;
+	}
+	return 0;
+}
+
+
+// strcmp(text, literal->text) == 0 as one 16 byte compare: the
+// literal and its terminator must match, the bytes after it don't
+// matter. A load which would cross into the next page falls back to
+// strcmp(), the bytes past the message may not be mapped. Bounded text
+// is compared by its length, nothing past end is read
+static __inline bool splp_equals_literal(const char* text, const char* end, const struct splp_literal* literal)
+{
+	if (end)
+	{
+		return splp_is(text, end, literal->text, literal->length);
+	}
+#ifdef SPLP_LITERAL_SIMD
+	if (((uintptr_t)text & 4095) <= 4096 - 16)
+	{
+		__m128i message;
+#if defined(__GNUC__)
+		// inlined into a caller, the compiler would see the load run
+		// past a short message array; it mustn't reason about it
+		__asm__("" : "+r"(text));
+#endif
+		message = _mm_loadu_si128((const __m128i*)text);
+		__m128i expected = _mm_loadu_si128((const __m128i*)literal->text);
+		unsigned int mask = (2u << literal->length) - 1;
+
+		return ((unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(message, expected)) & mask) == mask;
+	}
+#endif
+	return strcmp(text, literal->text) == 0;
+}
+
+
+static __inline enum test_status splp_reject(struct Session* session, enum Reason why)
+{
+	SPLP_PROBE_REJECT(session->state, why);
+	session->state = INIT;
+	session->reason = (unsigned char)why;
+	return MESSAGE_INVALID;
+}
+
+
+// The payload scans below are shared by the core and by the slices of
+// validate_session_slice(): they stop at the end of the payload, or at
+// stop if it isn't NULL, and return where they stopped.
+
+// one lookup per byte; the first byte outside of the payload class
+// must end the payload
+static __inline const char* splp_scan_data(const char* pointer, const char* end, const char* stop)
+{
+	while ((end == NULL || pointer < end) && (stop == NULL || pointer < stop) && splp_allowed(SPLP_CLASS_DATA, *pointer))
+	{
+		pointer++;
+	}
+	return pointer;
+}
+
+
+// the space and the command of the request after a scanned data payload
+static __inline enum test_status splp_data_suffix(struct Session* session, const char* pointer, const char* end,
+	const char* command, size_t commandLength)
+{
+	if (splp_more(pointer, end) && !splp_allowed(SPLP_CLASS_SPACE, *pointer))
+	{
+		return splp_reject(session, REASON_CHARACTER);
+	}
+	// the suffix starts after the scanned bytes and strcmp() stops
+	// within the length of command
+	if (!splp_more(pointer, end) || !splp_is(pointer + 1, end, command, commandLength)) {
+		return splp_reject(session, REASON_FORMAT);
+	}
+	session->state = CONNECTED;
+	return MESSAGE_VALID;
+}
+
+
+// all but the last two bytes of a base64 payload, which must be there;
+// stops early at a byte outside of the class, and the scan looks two
+// bytes ahead, which must not cross the terminator
+static __inline const char* splp_scan_b64(const char* pointer, const char* end, const char* stop)
+{
+	while (splp_more(pointer + 2, end) && (stop == NULL || pointer < stop) && splp_allowed(SPLP_CLASS_B64, *pointer))
+	{
+		pointer++;
+	}
+	return pointer;
+}
+
+
+// the last two bytes of a base64 payload starting at initialPointer,
+// pointer is the first of them
+static __inline enum test_status splp_b64_tail(struct Session* session, const char* initialPointer, const char* pointer)
+{
+	if (!splp_allowed(SPLP_CLASS_B64, *pointer))
+	{
+		if (!(*pointer == '=' && *(pointer + 1) == 61))
+		{
+			return splp_reject(session, REASON_CHARACTER);
+		}
+	}
+	else if (!splp_allowed(SPLP_CLASS_B64_PAD, *(pointer + 1)))
+	{
+		return splp_reject(session, REASON_CHARACTER);
+	}
+	if ((pointer + 2 - initialPointer) % 4 != 0)
+	{
+		return splp_reject(session, REASON_LENGTH);
+	}
+	session->state = CONNECTED;
+	return MESSAGE_VALID;
+}
+
+
+// INIT, CONNECTING and DISCONNECTING allow one message; the text is
+// checked before the direction, as the reason of a reject depends on it
+static __inline enum test_status splp_validate_literal(struct Session* session, enum Direction direction,
+	const char* text, const char* end, const struct splp_literal* literal)
+{
+	if (!splp_equals_literal(text, end, literal))
+	{
+		return splp_reject(session, REASON_UNEXPECTED);
+	}
+	if (direction != literal->direction)
+	{
+		return splp_reject(session, REASON_DIRECTION);
+	}
+	session->state = (unsigned char)literal->next;
+	return MESSAGE_VALID;
+}
+
+
+SPLP_ALWAYS_INLINE enum test_status splp_validate_state(struct Session* session, enum Direction direction,
+	const char* text, const char* end)
+{
+	switch (session->state)
+	{
+	case INIT:
+		//A->B CONNECT 2
+	case CONNECTING:
+		//A<-B CONNECT_OK 3
+	case DISCONNECTING:
+		//A<-B DISCONNECT_OK 1
+
+		return splp_validate_literal(session, direction, text, end, &splp_literals[session->state]);
+	case CONNECTED:
+		//A->B GET_VER 4
+		//A->B GET_DATA 5
+		//A->B GET_FILE 5
+		//A->B GET_COMMAND 5
+		//A->B GET_B64 6
+		//A->B DISCONNECTS 7
+
+		if (direction != A_TO_B)
+		{
+			return splp_reject(session, REASON_DIRECTION);
+		}
+
+		if (splp_is(text, end, "GET_DATA", 8) || splp_is(text, end, "GET_FILE", 8) || splp_is(text, end, "GET_COMMAND", 11))
+		{
+			session->state = WAITING_DATA;
+			return MESSAGE_VALID;
+		}
+		if (splp_is(text, end, "DISCONNECT", 10))
+		{
+			session->state = DISCONNECTING;
+			return MESSAGE_VALID;
+		}
+		if (splp_is(text, end, "GET_B64", 7))
+		{
+			session->state = WAITING_B64_DATA;
+			return MESSAGE_VALID;
+		}
+		if (splp_is(text, end, "GET_VER", 7))
+		{
+			session->state = WAITING_VER;
+			return MESSAGE_VALID;
+		}
+
+		SPLP_PROBE_REJECT(session->state, REASON_UNEXPECTED);
+		session->reason = REASON_UNEXPECTED;
+		return MESSAGE_INVALID;
+	case WAITING_VER:
+		//A<-B VERSION
+
+		if (direction != B_TO_A)
+		{
+			return splp_reject(session, REASON_DIRECTION);
+		}
+
+		if (splp_starts(text, end, "VERSION", 7))
+		{
+			if (splp_char(text, end, 7) != ' ') {
+				return splp_reject(session, REASON_FORMAT);
+			}
+			for (size_t i = 8; splp_more(text + i, end); i++)
+			{
+				if (!splp_allowed(SPLP_CLASS_DIGIT, text[i]))
+				{
+					return splp_reject(session, REASON_CHARACTER);
+				}
+			}
+
+			session->state = CONNECTED;
+			return MESSAGE_VALID;
+		}
+		return splp_reject(session, REASON_UNEXPECTED);
+	case WAITING_DATA:
+		//A<-B CMD data CMD
+
+		if (direction != B_TO_A)
+		{
+			return splp_reject(session, REASON_DIRECTION);
+		}
+		{
+			size_t commandLength;
+			const char* command = splp_data_command(text, end, &commandLength);
+			const char* pointer;
+
+			if (command == NULL)
+			{
+				break;
+			}
+			if (splp_char(text, end, commandLength) != ' ') {
+				return splp_reject(session, REASON_FORMAT);
+			}
+			pointer = text + commandLength + 1;
+			SPLP_PROBE_SCAN_START(session->state, pointer);
+			pointer = splp_scan_data(pointer, end, NULL);
+			SPLP_PROBE_SCAN_END(session->state, pointer - (text + commandLength + 1));
+
+			return splp_data_suffix(session, pointer, end, command, commandLength);
+		}
+	case WAITING_B64_DATA:
+		//A<-B B64
+
+		if (direction != B_TO_A)
+		{
+			return splp_reject(session, REASON_DIRECTION);
+		}
+		if (!splp_starts(text, end, "B64:", 4))
+		{
+			return splp_reject(session, REASON_UNEXPECTED);
+		}
+		if (splp_char(text, end, 4) != ' ') {
+			return splp_reject(session, REASON_FORMAT);
+		}
+		{
+			const char* initialPointer = text + 5;
+			const char* pointer = text + 5;
+
+			// the loop looks two bytes ahead, which must not cross the terminator
+			if (!splp_more(pointer, end) || !splp_more(pointer + 1, end))
+			{
+				return splp_reject(session, REASON_CHARACTER);
+			}
+			SPLP_PROBE_SCAN_START(session->state, pointer);
+			pointer = splp_scan_b64(pointer, end, NULL);
+			if (splp_more(pointer + 2, end))
+			{
+				return splp_reject(session, REASON_CHARACTER);
+			}
+			SPLP_PROBE_SCAN_END(session->state, pointer - initialPointer);
+
+			return splp_b64_tail(session, initialPointer, pointer);
+		}
+	default:
+		break;
+	}
+
+	return MESSAGE_VALID;
+}
+
+
+/* Same as validate_session_message(), expanded into the caller */
+static __inline enum test_status splp_validate_session_inline(struct Session* session, struct Message* msg)
+{
+	enum State from = (enum State)session->state;
+	enum test_status result;
+
+	SPLP_PROBE_ENTRY(session->state, msg->direction, msg->text_message);
+	result = splp_validate_state(session, msg->direction, msg->text_message, NULL);
+	SPLP_PROBE_TRANSITION(from, session->state, result);
+
+	return result;
+}
+
+
+/* Same as validate_session_message_n(), expanded into the caller */
+static __inline enum test_status splp_validate_session_inline_n(struct Session* session, enum Direction direction,
+	const char* text, size_t length)
+{
+	enum State from = (enum State)session->state;
+	enum test_status result;
+
+	SPLP_PROBE_ENTRY(session->state, direction, text);
+	result = splp_validate_state(session, direction, text, text + length);
+	SPLP_PROBE_TRANSITION(from, session->state, result);
+
+	return result;
+}
+
+#if defined(SPLP_HEADER_ONLY) && !defined(SPLP_LIBRARY)
+#define validate_session_message(session, msg) splp_validate_session_inline(session, msg)
+#define validate_session_message_n(session, direction, text, length) splp_validate_session_inline_n(session, direction, text, length)
+#endif
+
+#endif /* SPLPINLINE_H */
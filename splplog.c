@@ -0,0 +1,846 @@
+/*
+* SPLPLOG.c
+* The file is part of practical task for System programming course.
+* This file contains the columnar verdict log writer and the scanner
+* which aggregates a log file mapped into memory.
+*/
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "splpv1.h"
+#include "splplog.h"
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+
+#define SPLP_LOG_ALIGN( x )       ( ( ( x ) + 7u ) & ~7u )
+#define SPLP_LOG_VARINT_MAX       10      /* bytes of a 64-bit varint */
+#define SPLP_LOG_STATE_COUNT      16
+#define SPLP_LOG_REASON_COUNT     16
+
+
+
+
+static const char* SplpLogStateNames[ ] =
+{
+    "INIT", "CONNECTING", "CONNECTED", "WAITING_VER",
+    "WAITING_DATA", "WAITING_B64_DATA", "DISCONNECTING"
+};
+
+
+
+
+static const char* SplpLogReasonNames[ ] =
+{
+    "NONE", "DIRECTION", "UNEXPECTED", "FORMAT", "CHARACTER", "LENGTH"
+};
+
+
+
+
+static const char* SplpLogCommandNames[ ] =
+{
+    "UNKNOWN", "CONNECT", "CONNECT_OK", "GET_VER", "GET_DATA", "GET_FILE",
+    "GET_COMMAND", "GET_B64", "DISCONNECT", "DISCONNECT_OK", "VERSION", "B64"
+};
+
+
+
+
+/* Worst case size of every column for a full block */
+static const unsigned int SplpLogColumnCapacity[ SPLP_LOG_COLUMN_COUNT ] =
+{
+    SPLP_LOG_BLOCK_EVENTS * SPLP_LOG_VARINT_MAX,
+    SPLP_LOG_BLOCK_EVENTS * 5,
+    SPLP_LOG_BLOCK_EVENTS / 2,
+    SPLP_LOG_BLOCK_EVENTS / 2,
+    SPLP_LOG_BLOCK_EVENTS / 2,
+    SPLP_LOG_BLOCK_EVENTS / 8,
+    SPLP_LOG_BLOCK_EVENTS / 8,
+    SPLP_LOG_BLOCK_EVENTS * 5
+};
+
+
+
+
+static unsigned int SplpLogPutVarint(
+    unsigned char* pOut,
+    unsigned long long value )
+{
+    unsigned int size = 0;
+    while ( value >= 0x80 )
+    {
+        pOut[ size++ ] = (unsigned char) ( value | 0x80 );
+        value >>= 7;
+    }
+    pOut[ size++ ] = (unsigned char) value;
+    return size;
+}
+
+
+
+
+/* SplpLogGetVarintChecked
+* Reads a varint of a file, which must end before pEnd and fit into
+* SPLP_LOG_VARINT_MAX bytes. Returns NULL if it doesn't.
+*/
+static const unsigned char* SplpLogGetVarintChecked(
+    const unsigned char* pIn,
+    const unsigned char* pEnd,
+    unsigned long long* pValue )
+{
+    unsigned long long value = 0;
+    unsigned int shift = 0;
+
+    for ( ; pIn < pEnd && shift < 7 * SPLP_LOG_VARINT_MAX; shift += 7 )
+    {
+        value |= (unsigned long long) ( *pIn & 0x7f ) << shift;
+        if ( !( *pIn++ & 0x80 ) )
+        {
+            *pValue = value;
+            return pIn;
+        }
+    }
+    return NULL;
+}
+
+
+
+
+static void SplpLogPutNibble(
+    unsigned char* pColumn,
+    unsigned int index,
+    unsigned char value )
+{
+    pColumn[ index >> 1 ] |= (unsigned char) ( ( value & 0x0f ) << ( ( index & 1 ) << 2 ) );
+}
+
+
+
+
+static void SplpLogPutBit(
+    unsigned char* pColumn,
+    unsigned int index,
+    unsigned char value )
+{
+    pColumn[ index >> 3 ] |= (unsigned char) ( ( value & 1 ) << ( index & 7 ) );
+}
+
+
+
+
+/* SWAR population count, the compiler turns it into popcnt or vector
+* code where available.
+*/
+static unsigned int SplpLogPopCount64( unsigned long long x )
+{
+    x = x - ( ( x >> 1 ) & 0x5555555555555555ull );
+    x = ( x & 0x3333333333333333ull ) + ( ( x >> 2 ) & 0x3333333333333333ull );
+    x = ( x + ( x >> 4 ) ) & 0x0f0f0f0f0f0f0f0full;
+    return (unsigned int) ( ( x * 0x0101010101010101ull ) >> 56 );
+}
+
+
+
+
+static void SplpLogResetBlock(
+    PSPLP_LOG pLog )
+{
+    unsigned int i;
+    for ( i = 0; i < SPLP_LOG_COLUMN_COUNT; i++ )
+    {
+        pLog->columnSize[ i ] = 0;
+    }
+    memset( pLog->column[ SPLP_LOG_COLUMN_STATE ], 0,
+        pLog->column[ SPLP_LOG_COLUMN_LENGTH ] - pLog->column[ SPLP_LOG_COLUMN_STATE ] );
+    pLog->eventCount = 0;
+}
+
+
+
+
+static SPLP_STATUS SplpLogFlushBlock(
+    PSPLP_LOG pLog )
+{
+    static const unsigned char padding[ 8 ] = { 0 };
+    SPLP_LOG_BLOCK_HEADER header = { 0 };
+    unsigned int offset = SPLP_LOG_ALIGN( sizeof( header ) );
+    unsigned int i;
+
+    if ( pLog->eventCount == 0 )
+        return pLog->status;
+
+    /* bit and nibble columns always cover the whole event count */
+    pLog->columnSize[ SPLP_LOG_COLUMN_STATE ] = ( pLog->eventCount + 1 ) / 2;
+    pLog->columnSize[ SPLP_LOG_COLUMN_COMMAND ] = ( pLog->eventCount + 1 ) / 2;
+    pLog->columnSize[ SPLP_LOG_COLUMN_REASON ] = ( pLog->eventCount + 1 ) / 2;
+    pLog->columnSize[ SPLP_LOG_COLUMN_VERDICT ] = ( pLog->eventCount + 63 ) / 64 * 8;
+    pLog->columnSize[ SPLP_LOG_COLUMN_DIRECTION ] = ( pLog->eventCount + 63 ) / 64 * 8;
+
+    header.eventCount = pLog->eventCount;
+    header.firstTimestamp = pLog->firstTimestamp;
+    for ( i = 0; i < SPLP_LOG_COLUMN_COUNT; i++ )
+    {
+        header.columnOffset[ i ] = offset;
+        header.columnSize[ i ] = pLog->columnSize[ i ];
+        offset += SPLP_LOG_ALIGN( pLog->columnSize[ i ] );
+    }
+    header.blockSize = offset;
+
+    /* the block is dropped even if it can't be written, the buffers
+     * only hold one */
+    if ( pLog->status == SPLP_STATUS_OK &&
+        ( 1 != fwrite( &header, sizeof( header ), 1, pLog->fOutput ) ||
+        SPLP_LOG_ALIGN( sizeof( header ) ) - sizeof( header ) !=
+        fwrite( padding, 1, SPLP_LOG_ALIGN( sizeof( header ) ) - sizeof( header ), pLog->fOutput ) ) )
+    {
+        pLog->status = SPLP_STATUS_ERROR;
+    }
+
+    for ( i = 0; i < SPLP_LOG_COLUMN_COUNT && pLog->status == SPLP_STATUS_OK; i++ )
+    {
+        unsigned int size = pLog->columnSize[ i ];
+        if ( size != fwrite( pLog->column[ i ], 1, size, pLog->fOutput ) ||
+            SPLP_LOG_ALIGN( size ) - size != fwrite( padding, 1, SPLP_LOG_ALIGN( size ) - size, pLog->fOutput ) )
+        {
+            pLog->status = SPLP_STATUS_ERROR;
+        }
+    }
+
+    SplpLogResetBlock( pLog );
+    return pLog->status;
+}
+
+
+
+
+SPLP_STATUS SplpLogOpen(
+    PSPLP_LOG pLog,
+    const char* fileName,
+    unsigned int sampleRate )
+{
+    SPLP_LOG_FILE_HEADER header = { SPLP_LOG_MAGIC, SPLP_LOG_VERSION, SPLP_LOG_BLOCK_EVENTS };
+    unsigned int totalCapacity = 0;
+    unsigned int i;
+
+    memset( pLog, 0, sizeof( *pLog ) );
+    pLog->sampleRate = sampleRate ? sampleRate : 1;
+
+    for ( i = 0; i < SPLP_LOG_COLUMN_COUNT; i++ )
+    {
+        totalCapacity += SPLP_LOG_ALIGN( SplpLogColumnCapacity[ i ] );
+    }
+
+    pLog->buffer = (unsigned char*) calloc( totalCapacity, 1 );
+    if ( !pLog->buffer )
+        return SPLP_STATUS_ERROR;
+
+    totalCapacity = 0;
+    for ( i = 0; i < SPLP_LOG_COLUMN_COUNT; i++ )
+    {
+        pLog->column[ i ] = pLog->buffer + totalCapacity;
+        totalCapacity += SPLP_LOG_ALIGN( SplpLogColumnCapacity[ i ] );
+    }
+
+    pLog->fOutput = fopen( fileName, "wb" );
+    if ( !pLog->fOutput ||
+        1 != fwrite( &header, sizeof( header ), 1, pLog->fOutput ) )
+    {
+        printf( "***ERROR*** Log file \"%s\" can't be created\n", fileName );
+        SplpLogClose( pLog );
+        return SPLP_STATUS_ERROR;
+    }
+
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+void SplpLogAppend(
+    PSPLP_LOG pLog,
+    const SPLP_LOG_EVENT* pEvent )
+{
+    unsigned int index = pLog->eventCount;
+    unsigned int sessionDelta;
+
+    if ( pLog->status != SPLP_STATUS_OK )
+        return;
+
+    if ( index == 0 )
+    {
+        pLog->firstTimestamp = pEvent->timestamp;
+        pLog->lastTimestamp = pEvent->timestamp;
+        pLog->lastSessionId = 0;
+    }
+
+    /* zigzag keeps small backward jumps between sessions small */
+    sessionDelta = pEvent->sessionId - pLog->lastSessionId;
+    sessionDelta = ( sessionDelta << 1 ) ^ (unsigned int) -(int) ( sessionDelta >> 31 );
+
+    pLog->columnSize[ SPLP_LOG_COLUMN_TIMESTAMP ] += SplpLogPutVarint(
+        pLog->column[ SPLP_LOG_COLUMN_TIMESTAMP ] + pLog->columnSize[ SPLP_LOG_COLUMN_TIMESTAMP ],
+        pEvent->timestamp - pLog->lastTimestamp );
+    pLog->columnSize[ SPLP_LOG_COLUMN_SESSION ] += SplpLogPutVarint(
+        pLog->column[ SPLP_LOG_COLUMN_SESSION ] + pLog->columnSize[ SPLP_LOG_COLUMN_SESSION ],
+        sessionDelta );
+    pLog->columnSize[ SPLP_LOG_COLUMN_LENGTH ] += SplpLogPutVarint(
+        pLog->column[ SPLP_LOG_COLUMN_LENGTH ] + pLog->columnSize[ SPLP_LOG_COLUMN_LENGTH ],
+        pEvent->length );
+
+    SplpLogPutNibble( pLog->column[ SPLP_LOG_COLUMN_STATE ], index, pEvent->state );
+    SplpLogPutNibble( pLog->column[ SPLP_LOG_COLUMN_COMMAND ], index, pEvent->command );
+    SplpLogPutNibble( pLog->column[ SPLP_LOG_COLUMN_REASON ], index, pEvent->reason );
+    SplpLogPutBit( pLog->column[ SPLP_LOG_COLUMN_VERDICT ], index, pEvent->valid );
+    SplpLogPutBit( pLog->column[ SPLP_LOG_COLUMN_DIRECTION ], index, pEvent->direction );
+
+    pLog->lastTimestamp = pEvent->timestamp;
+    pLog->lastSessionId = pEvent->sessionId;
+
+    if ( ++pLog->eventCount == SPLP_LOG_BLOCK_EVENTS )
+        SplpLogFlushBlock( pLog );
+}
+
+
+
+
+SPLP_STATUS SplpLogClose(
+    PSPLP_LOG pLog )
+{
+    SPLP_STATUS status = pLog->status;
+
+    if ( pLog->fOutput )
+    {
+        /* fflush( ) reports a failed write still in the stdio buffer */
+        if ( SPLP_STATUS_OK != SplpLogFlushBlock( pLog ) || 0 != fflush( pLog->fOutput ) )
+            status = SPLP_STATUS_ERROR;
+        if ( 0 != fclose( pLog->fOutput ) )
+            status = SPLP_STATUS_ERROR;
+        pLog->fOutput = NULL;
+    }
+
+    free( pLog->buffer );
+    pLog->buffer = NULL;
+
+    return status;
+}
+
+
+
+
+/* SPLP_LOG_STARTS
+* Compares a prefix of text of length bytes. The compare has a constant
+* size, so the compiler turns it into a few loads.
+*/
+#define SPLP_LOG_STARTS( text, length, prefix ) \
+    ( ( length ) >= sizeof( prefix ) - 1 && 0 == memcmp( ( text ), ( prefix ), sizeof( prefix ) - 1 ) )
+
+
+
+
+SPLP_LOG_COMMAND SplpLogClassify(
+    const char* text,
+    unsigned int length )
+{
+    if ( length == 0 )
+        return SPLP_LOG_COMMAND_UNKNOWN;
+
+    switch ( text[ 0 ] )
+    {
+    case 'B':
+        return SPLP_LOG_STARTS( text, length, "B64:" ) ? SPLP_LOG_COMMAND_B64 : SPLP_LOG_COMMAND_UNKNOWN;
+    case 'V':
+        return SPLP_LOG_STARTS( text, length, "VERSION" ) ? SPLP_LOG_COMMAND_VERSION : SPLP_LOG_COMMAND_UNKNOWN;
+    case 'C':
+        if ( !SPLP_LOG_STARTS( text, length, "CONNECT" ) )
+            return SPLP_LOG_COMMAND_UNKNOWN;
+        return length > 7 && text[ 7 ] == '_' ? SPLP_LOG_COMMAND_CONNECT_OK : SPLP_LOG_COMMAND_CONNECT;
+    case 'D':
+        if ( !SPLP_LOG_STARTS( text, length, "DISCONNECT" ) )
+            return SPLP_LOG_COMMAND_UNKNOWN;
+        return length > 10 && text[ 10 ] == '_' ? SPLP_LOG_COMMAND_DISCONNECT_OK : SPLP_LOG_COMMAND_DISCONNECT;
+    case 'G':
+        if ( SPLP_LOG_STARTS( text, length, "GET_VER" ) )
+            return SPLP_LOG_COMMAND_GET_VER;
+        if ( SPLP_LOG_STARTS( text, length, "GET_DATA" ) )
+            return SPLP_LOG_COMMAND_GET_DATA;
+        if ( SPLP_LOG_STARTS( text, length, "GET_FILE" ) )
+            return SPLP_LOG_COMMAND_GET_FILE;
+        if ( SPLP_LOG_STARTS( text, length, "GET_COMMAND" ) )
+            return SPLP_LOG_COMMAND_GET_COMMAND;
+        if ( SPLP_LOG_STARTS( text, length, "GET_B64" ) )
+            return SPLP_LOG_COMMAND_GET_B64;
+        return SPLP_LOG_COMMAND_UNKNOWN;
+    default:
+        return SPLP_LOG_COMMAND_UNKNOWN;
+    }
+}
+
+
+
+
+const char* SplpLogStateName(
+    unsigned int state )
+{
+    return state < sizeof( SplpLogStateNames ) / sizeof( SplpLogStateNames[ 0 ] ) ?
+        SplpLogStateNames[ state ] : "?";
+}
+
+
+
+
+const char* SplpLogCommandName(
+    unsigned int command )
+{
+    return command < SPLP_LOG_COMMAND_COUNT ? SplpLogCommandNames[ command ] : "?";
+}
+
+
+
+
+/* SplpLogMapFile
+* Maps the whole file read-only. Returns NULL on failure.
+*/
+static const unsigned char* SplpLogMapFile(
+    const char* fileName,
+    unsigned long long* pSize )
+{
+#if defined( _WIN32 )
+    const unsigned char* pView = NULL;
+    LARGE_INTEGER size;
+    HANDLE hFile = CreateFileA( fileName, GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+
+    if ( hFile == INVALID_HANDLE_VALUE )
+        return NULL;
+
+    if ( GetFileSizeEx( hFile, &size ) && size.QuadPart != 0 )
+    {
+        HANDLE hMapping = CreateFileMappingA( hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+        if ( hMapping )
+        {
+            pView = (const unsigned char*) MapViewOfFile( hMapping, FILE_MAP_READ, 0, 0, 0 );
+            CloseHandle( hMapping );
+        }
+        *pSize = (unsigned long long) size.QuadPart;
+    }
+    CloseHandle( hFile );
+    return pView;
+#else
+    const unsigned char* pView = NULL;
+    struct stat st;
+    int fd = open( fileName, O_RDONLY );
+
+    if ( fd < 0 )
+        return NULL;
+
+    if ( 0 == fstat( fd, &st ) && st.st_size != 0 )
+    {
+        void* p = mmap( NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if ( p != MAP_FAILED )
+        {
+            madvise( p, (size_t) st.st_size, MADV_SEQUENTIAL );
+            pView = (const unsigned char*) p;
+        }
+        *pSize = (unsigned long long) st.st_size;
+    }
+    close( fd );
+    return pView;
+#endif
+}
+
+
+
+
+static void SplpLogUnmapFile(
+    const unsigned char* pView,
+    unsigned long long size )
+{
+#if defined( _WIN32 )
+    UnmapViewOfFile( pView );
+#else
+    munmap( (void*) pView, (size_t) size );
+#endif
+}
+
+
+
+
+/* SPLP_LOG_SUMMARY
+* Aggregates collected by SplpLogScan( ).
+*/
+typedef struct _SPLP_LOG_SUMMARY
+{
+    unsigned long long events;
+    unsigned long long valid;
+    unsigned long long fromServer;
+    unsigned long long invalidFromServer;
+    unsigned long long payloadBytes;
+    unsigned long long maxLength;
+    unsigned long long firstTimestamp;
+    unsigned long long lastTimestamp;
+    unsigned long long blocks;
+    unsigned long long byState[ SPLP_LOG_STATE_COUNT ];
+    unsigned long long byCommand[ 16 ];
+    unsigned long long byReason[ SPLP_LOG_REASON_COUNT ];
+
+}SPLP_LOG_SUMMARY, *PSPLP_LOG_SUMMARY;
+
+
+
+
+/* SplpLogCountNibbles
+* Counts the values of a 4 bit column. Returns SPLP_STATUS_ERROR if
+* one is limit or above; pCounts has 16 entries.
+*/
+static SPLP_STATUS SplpLogCountNibbles(
+    const unsigned char* pColumn,
+    unsigned int eventCount,
+    unsigned int limit,
+    unsigned long long* pCounts )
+{
+    unsigned int i;
+    for ( i = 0; i < eventCount; i++ )
+    {
+        unsigned int value = ( pColumn[ i >> 1 ] >> ( ( i & 1 ) << 2 ) ) & 0x0f;
+        if ( value >= limit )
+            return SPLP_STATUS_ERROR;
+        pCounts[ value ]++;
+    }
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+/* SplpLogCheckBlock
+* Checks that every column of a block lies inside of the block, is
+* aligned for word reads and is large enough for the fixed width
+* columns, before anything is read from it.
+*/
+static SPLP_STATUS SplpLogCheckBlock(
+    const SPLP_LOG_BLOCK_HEADER* pHeader )
+{
+    unsigned long long nibbleBytes = ( pHeader->eventCount + 1ull ) / 2;
+    unsigned long long bitBytes = ( pHeader->eventCount + 63ull ) / 64 * 8;
+    unsigned int i;
+
+    for ( i = 0; i < SPLP_LOG_COLUMN_COUNT; i++ )
+    {
+        unsigned long long end = (unsigned long long) pHeader->columnOffset[ i ] + pHeader->columnSize[ i ];
+        if ( pHeader->columnOffset[ i ] < SPLP_LOG_ALIGN( sizeof( *pHeader ) ) ||
+            pHeader->columnOffset[ i ] % 8 != 0 || end > pHeader->blockSize )
+        {
+            return SPLP_STATUS_ERROR;
+        }
+    }
+
+    if ( pHeader->columnSize[ SPLP_LOG_COLUMN_STATE ] < nibbleBytes ||
+        pHeader->columnSize[ SPLP_LOG_COLUMN_COMMAND ] < nibbleBytes ||
+        pHeader->columnSize[ SPLP_LOG_COLUMN_REASON ] < nibbleBytes ||
+        pHeader->columnSize[ SPLP_LOG_COLUMN_VERDICT ] < bitBytes ||
+        pHeader->columnSize[ SPLP_LOG_COLUMN_DIRECTION ] < bitBytes )
+    {
+        return SPLP_STATUS_ERROR;
+    }
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+/* SplpLogScanBlock
+* Adds a block to the summary, which is left as it was if the block is
+* damaged.
+*/
+static SPLP_STATUS SplpLogScanBlock(
+    const SPLP_LOG_BLOCK_HEADER* pHeader,
+    PSPLP_LOG_SUMMARY pSummary )
+{
+    const unsigned char* pBlock = (const unsigned char*) pHeader;
+    const unsigned long long* pVerdict =
+        (const unsigned long long*) ( pBlock + pHeader->columnOffset[ SPLP_LOG_COLUMN_VERDICT ] );
+    const unsigned long long* pDirection =
+        (const unsigned long long*) ( pBlock + pHeader->columnOffset[ SPLP_LOG_COLUMN_DIRECTION ] );
+    const unsigned char* pTimestamp = pBlock + pHeader->columnOffset[ SPLP_LOG_COLUMN_TIMESTAMP ];
+    const unsigned char* pTimestampEnd = pTimestamp + pHeader->columnSize[ SPLP_LOG_COLUMN_TIMESTAMP ];
+    const unsigned char* pLength = pBlock + pHeader->columnOffset[ SPLP_LOG_COLUMN_LENGTH ];
+    const unsigned char* pLengthEnd = pLength + pHeader->columnSize[ SPLP_LOG_COLUMN_LENGTH ];
+    SPLP_LOG_SUMMARY block = *pSummary;
+    unsigned long long timestamp = pHeader->firstTimestamp;
+    unsigned int words = ( pHeader->eventCount + 63 ) / 64;
+    unsigned int i;
+
+    if ( SPLP_STATUS_OK != SplpLogCheckBlock( pHeader ) )
+        return SPLP_STATUS_ERROR;
+
+    /* bit columns: 64 events per step, padding bits are zero */
+    for ( i = 0; i < words; i++ )
+    {
+        block.valid += SplpLogPopCount64( pVerdict[ i ] );
+        block.fromServer += SplpLogPopCount64( pDirection[ i ] );
+        block.invalidFromServer += SplpLogPopCount64( ~pVerdict[ i ] & pDirection[ i ] );
+    }
+
+    if ( SPLP_STATUS_OK != SplpLogCountNibbles( pBlock + pHeader->columnOffset[ SPLP_LOG_COLUMN_STATE ],
+            pHeader->eventCount, sizeof( SplpLogStateNames ) / sizeof( SplpLogStateNames[ 0 ] ), block.byState ) ||
+        SPLP_STATUS_OK != SplpLogCountNibbles( pBlock + pHeader->columnOffset[ SPLP_LOG_COLUMN_COMMAND ],
+            pHeader->eventCount, SPLP_LOG_COMMAND_COUNT, block.byCommand ) ||
+        SPLP_STATUS_OK != SplpLogCountNibbles( pBlock + pHeader->columnOffset[ SPLP_LOG_COLUMN_REASON ],
+            pHeader->eventCount, sizeof( SplpLogReasonNames ) / sizeof( SplpLogReasonNames[ 0 ] ), block.byReason ) )
+    {
+        return SPLP_STATUS_ERROR;
+    }
+
+    for ( i = 0; i < pHeader->eventCount; i++ )
+    {
+        unsigned long long value;
+        if ( NULL == ( pTimestamp = SplpLogGetVarintChecked( pTimestamp, pTimestampEnd, &value ) ) )
+            return SPLP_STATUS_ERROR;
+        timestamp += value;
+        if ( NULL == ( pLength = SplpLogGetVarintChecked( pLength, pLengthEnd, &value ) ) )
+            return SPLP_STATUS_ERROR;
+        block.payloadBytes += value;
+        if ( value > block.maxLength )
+            block.maxLength = value;
+    }
+
+    if ( block.events == 0 )
+        block.firstTimestamp = pHeader->firstTimestamp;
+    block.lastTimestamp = timestamp;
+    block.events += pHeader->eventCount;
+    block.blocks++;
+    *pSummary = block;
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+static void SplpLogSummaryPrint(
+    const char* fileName,
+    PSPLP_LOG_SUMMARY pSummary )
+{
+    unsigned int i;
+
+    printf(
+        "======================================================================\n"
+        " VERDICT LOG:\n"
+        "======================================================================\n"
+        "\tLog file:         \"%s\"\n"
+        "\tBlocks:           \t%14llu\n"
+        "\tEvents:           \t%14llu\n"
+        "\tValid:            \t%14llu\n"
+        "\tInvalid:          \t%14llu\n"
+        "\tB->A messages:    \t%14llu\n"
+        "\tB->A invalid:     \t%14llu\n"
+        "\tPayload bytes:    \t%14llu\n"
+        "\tMax length:       \t%14llu\n"
+        "\tTime span (tsc):  \t%14llu\n\n",
+        fileName,
+        pSummary->blocks,
+        pSummary->events,
+        pSummary->valid,
+        pSummary->events - pSummary->valid,
+        pSummary->fromServer,
+        pSummary->invalidFromServer,
+        pSummary->payloadBytes,
+        pSummary->maxLength,
+        pSummary->lastTimestamp - pSummary->firstTimestamp );
+
+    printf( " Events by state:\n" );
+    for ( i = 0; i < sizeof( SplpLogStateNames ) / sizeof( SplpLogStateNames[ 0 ] ); i++ )
+        printf( "\t%-18s\t%14llu\n", SplpLogStateName( i ), pSummary->byState[ i ] );
+
+    printf( "\n Events by command:\n" );
+    for ( i = 0; i < SPLP_LOG_COMMAND_COUNT; i++ )
+        printf( "\t%-18s\t%14llu\n", SplpLogCommandName( i ), pSummary->byCommand[ i ] );
+
+    printf( "\n Rejects by reason:\n" );
+    for ( i = 1; i < sizeof( SplpLogReasonNames ) / sizeof( SplpLogReasonNames[ 0 ] ); i++ )
+        printf( "\t%-18s\t%14llu\n", SplpLogReasonNames[ i ], pSummary->byReason[ i ] );
+
+    printf( "======================================================================\n" );
+}
+
+
+
+
+/* SplpLogMapLog
+* Maps a log and checks its file header.
+*/
+static const unsigned char* SplpLogMapLog(
+    const char* fileName,
+    unsigned long long* pSize )
+{
+    const unsigned char* pView = SplpLogMapFile( fileName, pSize );
+    const SPLP_LOG_FILE_HEADER* pFileHeader = (const SPLP_LOG_FILE_HEADER*) pView;
+
+    if ( !pView )
+    {
+        printf( "***ERROR*** Log file \"%s\" can't be mapped\n", fileName );
+        return NULL;
+    }
+
+    if ( *pSize < sizeof( *pFileHeader ) ||
+        0 != memcmp( pFileHeader->magic, SPLP_LOG_MAGIC, sizeof( pFileHeader->magic ) ) ||
+        pFileHeader->version != SPLP_LOG_VERSION )
+    {
+        printf( "***ERROR*** File \"%s\" is not a verdict log\n", fileName );
+        SplpLogUnmapFile( pView, *pSize );
+        return NULL;
+    }
+
+    return pView;
+}
+
+
+
+
+/* SplpLogNextBlock
+* Returns the block at *pOffset and advances the offset, NULL at the
+* end of the log or at a damaged block, which sets *pDamaged.
+*/
+static const SPLP_LOG_BLOCK_HEADER* SplpLogNextBlock(
+    const unsigned char* pView,
+    unsigned long long size,
+    unsigned long long* pOffset,
+    int* pDamaged )
+{
+    const SPLP_LOG_FILE_HEADER* pFileHeader = (const SPLP_LOG_FILE_HEADER*) pView;
+    const SPLP_LOG_BLOCK_HEADER* pHeader;
+
+    if ( *pOffset == size )
+        return NULL;
+
+    pHeader = (const SPLP_LOG_BLOCK_HEADER*) ( pView + *pOffset );
+    if ( *pOffset + sizeof( SPLP_LOG_BLOCK_HEADER ) > size ||
+        pHeader->blockSize < SPLP_LOG_ALIGN( sizeof( *pHeader ) ) || pHeader->blockSize % 8 != 0 ||
+        *pOffset + pHeader->blockSize > size ||
+        pHeader->eventCount > pFileHeader->blockEvents ||
+        SPLP_STATUS_OK != SplpLogCheckBlock( pHeader ) )
+    {
+        printf( "***ERROR*** Log block at offset %llu is damaged\n", *pOffset );
+        *pDamaged = 1;
+        return NULL;
+    }
+
+    *pOffset += pHeader->blockSize;
+    return pHeader;
+}
+
+
+
+
+SPLP_STATUS SplpLogReadIntervals(
+    const char* fileName,
+    unsigned long long** ppIntervals,
+    unsigned long long* pCount )
+{
+    const SPLP_LOG_BLOCK_HEADER* pHeader;
+    unsigned long long size = 0;
+    unsigned long long offset = SPLP_LOG_ALIGN( sizeof( SPLP_LOG_FILE_HEADER ) );
+    unsigned long long events = 0;
+    unsigned long long previous = 0;
+    unsigned long long* pIntervals;
+    int damaged = 0;
+    const unsigned char* pView = SplpLogMapLog( fileName, &size );
+
+    *ppIntervals = NULL;
+    *pCount = 0;
+    if ( !pView )
+        return SPLP_STATUS_ERROR;
+
+    while ( NULL != ( pHeader = SplpLogNextBlock( pView, size, &offset, &damaged ) ) )
+        events += pHeader->eventCount;
+
+    pIntervals = !damaged && events > 1 ? (unsigned long long*) malloc( (size_t) ( events - 1 ) * sizeof( *pIntervals ) ) : NULL;
+    if ( !pIntervals )
+    {
+        if ( !damaged )
+            printf( "***ERROR*** Log file \"%s\" has no intervals to replay\n", fileName );
+        SplpLogUnmapFile( pView, size );
+        return SPLP_STATUS_ERROR;
+    }
+
+    offset = SPLP_LOG_ALIGN( sizeof( SPLP_LOG_FILE_HEADER ) );
+    events = 0;
+    while ( !damaged && NULL != ( pHeader = SplpLogNextBlock( pView, size, &offset, &damaged ) ) )
+    {
+        const unsigned char* pTimestamp = (const unsigned char*) pHeader + pHeader->columnOffset[ SPLP_LOG_COLUMN_TIMESTAMP ];
+        const unsigned char* pTimestampEnd = pTimestamp + pHeader->columnSize[ SPLP_LOG_COLUMN_TIMESTAMP ];
+        unsigned long long timestamp = pHeader->firstTimestamp;
+        unsigned int i;
+
+        for ( i = 0; i < pHeader->eventCount; i++ )
+        {
+            unsigned long long delta;
+            if ( NULL == ( pTimestamp = SplpLogGetVarintChecked( pTimestamp, pTimestampEnd, &delta ) ) )
+            {
+                printf( "***ERROR*** Log block at offset %llu is damaged\n",
+                    (unsigned long long) ( (const unsigned char*) pHeader - pView ) );
+                damaged = 1;
+                break;
+            }
+            timestamp += delta;
+            if ( events )
+                pIntervals[ events - 1 ] = timestamp > previous ? timestamp - previous : 0;
+            previous = timestamp;
+            events++;
+        }
+    }
+
+    SplpLogUnmapFile( pView, size );
+    if ( damaged )
+    {
+        free( pIntervals );
+        return SPLP_STATUS_ERROR;
+    }
+    *ppIntervals = pIntervals;
+    *pCount = events - 1;
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+SPLP_STATUS SplpLogScan(
+    const char* fileName )
+{
+    SPLP_LOG_SUMMARY summary = { 0 };
+    const SPLP_LOG_BLOCK_HEADER* pHeader;
+    unsigned long long size = 0;
+    unsigned long long offset = SPLP_LOG_ALIGN( sizeof( SPLP_LOG_FILE_HEADER ) );
+    int damaged = 0;
+    const unsigned char* pView = SplpLogMapLog( fileName, &size );
+
+    if ( !pView )
+        return SPLP_STATUS_ERROR;
+
+    while ( NULL != ( pHeader = SplpLogNextBlock( pView, size, &offset, &damaged ) ) )
+    {
+        if ( SPLP_STATUS_OK != SplpLogScanBlock( pHeader, &summary ) )
+        {
+            printf( "***ERROR*** Log block at offset %llu has values out of range\n",
+                (unsigned long long) ( (const unsigned char*) pHeader - pView ) );
+            damaged = 1;
+            break;
+        }
+    }
+
+    SplpLogUnmapFile( pView, size );
+    if ( damaged )
+        return SPLP_STATUS_ERROR;
+    SplpLogSummaryPrint( fileName, &summary );
+    return SPLP_STATUS_OK;
+}
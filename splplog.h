@@ -0,0 +1,221 @@
+/*
+* SPLPLOG.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the columnar verdict log. The log
+* records one event per validated message and is meant for offline
+* analysis of test runs.
+*/
+#ifndef SPLPLOG_H
+#define SPLPLOG_H
+
+#include <stdio.h>
+#include "splptest.h"
+
+
+
+#define SPLP_LOG_MAGIC            "SPLPLOG1"
+#define SPLP_LOG_VERSION          1
+#define SPLP_LOG_BLOCK_EVENTS     4096    /* events per block, multiple of 64 */
+
+
+
+
+/* SPLP_LOG_COLUMN
+* Columns of a block. Every column is stored separately and starts at
+* an 8-byte aligned offset, so bit columns can be read word by word
+* straight from a mapped file.
+*/
+typedef enum _SPLP_LOG_COLUMN
+{
+    SPLP_LOG_COLUMN_TIMESTAMP,  /* varint, delta to previous event   */
+    SPLP_LOG_COLUMN_SESSION,    /* varint, zigzag delta              */
+    SPLP_LOG_COLUMN_STATE,      /* 4 bits, state before the message  */
+    SPLP_LOG_COLUMN_COMMAND,    /* 4 bits, SPLP_LOG_COMMAND          */
+    SPLP_LOG_COLUMN_REASON,     /* 4 bits, enum Reason               */
+    SPLP_LOG_COLUMN_VERDICT,    /* 1 bit, set for MESSAGE_VALID      */
+    SPLP_LOG_COLUMN_DIRECTION,  /* 1 bit, set for B_TO_A             */
+    SPLP_LOG_COLUMN_LENGTH,     /* varint, message length in bytes   */
+    SPLP_LOG_COLUMN_COUNT
+} SPLP_LOG_COLUMN;
+
+
+
+
+/* SPLP_LOG_COMMAND
+* Message class derived from the leading keyword of the message.
+*/
+typedef enum _SPLP_LOG_COMMAND
+{
+    SPLP_LOG_COMMAND_UNKNOWN,
+    SPLP_LOG_COMMAND_CONNECT,
+    SPLP_LOG_COMMAND_CONNECT_OK,
+    SPLP_LOG_COMMAND_GET_VER,
+    SPLP_LOG_COMMAND_GET_DATA,
+    SPLP_LOG_COMMAND_GET_FILE,
+    SPLP_LOG_COMMAND_GET_COMMAND,
+    SPLP_LOG_COMMAND_GET_B64,
+    SPLP_LOG_COMMAND_DISCONNECT,
+    SPLP_LOG_COMMAND_DISCONNECT_OK,
+    SPLP_LOG_COMMAND_VERSION,
+    SPLP_LOG_COMMAND_B64,
+    SPLP_LOG_COMMAND_COUNT
+} SPLP_LOG_COMMAND;
+
+
+
+
+/* SPLP_LOG_FILE_HEADER
+* Written once at the beginning of the file.
+*/
+typedef struct _SPLP_LOG_FILE_HEADER
+{
+    char         magic[ 8 ];
+    unsigned int version;
+    unsigned int blockEvents;
+
+}SPLP_LOG_FILE_HEADER, *PSPLP_LOG_FILE_HEADER;
+
+
+
+
+/* SPLP_LOG_BLOCK_HEADER
+* Precedes every block. Offsets are relative to the block header,
+* blockSize includes the header and is a multiple of 8.
+*/
+typedef struct _SPLP_LOG_BLOCK_HEADER
+{
+    unsigned int       blockSize;
+    unsigned int       eventCount;
+    unsigned long long firstTimestamp;
+    unsigned int       columnOffset[ SPLP_LOG_COLUMN_COUNT ];
+    unsigned int       columnSize[ SPLP_LOG_COLUMN_COUNT ];
+
+}SPLP_LOG_BLOCK_HEADER, *PSPLP_LOG_BLOCK_HEADER;
+
+
+
+
+/* SPLP_LOG_EVENT
+* A single verdict as passed to SplpLogAppend( ).
+*/
+typedef struct _SPLP_LOG_EVENT
+{
+    unsigned long long timestamp;
+    unsigned int       sessionId;
+    unsigned int       length;
+    unsigned char      state;
+    unsigned char      command;
+    unsigned char      reason;
+    unsigned char      valid;
+    unsigned char      direction;
+
+}SPLP_LOG_EVENT, *PSPLP_LOG_EVENT;
+
+
+
+
+/* SPLP_LOG
+* Writer state. Columns of the current block are accumulated in one
+* buffer allocated by SplpLogOpen( ) and written out when the block
+* is full, so appending never allocates. The first failed write is kept
+* in status, which stops the encoding and is returned by SplpLogClose( ).
+*/
+typedef struct _SPLP_LOG
+{
+    FILE*              fOutput;
+    unsigned int       sampleRate;     /* record every sampleRate-th event */
+    unsigned int       sampleCounter;
+    unsigned int       eventCount;     /* events in the current block */
+    unsigned long long firstTimestamp;
+    unsigned long long lastTimestamp;
+    unsigned int       lastSessionId;
+    unsigned char*     buffer;
+    unsigned char*     column[ SPLP_LOG_COLUMN_COUNT ];
+    unsigned int       columnSize[ SPLP_LOG_COLUMN_COUNT ];
+    SPLP_STATUS        status;
+
+}SPLP_LOG, *PSPLP_LOG;
+
+
+
+
+SPLP_STATUS SplpLogOpen(
+    PSPLP_LOG pLog,
+    const char* fileName,
+    unsigned int sampleRate );
+
+
+
+
+/* SplpLogSample
+* Counts an event and returns nonzero if it is to be recorded, so the
+* caller classifies and timestamps only the sampled events. Zero after
+* a write error.
+*/
+static __inline int SplpLogSample(
+    PSPLP_LOG pLog )
+{
+    if ( ++pLog->sampleCounter < pLog->sampleRate || pLog->status != SPLP_STATUS_OK )
+        return 0;
+    pLog->sampleCounter = 0;
+    return 1;
+}
+
+
+
+
+/* SplpLogAppend
+* Records an event SplpLogSample( ) has chosen.
+*/
+void SplpLogAppend(
+    PSPLP_LOG pLog,
+    const SPLP_LOG_EVENT* pEvent );
+
+
+
+
+SPLP_STATUS SplpLogClose(
+    PSPLP_LOG pLog );
+
+
+
+
+/* SplpLogClassify
+* Message class of a text of length bytes, which need not be terminated.
+*/
+SPLP_LOG_COMMAND SplpLogClassify(
+    const char* text,
+    unsigned int length );
+
+
+
+
+const char* SplpLogStateName(
+    unsigned int state );
+
+
+
+
+const char* SplpLogCommandName(
+    unsigned int command );
+
+
+
+
+SPLP_STATUS SplpLogScan(
+    const char* fileName );
+
+
+
+
+/* SplpLogReadIntervals
+* Returns the gaps between consecutive events of a log in TSC ticks,
+* e.g. to replay its arrival pattern. The array is allocated with
+* malloc( ) and has one entry less than the log has events.
+*/
+SPLP_STATUS SplpLogReadIntervals(
+    const char* fileName,
+    unsigned long long** ppIntervals,
+    unsigned long long* pCount );
+
+#endif /* SPLPLOG_H */
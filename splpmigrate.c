@@ -0,0 +1,589 @@
+/*
+* SPLPMIGRATE.c
+* The file is part of practical task for System programming course.
+* This file contains the live migration of sessions between worker
+* threads. A dispatcher thread routes every message to the worker
+* which owns its session, by the owner table, through the worker's
+* ring. A migration of session s from worker A to worker B:
+*   1. the dispatcher holds back new messages of s and queues a
+*      RELEASE of s to A;
+*   2. A gets to the RELEASE after all earlier messages of s, copies
+*      the context of s to the handoff slot of s and flags it ready;
+*   3. the dispatcher sees the flag, queues an ADOPT of s to B, then
+*      the held back messages, and points the owner table at B.
+* Messages of s are never in two rings at a time, so none is dropped
+* or reordered, and no worker ever waits for another one.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "splpmigrate.h"
+#include "splpring.h"
+#include "splpscale.h"
+#include "splpbench.h"
+
+
+
+typedef struct _SPLP_MIGRATE SPLP_MIGRATE, *PSPLP_MIGRATE;
+
+
+
+
+/* SPLP_MIGRATE_WORKER
+* done is written by the worker only, and read by the dispatcher for
+* the throughput samples.
+*/
+typedef struct _SPLP_MIGRATE_WORKER
+{
+    PSPLP_MIGRATE          pMigrate;
+    SPLP_THREAD            thread;
+    SPLP_RING              ring;
+    PSPLP_MIGRATE_CONTEXT  pContexts;      /* by session, valid where owned */
+    unsigned char*         pOwned;
+    unsigned int           wrong;          /* verdicts other than expected */
+    unsigned int           strays;         /* messages of sessions not owned */
+    char                   padding[ SPLP_RING_CACHE_LINE ];
+    volatile unsigned int  done;
+    char                   donePadding[ SPLP_RING_CACHE_LINE - sizeof( unsigned int ) ];
+
+}SPLP_MIGRATE_WORKER, *PSPLP_MIGRATE_WORKER;
+
+
+
+
+struct _SPLP_MIGRATE
+{
+    PSPLP_TEST_MESSAGE     pStream;        /* valid conversations of all sessions, interleaved */
+    unsigned int*          pStreamSessions;
+    struct Session*        pFinal;         /* session states after the stream */
+    PSPLP_MIGRATE_CONTEXT  pHandoff;       /* by session */
+    volatile unsigned int* pReady;         /* by session, handoff is complete */
+    unsigned char*         pOwner;         /* indirection table of the dispatcher */
+    unsigned int           pending[ SPLP_MIGRATE_MAX_PENDING ];
+    unsigned int           workerCount;
+    unsigned long long     ticksPerMessage; /* of the rate limit */
+    unsigned long long     burst;
+    PSPLP_MIGRATE_WORKER   pWorkers;
+};
+
+
+
+
+/* SPLP_MIGRATE_RESULT
+* One run, as seen by the dispatcher.
+*/
+typedef struct _SPLP_MIGRATE_RESULT
+{
+    unsigned long long     ticks;
+    unsigned int           migrations;
+    unsigned int           held;           /* messages held back during migrations */
+    unsigned long long*    pLatency;       /* decision to ADOPT queued, by migration */
+    unsigned int*          pSamples;       /* messages done per bucket */
+    unsigned int           sampleCount;
+    unsigned int           maxSamples;
+
+}SPLP_MIGRATE_RESULT, *PSPLP_MIGRATE_RESULT;
+
+
+
+
+static void SplpMigrateValidate(
+    PSPLP_MIGRATE pMigrate,
+    PSPLP_MIGRATE_WORKER pWorker,
+    PSPLP_RING_ENTRY pEntry )
+{
+    PSPLP_MIGRATE_CONTEXT pContext = &pWorker->pContexts[ pEntry->session ];
+    unsigned long long now = SplpReadTsc( );
+    enum test_status result;
+
+    if ( !pWorker->pOwned[ pEntry->session ] )
+        pWorker->strays++;
+
+    pContext->tokens += now - pContext->refilled;
+    pContext->refilled = now;
+    if ( pContext->tokens > pMigrate->burst )
+        pContext->tokens = pMigrate->burst;
+    if ( pContext->tokens >= pMigrate->ticksPerMessage )
+        pContext->tokens -= pMigrate->ticksPerMessage;
+    else
+        pContext->limited++;
+
+    result = validate_session_message( &pContext->session, &pEntry->pMsg->msg );
+    pContext->messages++;
+    if ( result != MESSAGE_VALID )
+        pContext->rejected++;
+    if ( result != pEntry->pMsg->expectedTestStatus )
+        pWorker->wrong++;
+}
+
+
+
+
+static SPLP_THREAD_ROUTINE( SplpMigrateWorker, arg )
+{
+    PSPLP_MIGRATE_WORKER pWorker = (PSPLP_MIGRATE_WORKER) arg;
+    PSPLP_MIGRATE pMigrate = pWorker->pMigrate;
+    SPLP_RING_ENTRY entry;
+
+    for ( ;; )
+    {
+        while ( !SplpRingPop( &pWorker->ring, &entry ) )
+            SplpThreadYield( );
+
+        switch ( entry.control )
+        {
+        case SPLP_MIGRATE_MESSAGE:
+            SplpMigrateValidate( pMigrate, pWorker, &entry );
+            SplpStoreRelease( &pWorker->done, pWorker->done + 1 );
+            break;
+        case SPLP_MIGRATE_RELEASE:
+            pMigrate->pHandoff[ entry.session ] = pWorker->pContexts[ entry.session ];
+            pWorker->pOwned[ entry.session ] = 0;
+            SplpStoreRelease( &pMigrate->pReady[ entry.session ], 1 );
+            break;
+        case SPLP_MIGRATE_ADOPT:
+            pWorker->pContexts[ entry.session ] = pMigrate->pHandoff[ entry.session ];
+            pWorker->pOwned[ entry.session ] = 1;
+            break;
+        default:
+            SPLP_THREAD_RETURN;
+        }
+    }
+}
+
+
+
+
+static void SplpMigratePush(
+    PSPLP_MIGRATE_WORKER pWorker,
+    unsigned int control,
+    unsigned int session,
+    PSPLP_TEST_MESSAGE pMsg )
+{
+    SPLP_RING_ENTRY entry;
+
+    entry.pMsg = pMsg;
+    entry.intended = 0;
+    entry.sent = 0;
+    entry.session = session;
+    entry.control = control;
+    while ( !SplpRingPush( &pWorker->ring, &entry ) )
+        SplpThreadYield( );
+}
+
+
+
+
+/* SplpMigrateGenerate
+* Interleaves the conversations of all sessions in a random order.
+*/
+static SPLP_STATUS SplpMigrateGenerate(
+    PSPLP_MIGRATE pMigrate )
+{
+    unsigned long long seed = 0x9e3779b97f4a7c15ull;
+    unsigned int i;
+
+    pMigrate->pStream = (PSPLP_TEST_MESSAGE) malloc( SPLP_MIGRATE_MESSAGES * sizeof( SPLP_TEST_MESSAGE ) );
+    pMigrate->pStreamSessions = (unsigned int*) malloc( SPLP_MIGRATE_MESSAGES * sizeof( unsigned int ) );
+    pMigrate->pFinal = (struct Session*) calloc( SPLP_MIGRATE_SESSIONS, sizeof( struct Session ) );
+    if ( !pMigrate->pStream || !pMigrate->pStreamSessions || !pMigrate->pFinal )
+        return SPLP_STATUS_ERROR;
+
+    for ( i = 0; i < SPLP_MIGRATE_MESSAGES; i++ )
+    {
+        unsigned long long random;
+        unsigned int session;
+
+        seed ^= seed >> 12;
+        seed ^= seed << 25;
+        seed ^= seed >> 27;
+        random = seed * 2685821657736338717ull;
+        session = (unsigned int) ( random >> 40 ) % SPLP_MIGRATE_SESSIONS;
+
+        pMigrate->pStream[ i ].msg = SplpScaleScript[ pMigrate->pFinal[ session ].state ][ random & ( SPLP_SCALE_VARIANTS - 1 ) ];
+        pMigrate->pStream[ i ].length = (unsigned int) strlen( pMigrate->pStream[ i ].msg.text_message );
+        pMigrate->pStream[ i ].expectedTestStatus = validate_session_message( &pMigrate->pFinal[ session ], &pMigrate->pStream[ i ].msg );
+        pMigrate->pStreamSessions[ i ] = session;
+    }
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+static unsigned int SplpMigrateDone(
+    PSPLP_MIGRATE pMigrate )
+{
+    unsigned int done = 0;
+    unsigned int i;
+
+    for ( i = 0; i < pMigrate->workerCount; i++ )
+        done += SplpLoadAcquire( &pMigrate->pWorkers[ i ].done );
+    return done;
+}
+
+
+
+
+/* SplpMigrateAdopt
+* Step 3 of a migration, the handoff of session is complete.
+*/
+static void SplpMigrateAdopt(
+    PSPLP_MIGRATE pMigrate,
+    unsigned int session,
+    unsigned int target,
+    unsigned int pendingCount,
+    unsigned long long decided,
+    PSPLP_MIGRATE_RESULT pResult )
+{
+    PSPLP_MIGRATE_WORKER pTarget = &pMigrate->pWorkers[ target ];
+    unsigned int p;
+
+    SplpMigratePush( pTarget, SPLP_MIGRATE_ADOPT, session, NULL );
+    for ( p = 0; p < pendingCount; p++ )
+        SplpMigratePush( pTarget, SPLP_MIGRATE_MESSAGE, session, &pMigrate->pStream[ pMigrate->pending[ p ] ] );
+    pMigrate->pOwner[ session ] = (unsigned char) target;
+    pResult->pLatency[ pResult->migrations++ ] = SplpReadTsc( ) - decided;
+    pResult->held += pendingCount;
+}
+
+
+
+
+/* SplpMigrateRun
+* Dispatches the stream. With period set, a session of the worker with
+* the deepest ring moves to the worker with the shallowest one every
+* period ticks; one migration is in flight at a time.
+*/
+static SPLP_STATUS SplpMigrateRun(
+    PSPLP_MIGRATE pMigrate,
+    unsigned long long period,
+    double ticksPerSecond,
+    PSPLP_MIGRATE_RESULT pResult )
+{
+    PSPLP_MIGRATE_WORKER pWorkers = pMigrate->pWorkers;
+    unsigned long long bucket = (unsigned long long) ( ticksPerSecond * SPLP_MIGRATE_BUCKET_USEC / 1000000.0 );
+    unsigned long long begin;
+    unsigned long long nextBucket;
+    unsigned long long nextMigration;
+    unsigned long long decided = 0;
+    unsigned int lastDone = 0;
+    unsigned int migrating = 0;
+    unsigned int session = 0;
+    unsigned int target = 0;
+    unsigned int cursor = 0;
+    unsigned int pendingCount = 0;
+    unsigned int started;
+    unsigned int i;
+    SPLP_STATUS status = SPLP_STATUS_OK;
+
+    memset( (void*) pMigrate->pReady, 0, SPLP_MIGRATE_SESSIONS * sizeof( unsigned int ) );
+    for ( i = 0; i < SPLP_MIGRATE_SESSIONS; i++ )
+        pMigrate->pOwner[ i ] = (unsigned char) ( i % pMigrate->workerCount );
+
+    for ( started = 0; started < pMigrate->workerCount; started++ )
+    {
+        PSPLP_MIGRATE_WORKER pWorker = &pWorkers[ started ];
+
+        pWorker->pMigrate = pMigrate;
+        pWorker->ring.head = 0;
+        pWorker->ring.tail = 0;
+        pWorker->wrong = 0;
+        pWorker->strays = 0;
+        pWorker->done = 0;
+        memset( pWorker->pContexts, 0, SPLP_MIGRATE_SESSIONS * sizeof( SPLP_MIGRATE_CONTEXT ) );
+        for ( i = 0; i < SPLP_MIGRATE_SESSIONS; i++ )
+        {
+            pWorker->pOwned[ i ] = pMigrate->pOwner[ i ] == started;
+            pWorker->pContexts[ i ].tokens = pMigrate->burst;
+            pWorker->pContexts[ i ].refilled = SplpReadTsc( );
+        }
+        if ( 0 != SplpThreadCreate( &pWorker->thread, SplpMigrateWorker, pWorker ) )
+        {
+            printf( "***ERROR*** Cannot start a worker thread\n" );
+            status = SPLP_STATUS_ERROR;
+            break;
+        }
+    }
+
+    pResult->migrations = 0;
+    pResult->held = 0;
+    pResult->sampleCount = 0;
+    begin = SplpReadTsc( );
+    nextBucket = begin + bucket;
+    nextMigration = begin + period;
+
+    for ( i = 0; i < SPLP_MIGRATE_MESSAGES && status == SPLP_STATUS_OK; )
+    {
+        unsigned int s = pMigrate->pStreamSessions[ i ];
+        unsigned long long now = SplpReadTsc( );
+
+        if ( now >= nextBucket )
+        {
+            unsigned int done = SplpMigrateDone( pMigrate );
+            if ( pResult->sampleCount < pResult->maxSamples )
+                pResult->pSamples[ pResult->sampleCount++ ] = done - lastDone;
+            lastDone = done;
+            nextBucket += bucket;
+        }
+
+        if ( migrating && SplpLoadAcquire( &pMigrate->pReady[ session ] ) )
+        {
+            SplpMigrateAdopt( pMigrate, session, target, pendingCount, decided, pResult );
+            pendingCount = 0;
+            migrating = 0;
+        }
+
+        if ( !migrating && period && now >= nextMigration && pResult->migrations < pResult->maxSamples )
+        {
+            unsigned int source = 0;
+            unsigned int w;
+
+            /* hottest and coolest worker by queue depth */
+            target = 0;
+            for ( w = 1; w < pMigrate->workerCount; w++ )
+            {
+                if ( SplpRingDepth( &pWorkers[ w ].ring ) > SplpRingDepth( &pWorkers[ source ].ring ) )
+                    source = w;
+                if ( SplpRingDepth( &pWorkers[ w ].ring ) < SplpRingDepth( &pWorkers[ target ].ring ) )
+                    target = w;
+            }
+            if ( source == target )
+                target = ( source + 1 ) % pMigrate->workerCount;
+
+            while ( pMigrate->pOwner[ cursor ] != source )
+                cursor = ( cursor + 1 ) % SPLP_MIGRATE_SESSIONS;
+            session = cursor;
+            cursor = ( cursor + 1 ) % SPLP_MIGRATE_SESSIONS;
+
+            decided = SplpReadTsc( );
+            pMigrate->pReady[ session ] = 0;
+            SplpMigratePush( &pWorkers[ source ], SPLP_MIGRATE_RELEASE, session, NULL );
+            migrating = 1;
+            nextMigration = now + period;
+        }
+
+        if ( migrating && s == session )
+        {
+            /* held back until the handoff, wait for it if there's no room */
+            if ( pendingCount == SPLP_MIGRATE_MAX_PENDING )
+            {
+                SplpThreadYield( );
+                continue;
+            }
+            pMigrate->pending[ pendingCount++ ] = i++;
+            continue;
+        }
+
+        SplpMigratePush( &pWorkers[ pMigrate->pOwner[ s ] ], SPLP_MIGRATE_MESSAGE, s, &pMigrate->pStream[ i ] );
+        i++;
+    }
+
+    /* the last migration still needs its handoff */
+    while ( migrating && status == SPLP_STATUS_OK )
+    {
+        if ( SplpLoadAcquire( &pMigrate->pReady[ session ] ) )
+        {
+            SplpMigrateAdopt( pMigrate, session, target, pendingCount, decided, pResult );
+            migrating = 0;
+        }
+        else
+        {
+            SplpThreadYield( );
+        }
+    }
+
+    for ( i = 0; i < started; i++ )
+        SplpMigratePush( &pWorkers[ i ], SPLP_MIGRATE_STOP, 0, NULL );
+    for ( i = 0; i < started; i++ )
+        SplpThreadJoin( pWorkers[ i ].thread );
+    pResult->ticks = SplpReadTsc( ) - begin;
+    return status;
+}
+
+
+
+
+/* SplpMigrateCheck
+* Every message validated once, with the expected verdict, by the owner
+* of its session, and every session ends in the state of its
+* conversation.
+*/
+static unsigned int SplpMigrateCheck(
+    PSPLP_MIGRATE pMigrate )
+{
+    unsigned int errors = 0;
+    unsigned int messages = 0;
+    unsigned int i;
+
+    for ( i = 0; i < pMigrate->workerCount; i++ )
+    {
+        errors += pMigrate->pWorkers[ i ].wrong + pMigrate->pWorkers[ i ].strays;
+        messages += pMigrate->pWorkers[ i ].done;
+    }
+    for ( i = 0; i < SPLP_MIGRATE_SESSIONS; i++ )
+    {
+        PSPLP_MIGRATE_WORKER pOwner = &pMigrate->pWorkers[ pMigrate->pOwner[ i ] ];
+        if ( !pOwner->pOwned[ i ] || pOwner->pContexts[ i ].session.state != pMigrate->pFinal[ i ].state )
+            errors++;
+    }
+    return errors + ( messages != SPLP_MIGRATE_MESSAGES );
+}
+
+
+
+
+static int SplpMigrateCompare(
+    const void* pLeft,
+    const void* pRight )
+{
+    unsigned long long left = *(const unsigned long long*) pLeft;
+    unsigned long long right = *(const unsigned long long*) pRight;
+    return left < right ? -1 : left > right ? 1 : 0;
+}
+
+
+
+
+static int SplpMigrateCompareSamples(
+    const void* pLeft,
+    const void* pRight )
+{
+    unsigned int left = *(const unsigned int*) pLeft;
+    unsigned int right = *(const unsigned int*) pRight;
+    return left < right ? -1 : left > right ? 1 : 0;
+}
+
+
+
+
+/* SplpMigratePrint
+* Prints the line of a run; the samples are sorted on the way. The
+* last sample is a partial bucket and left out.
+*/
+static void SplpMigratePrint(
+    const char* pName,
+    PSPLP_MIGRATE_RESULT pResult,
+    unsigned int errors,
+    double ticksPerSecond )
+{
+    double usec = 1000000.0 / ticksPerSecond;
+    double perBucket = 1000000.0 / SPLP_MIGRATE_BUCKET_USEC;
+    unsigned int samples = pResult->sampleCount > 1 ? pResult->sampleCount - 1 : pResult->sampleCount;
+    unsigned int m = pResult->migrations;
+
+    qsort( pResult->pLatency, m, sizeof( unsigned long long ), SplpMigrateCompare );
+    qsort( pResult->pSamples, samples, sizeof( unsigned int ), SplpMigrateCompareSamples );
+
+    printf( "\t%-9s %12.0f %12.0f %12.0f %6u %9.2f %9.2f %9.2f %7u %6u\n",
+        pName,
+        SPLP_MIGRATE_MESSAGES * ticksPerSecond / (double) pResult->ticks,
+        samples ? pResult->pSamples[ samples / 2 ] * perBucket : 0,
+        samples ? pResult->pSamples[ 0 ] * perBucket : 0,
+        m,
+        m ? pResult->pLatency[ m / 2 ] * usec : 0,
+        m ? pResult->pLatency[ (unsigned int) ( m * 0.99 ) ] * usec : 0,
+        m ? pResult->pLatency[ m - 1 ] * usec : 0,
+        pResult->held,
+        errors );
+}
+
+
+
+
+SPLP_STATUS SplpMigrationBenchmark(
+    PSPLP_TEST_OPTIONS pOptions )
+{
+    static SPLP_MIGRATE_WORKER workers[ SPLP_MIGRATE_MAX_WORKERS ];
+    static SPLP_MIGRATE migrate;
+    SPLP_MIGRATE_RESULT result = { 0 };
+    SPLP_STATUS status = SPLP_STATUS_OK;
+    double ticksPerSecond = SplpTscTicksPerSecond( );
+    unsigned int errors[ 2 ] = { 0, 0 };
+    unsigned int run;
+    unsigned int i;
+
+    migrate.workerCount = pOptions->migrateWorkers;
+    migrate.pWorkers = workers;
+    migrate.ticksPerMessage = (unsigned long long) ( ticksPerSecond / SPLP_MIGRATE_RATE );
+    migrate.burst = migrate.ticksPerMessage * SPLP_MIGRATE_BURST;
+    migrate.pHandoff = (PSPLP_MIGRATE_CONTEXT) calloc( SPLP_MIGRATE_SESSIONS, sizeof( SPLP_MIGRATE_CONTEXT ) );
+    migrate.pReady = (volatile unsigned int*) calloc( SPLP_MIGRATE_SESSIONS, sizeof( unsigned int ) );
+    migrate.pOwner = (unsigned char*) calloc( SPLP_MIGRATE_SESSIONS, 1 );
+    result.maxSamples = 1u << 16;
+    result.pLatency = (unsigned long long*) malloc( result.maxSamples * sizeof( unsigned long long ) );
+    result.pSamples = (unsigned int*) malloc( result.maxSamples * sizeof( unsigned int ) );
+    if ( !migrate.pHandoff || !migrate.pReady || !migrate.pOwner || !result.pLatency || !result.pSamples ||
+        SPLP_STATUS_OK != SplpMigrateGenerate( &migrate ) )
+        status = SPLP_STATUS_ERROR;
+
+    for ( i = 0; i < migrate.workerCount && status == SPLP_STATUS_OK; i++ )
+    {
+        workers[ i ].pContexts = (PSPLP_MIGRATE_CONTEXT) malloc( SPLP_MIGRATE_SESSIONS * sizeof( SPLP_MIGRATE_CONTEXT ) );
+        workers[ i ].pOwned = (unsigned char*) malloc( SPLP_MIGRATE_SESSIONS );
+        if ( !workers[ i ].pContexts || !workers[ i ].pOwned ||
+            SPLP_STATUS_OK != SplpRingInit( &workers[ i ].ring, DEFAULT_RING_CAPACITY ) )
+            status = SPLP_STATUS_ERROR;
+    }
+
+    if ( status != SPLP_STATUS_OK )
+    {
+        printf( "***ERROR*** Not enough memory for the migration benchmark\n" );
+    }
+    else
+    {
+        printf(
+            "======================================================================\n"
+            " SESSION MIGRATION:\n"
+            "======================================================================\n"
+            "\tWorkers:          \t%14u\n"
+            "\tSessions:         \t%14u\n"
+            "\tMessages/run:     \t%14u\n"
+            "\tMigration every:  \t%14u usec\n\n",
+            migrate.workerCount,
+            SPLP_MIGRATE_SESSIONS,
+            SPLP_MIGRATE_MESSAGES,
+            SPLP_MIGRATE_PERIOD_USEC );
+
+        printf( "\t%-9s %12s %12s %12s %6s %9s %9s %9s %7s %6s\n",
+            "Run", "msg/s", "median/s", "min/s", "Moves", "p50 usec", "p99 usec", "max usec", "Held", "Errors" );
+
+        for ( run = 0; run < 2 && status == SPLP_STATUS_OK; run++ )
+        {
+            status = SplpMigrateRun( &migrate,
+                run ? (unsigned long long) ( ticksPerSecond * SPLP_MIGRATE_PERIOD_USEC / 1000000.0 ) : 0,
+                ticksPerSecond, &result );
+            if ( status == SPLP_STATUS_OK )
+            {
+                errors[ run ] = SplpMigrateCheck( &migrate );
+                SplpMigratePrint( run ? "Migrating" : "Pinned", &result, errors[ run ], ticksPerSecond );
+            }
+        }
+
+        printf( "\n\tmedian/s and min/s are per %u usec sample of the throughput.\n"
+            "======================================================================\n",
+            SPLP_MIGRATE_BUCKET_USEC );
+
+        if ( status == SPLP_STATUS_OK && ( errors[ 0 ] || errors[ 1 ] ) )
+        {
+            printf( "***ERROR*** Messages were lost, reordered or validated by the wrong worker\n" );
+            status = SPLP_STATUS_ERROR;
+        }
+    }
+
+    for ( i = 0; i < migrate.workerCount; i++ )
+    {
+        SplpRingFree( &workers[ i ].ring );
+        free( workers[ i ].pContexts );
+        free( workers[ i ].pOwned );
+    }
+    free( migrate.pStream );
+    free( migrate.pStreamSessions );
+    free( migrate.pFinal );
+    free( migrate.pHandoff );
+    free( (void*) migrate.pReady );
+    free( migrate.pOwner );
+    free( result.pLatency );
+    free( result.pSamples );
+    return status;
+}
@@ -0,0 +1,70 @@
+/*
+* SPLPMIGRATE.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the live migration of sessions
+* between validator worker threads.
+*/
+#ifndef SPLPMIGRATE_H
+#define SPLPMIGRATE_H
+
+#include "splpv1.h"
+#include "splptest.h"
+
+
+
+#define DEFAULT_MIGRATE_WORKERS   4
+#define SPLP_MIGRATE_MAX_WORKERS  64
+#define SPLP_MIGRATE_SESSIONS     4096
+#define SPLP_MIGRATE_MESSAGES     ( 1u << 21 )    /* messages per run */
+#define SPLP_MIGRATE_MAX_PENDING  1024    /* messages held for a migrating session */
+#define SPLP_MIGRATE_PERIOD_USEC  1000    /* time between migrations */
+#define SPLP_MIGRATE_BUCKET_USEC  1000    /* throughput sample interval */
+#define SPLP_MIGRATE_RATE         100000  /* messages per second a session may send */
+#define SPLP_MIGRATE_BURST        64
+
+
+
+
+/* SPLP_MIGRATE_CONTROL
+* Control entries of a worker's ring.
+*/
+typedef enum _SPLP_MIGRATE_CONTROL
+{
+    SPLP_MIGRATE_MESSAGE,         /* validate pMsg */
+    SPLP_MIGRATE_RELEASE,         /* hand the session off and stop serving it */
+    SPLP_MIGRATE_ADOPT,           /* take the session over from its handoff */
+    SPLP_MIGRATE_STOP
+} SPLP_MIGRATE_CONTROL;
+
+
+
+
+/* SPLP_MIGRATE_CONTEXT
+* Everything a worker keeps of a session, and so everything a migration
+* moves: the validator state, the token bucket of the rate limit and
+* the inspection counters.
+*/
+typedef struct _SPLP_MIGRATE_CONTEXT
+{
+    struct Session     session;
+    unsigned long long tokens;         /* rate limit credit, in TSC ticks */
+    unsigned long long refilled;       /* TSC of the last refill */
+    unsigned int       messages;       /* inspection */
+    unsigned int       rejected;
+    unsigned int       limited;        /* messages over the rate */
+
+}SPLP_MIGRATE_CONTEXT, *PSPLP_MIGRATE_CONTEXT;
+
+
+
+
+/* SplpMigrationBenchmark
+* Dispatches one message stream over pOptions->migrateWorkers workers,
+* once with sessions pinned to their first worker and once with the
+* hottest worker giving a session away every SPLP_MIGRATE_PERIOD_USEC,
+* and prints migration latency and throughput of both runs.
+*/
+SPLP_STATUS SplpMigrationBenchmark(
+    PSPLP_TEST_OPTIONS pOptions );
+
+#endif /* SPLPMIGRATE_H */
@@ -0,0 +1,301 @@
+/*
+* SPLPMIX.c
+* The file is part of practical task for System programming course.
+* This file contains the engine comparison on traffic mixes. For every
+* share of invalid messages a corpus of conversations is generated:
+* each message is the next valid one of the session, or with the given
+* probability a corrupted one. The reference validator follows the
+* session, so conversations continue the way a validator sees them.
+* Every engine validates every corpus; the fastest one is reported.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "splpv1.h"
+#include "splpmix.h"
+#include "splpref.h"
+#include "splpengine.h"
+#include "splpbench.h"
+
+
+
+#define SPLP_MIX_TEXT_SIZE        96      /* longest generated message + 1 */
+
+
+
+
+typedef struct _SPLP_MIX_CORPUS
+{
+    struct Message*    pMessages;
+    enum test_status*  pExpected;
+    char*              pText;          /* SPLP_MIX_TEXT_SIZE bytes per message */
+    unsigned int       invalid;
+
+}SPLP_MIX_CORPUS, *PSPLP_MIX_CORPUS;
+
+
+
+
+static unsigned int SplpMixRandom(
+    unsigned long long* pSeed )
+{
+    *pSeed ^= *pSeed >> 12;
+    *pSeed ^= *pSeed << 25;
+    *pSeed ^= *pSeed >> 27;
+    return (unsigned int) ( ( *pSeed * 2685821657736338717ull ) >> 32 );
+}
+
+
+
+
+static void SplpMixFill(
+    char* text,
+    const char* alphabet,
+    unsigned int length,
+    unsigned long long* pSeed )
+{
+    size_t size = strlen( alphabet );
+    unsigned int i;
+
+    for ( i = 0; i < length; i++ )
+        text[ i ] = alphabet[ SplpMixRandom( pSeed ) % size ];
+    text[ length ] = '\0';
+}
+
+
+
+
+/* SplpMixNext
+* Writes the next valid message of a session in the given state.
+*/
+static void SplpMixNext(
+    enum State state,
+    struct Message* pMsg,
+    unsigned long long* pSeed )
+{
+    static const char* requests[ ] = { "GET_DATA", "GET_FILE", "GET_COMMAND", "GET_VER", "GET_B64", "GET_DATA", "GET_B64", "DISCONNECT" };
+    char* text = pMsg->text_message;
+    unsigned int length;
+
+    switch ( state )
+    {
+    case INIT:
+        pMsg->direction = A_TO_B;
+        strcpy( text, "CONNECT" );
+        break;
+    case CONNECTING:
+        pMsg->direction = B_TO_A;
+        strcpy( text, "CONNECT_OK" );
+        break;
+    case CONNECTED:
+        pMsg->direction = A_TO_B;
+        strcpy( text, requests[ SplpMixRandom( pSeed ) % ( sizeof( requests ) / sizeof( requests[ 0 ] ) ) ] );
+        break;
+    case WAITING_VER:
+        pMsg->direction = B_TO_A;
+        strcpy( text, "VERSION " );
+        SplpMixFill( text + 8, "0123456789", 1 + SplpMixRandom( pSeed ) % 5, pSeed );
+        break;
+    case WAITING_DATA:
+        pMsg->direction = B_TO_A;
+        strcpy( text, "GET_DATA " );
+        length = 1 + SplpMixRandom( pSeed ) % 64;
+        SplpMixFill( text + 9, "abcdefghijklmnopqrstuvwxyz0123456789.", length, pSeed );
+        strcpy( text + 9 + length, " GET_DATA" );
+        break;
+    case WAITING_B64_DATA:
+        pMsg->direction = B_TO_A;
+        strcpy( text, "B64: " );
+        length = 4 * ( 1 + SplpMixRandom( pSeed ) % 16 );
+        SplpMixFill( text + 5, "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/", length, pSeed );
+        break;
+    default:
+        pMsg->direction = B_TO_A;
+        strcpy( text, "DISCONNECT_OK" );
+        break;
+    }
+}
+
+
+
+
+/* SplpMixGenerate
+* Builds a corpus with invalid messages at permille probability.
+*/
+static SPLP_STATUS SplpMixGenerate(
+    PSPLP_MIX_CORPUS pCorpus,
+    unsigned int permille )
+{
+    struct Session session = { INIT, REASON_NONE };
+    unsigned long long seed = 0x6a09e667f3bcc909ull ^ permille;
+    unsigned int i;
+
+    pCorpus->pMessages = (struct Message*) malloc( SPLP_MIX_MESSAGES * sizeof( struct Message ) );
+    pCorpus->pExpected = (enum test_status*) malloc( SPLP_MIX_MESSAGES * sizeof( enum test_status ) );
+    pCorpus->pText = (char*) malloc( SPLP_MIX_MESSAGES * SPLP_MIX_TEXT_SIZE );
+    pCorpus->invalid = 0;
+    if ( !pCorpus->pMessages || !pCorpus->pExpected || !pCorpus->pText )
+    {
+        printf( "***ERROR*** Not enough memory for the engine benchmark\n" );
+        return SPLP_STATUS_ERROR;
+    }
+
+    for ( i = 0; i < SPLP_MIX_MESSAGES; i++ )
+    {
+        struct Message* pMsg = &pCorpus->pMessages[ i ];
+
+        pMsg->text_message = pCorpus->pText + (size_t) i * SPLP_MIX_TEXT_SIZE;
+        SplpMixNext( (enum State) session.state, pMsg, &seed );
+
+        if ( SplpMixRandom( &seed ) % 1000 < permille )
+        {
+            /* wrong direction, or a character no message may contain */
+            size_t length = strlen( pMsg->text_message );
+            if ( SplpMixRandom( &seed ) % 4 == 0 )
+                pMsg->direction = pMsg->direction == A_TO_B ? B_TO_A : A_TO_B;
+            else
+                pMsg->text_message[ SplpMixRandom( &seed ) % length ] = '#';
+        }
+
+        pCorpus->pExpected[ i ] = validate_reference_message( &session, pMsg );
+        if ( pCorpus->pExpected[ i ] == MESSAGE_INVALID )
+            pCorpus->invalid++;
+    }
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+static void SplpMixFree(
+    PSPLP_MIX_CORPUS pCorpus )
+{
+    free( pCorpus->pMessages );
+    free( pCorpus->pExpected );
+    free( pCorpus->pText );
+    memset( pCorpus, 0, sizeof( *pCorpus ) );
+}
+
+
+
+
+/* SplpMixTime
+* Median ns per message of an engine on a corpus, 0 if the engine
+* disagrees with the reference.
+*/
+static double SplpMixTime(
+    const SPLP_ENGINE* pEngine,
+    PSPLP_MIX_CORPUS pCorpus,
+    double ticksPerSecond )
+{
+    double samples[ SPLP_BENCH_SAMPLES ];
+    unsigned int sampleIdx;
+    unsigned int i;
+    unsigned int j;
+
+    for ( sampleIdx = 0; sampleIdx < SPLP_BENCH_SAMPLES; sampleIdx++ )
+    {
+        struct Session session = { INIT, REASON_NONE };
+        unsigned int wrong = 0;
+        unsigned long long begin = SplpReadTsc( );
+
+        for ( i = 0; i < SPLP_MIX_MESSAGES; i++ )
+            wrong += pEngine->validate( &session, &pCorpus->pMessages[ i ] ) != pCorpus->pExpected[ i ];
+
+        samples[ sampleIdx ] = ( SplpReadTsc( ) - begin ) * 1e9 / ticksPerSecond / SPLP_MIX_MESSAGES;
+        if ( wrong )
+        {
+            printf( "***ERROR*** Engine \"%s\" gave %u wrong verdicts\n", pEngine->name, wrong );
+            return 0;
+        }
+    }
+
+    /* insertion sort, 9 samples */
+    for ( i = 1; i < SPLP_BENCH_SAMPLES; i++ )
+    {
+        double sample = samples[ i ];
+        for ( j = i; j > 0 && samples[ j - 1 ] > sample; j-- )
+            samples[ j ] = samples[ j - 1 ];
+        samples[ j ] = sample;
+    }
+    return samples[ SPLP_BENCH_SAMPLES / 2 ];
+}
+
+
+
+
+SPLP_STATUS SplpEngineMixBenchmark(
+    PSPLP_TEST_OPTIONS pOptions )
+{
+    unsigned int shares[ SPLP_MIX_MAX_POINTS ];
+    unsigned int shareCount = 0;
+    const char* pShare = pOptions->mixInvalid ? pOptions->mixInvalid : DEFAULT_MIX_INVALID;
+    double ticksPerSecond;
+    unsigned int i;
+    unsigned int e;
+
+    while ( *pShare && shareCount < SPLP_MIX_MAX_POINTS )
+    {
+        char* pEnd;
+        double share = strtod( pShare, &pEnd );
+        if ( pEnd == pShare || share < 0 || share > 100 )
+        {
+            printf( "***ERROR*** Bad invalid share list \"%s\"\n", pOptions->mixInvalid );
+            return SPLP_STATUS_ERROR;
+        }
+        shares[ shareCount++ ] = (unsigned int) ( share * 10 + 0.5 );
+        pShare = *pEnd == ',' ? pEnd + 1 : pEnd;
+    }
+
+    ticksPerSecond = SplpTscTicksPerSecond( );
+
+    printf(
+        "======================================================================\n"
+        " ENGINES BY TRAFFIC MIX (ns/msg):\n"
+        "======================================================================\n"
+        "\tMessages/mix:     \t%14u\n"
+        "\tSamples:          \t%14u\n\n",
+        SPLP_MIX_MESSAGES,
+        SPLP_BENCH_SAMPLES );
+
+    printf( "\t%9s %9s", "Corrupt %", "Invalid %" );
+    for ( e = 0; e < SplpEngineCount; e++ )
+        printf( " %12s", SplpEngines[ e ].name );
+    printf( "  %s\n", "Winner" );
+
+    for ( i = 0; i < shareCount; i++ )
+    {
+        SPLP_MIX_CORPUS corpus;
+        double best = 0;
+        unsigned int winner = 0;
+
+        if ( SPLP_STATUS_OK != SplpMixGenerate( &corpus, shares[ i ] ) )
+        {
+            SplpMixFree( &corpus );
+            return SPLP_STATUS_ERROR;
+        }
+
+        printf( "\t%9.1f %9.1f", shares[ i ] / 10.0, corpus.invalid * 100.0 / SPLP_MIX_MESSAGES );
+        for ( e = 0; e < SplpEngineCount; e++ )
+        {
+            double time = SplpMixTime( &SplpEngines[ e ], &corpus, ticksPerSecond );
+            if ( time == 0 )
+            {
+                SplpMixFree( &corpus );
+                return SPLP_STATUS_ERROR;
+            }
+            if ( best == 0 || time < best )
+            {
+                best = time;
+                winner = e;
+            }
+            printf( " %12.2f", time );
+        }
+        printf( "  %s\n", SplpEngines[ winner ].name );
+
+        SplpMixFree( &corpus );
+    }
+
+    printf( "======================================================================\n" );
+    return SPLP_STATUS_OK;
+}
@@ -0,0 +1,24 @@
+/*
+* SPLPMIX.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the engine comparison on traffic
+* mixes with different shares of invalid messages.
+*/
+#ifndef SPLPMIX_H
+#define SPLPMIX_H
+
+#include "splptest.h"
+
+
+
+#define DEFAULT_MIX_INVALID       "0,1,5,10,25,50"
+#define SPLP_MIX_MESSAGES         65536   /* messages of a generated corpus */
+#define SPLP_MIX_MAX_POINTS       16
+
+
+
+
+SPLP_STATUS SplpEngineMixBenchmark(
+    PSPLP_TEST_OPTIONS pOptions );
+
+#endif /* SPLPMIX_H */
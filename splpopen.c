@@ -0,0 +1,385 @@
+/*
+* SPLPOPEN.c
+* The file is part of practical task for System programming course.
+* This file contains the open-loop load generator. A generator thread
+* sends the test messages into a ring at intended times, independent
+* of how fast the validator thread consumes them. Latency is measured
+* from the intended send time, which corrects for coordinated omission:
+* a stalled validator also delays the generator, and measuring from the
+* actual send time would hide exactly the waits caused by the stall.
+* With a latency SLO the validator thread takes the messages in batches
+* sized by the controller of splpbatch.h.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "splpv1.h"
+#include "splpopen.h"
+#include "splpring.h"
+#include "splpbench.h"
+#include "splplog.h"
+#include "splpalloc.h"
+#include "splpbatch.h"
+
+
+
+
+/* SPLP_OPENLOOP_RUN
+* One load point, shared by the generator and the validator thread.
+*/
+typedef struct _SPLP_OPENLOOP_RUN
+{
+    PSPLP_TEST_DATA      pData;
+    SPLP_RING            ring;
+    unsigned long long   total;
+    unsigned long long   start;          /* TSC of the first intended send */
+    unsigned long long*  pOffsets;       /* intended send times relative to start */
+    unsigned long long*  pCorrected;     /* done - intended */
+    unsigned long long*  pUncorrected;   /* done - sent */
+
+}SPLP_OPENLOOP_RUN, *PSPLP_OPENLOOP_RUN;
+
+
+
+
+static unsigned long long SplpRandom(
+    unsigned long long* pState )
+{
+    /* xorshift64*, good enough for arrival times */
+    *pState ^= *pState >> 12;
+    *pState ^= *pState << 25;
+    *pState ^= *pState >> 27;
+    return *pState * 2685821657736338717ull;
+}
+
+
+
+
+/* SplpOpenLoopSchedule
+* Fills pOffsets with intended send times for a mean gap of interval
+* ticks.
+*/
+static void SplpOpenLoopSchedule(
+    PSPLP_OPENLOOP_RUN pRun,
+    SPLP_ARRIVAL arrival,
+    double interval,
+    const unsigned long long* pTrace,
+    unsigned long long traceCount,
+    double traceMean )
+{
+    unsigned long long seed = 0x9e3779b97f4a7c15ull;
+    double offset = 0;
+    unsigned long long i;
+
+    for ( i = 0; i < pRun->total; i++ )
+    {
+        pRun->pOffsets[ i ] = (unsigned long long) offset;
+
+        switch ( arrival )
+        {
+        case SPLP_ARRIVAL_UNIFORM:
+            offset += interval;
+            break;
+        case SPLP_ARRIVAL_TRACE:
+            offset += pTrace[ i % traceCount ] * interval / traceMean;
+            break;
+        default:
+            offset += -log( ( ( SplpRandom( &seed ) >> 11 ) + 0.5 ) / 9007199254740992.0 ) * interval;
+            break;
+        }
+    }
+}
+
+
+
+
+static SPLP_THREAD_ROUTINE( SplpOpenLoopGenerator, arg )
+{
+    PSPLP_OPENLOOP_RUN pRun = (PSPLP_OPENLOOP_RUN) arg;
+    SPLP_RING_ENTRY entry;
+    unsigned long long i;
+
+    for ( i = 0; i < pRun->total; i++ )
+    {
+        entry.pMsg = &pRun->pData->MessageArray[ i % pRun->pData->size ];
+        entry.intended = pRun->start + pRun->pOffsets[ i ];
+
+        while ( SplpReadTsc( ) < entry.intended )
+            SplpThreadYield( );
+
+        entry.sent = SplpReadTsc( );
+        while ( !SplpRingPush( &pRun->ring, &entry ) )
+            SplpThreadYield( );
+    }
+
+    SPLP_THREAD_RETURN;
+}
+
+
+
+
+static int SplpOpenLoopCompare(
+    const void* pLeft,
+    const void* pRight )
+{
+    unsigned long long left = *(const unsigned long long*) pLeft;
+    unsigned long long right = *(const unsigned long long*) pRight;
+    return left < right ? -1 : left > right ? 1 : 0;
+}
+
+
+
+
+static double SplpOpenLoopPercentile(
+    unsigned long long* pSorted,
+    unsigned long long total,
+    double percentile,
+    double ticksPerSecond )
+{
+    unsigned long long idx = (unsigned long long) ( total * percentile / 100.0 );
+    if ( idx >= total )
+        idx = total - 1;
+    return pSorted[ idx ] * 1000000.0 / ticksPerSecond;
+}
+
+
+
+
+/* SplpOpenLoopRun
+* Runs one load point and prints its line of the curve.
+*/
+static SPLP_STATUS SplpOpenLoopRun(
+    PSPLP_OPENLOOP_RUN pRun,
+    PSPLP_TEST_OPTIONS pOptions,
+    unsigned int load,
+    double capacity,
+    double ticksPerSecond,
+    PSPLP_BATCH_CONTROL pControl )
+{
+    static SPLP_RING_ENTRY batch[ SPLP_BATCH_MAX_SIZE ];
+    SPLP_THREAD generator;
+    SPLP_RING_ENTRY entry;
+    unsigned int count = 0;
+    SPLP_ALLOC_COUNT allocations;
+    unsigned long long correct = 0;
+    unsigned long long done = 0;
+    unsigned long long i;
+
+    reset_state( );
+    SplpBatchInit( pControl, (unsigned long long) ( pOptions->openLoopSlo * ticksPerSecond / 1000000.0 ) );
+    pRun->ring.head = 0;
+    pRun->ring.tail = 0;
+    pRun->start = SplpReadTsc( ) + (unsigned long long) ( ticksPerSecond / 1000 );
+
+    if ( 0 != SplpThreadCreate( &generator, SplpOpenLoopGenerator, pRun ) )
+    {
+        printf( "***ERROR*** Generator thread can't be started\n" );
+        return SPLP_STATUS_ERROR;
+    }
+
+    /* counts the validator thread only, see splpalloc.h */
+    SplpAllocWatchStart( );
+
+    for ( i = 0; i < pRun->total && !pOptions->openLoopSlo; i++ )
+    {
+        while ( !SplpRingPop( &pRun->ring, &entry ) )
+            SplpThreadYield( );
+
+        if ( validate_message( &entry.pMsg->msg ) == entry.pMsg->expectedTestStatus )
+            correct++;
+
+        done = SplpReadTsc( );
+        pRun->pCorrected[ i ] = done - entry.intended;
+        pRun->pUncorrected[ i ] = done - entry.sent;
+    }
+
+    /* batch path, one time stamp and one tail release per batch */
+    for ( i = 0; i < pRun->total && pOptions->openLoopSlo; i += count )
+    {
+        unsigned long long begin;
+        unsigned int depth;
+        unsigned int j;
+
+        while ( 0 == ( depth = SplpRingDepth( &pRun->ring ) ) )
+            SplpThreadYield( );
+
+        count = SplpRingPopBatch( &pRun->ring, batch, SplpBatchSize( pControl, depth ) );
+        begin = SplpReadTsc( );
+        for ( j = 0; j < count; j++ )
+        {
+            if ( validate_message( &batch[ j ].pMsg->msg ) == batch[ j ].pMsg->expectedTestStatus )
+                correct++;
+        }
+
+        done = SplpReadTsc( );
+        SplpBatchDone( pControl, count, done - begin );
+        for ( j = 0; j < count; j++ )
+        {
+            pRun->pCorrected[ i + j ] = done - batch[ j ].intended;
+            pRun->pUncorrected[ i + j ] = done - batch[ j ].sent;
+        }
+    }
+
+    SplpAllocWatchStop( &allocations );
+    SplpThreadJoin( generator );
+
+    qsort( pRun->pCorrected, (size_t) pRun->total, sizeof( unsigned long long ), SplpOpenLoopCompare );
+    qsort( pRun->pUncorrected, (size_t) pRun->total, sizeof( unsigned long long ), SplpOpenLoopCompare );
+
+    printf( "\t%5u%% %12.0f %12.0f %10.2f %10.2f %10.2f %10.2f %12.2f %7llu%s",
+        load,
+        capacity * load / 100.0,
+        pRun->total * ticksPerSecond / (double) ( done - pRun->start ),
+        SplpOpenLoopPercentile( pRun->pCorrected, pRun->total, 50, ticksPerSecond ),
+        SplpOpenLoopPercentile( pRun->pCorrected, pRun->total, 99, ticksPerSecond ),
+        SplpOpenLoopPercentile( pRun->pCorrected, pRun->total, 99.9, ticksPerSecond ),
+        pRun->pCorrected[ pRun->total - 1 ] * 1000000.0 / ticksPerSecond,
+        SplpOpenLoopPercentile( pRun->pUncorrected, pRun->total, 99, ticksPerSecond ),
+        SplpAllocTotal( &allocations ),
+        correct == pRun->total ? "" : " (wrong verdicts)" );
+
+    if ( pOptions->openLoopSlo )
+    {
+        printf( " %9.2f %6u %8llu %8llu\n",
+            pControl->batches ? (double) pControl->messages / pControl->batches : 0,
+            pControl->largest,
+            pControl->grows,
+            pControl->shrinks );
+    }
+    else
+    {
+        printf( "\n" );
+    }
+
+    if ( pOptions->allocCheck && SplpAllocTotal( &allocations ) )
+    {
+        printf( "***ERROR*** The open-loop run called the allocator %llu times\n",
+            SplpAllocTotal( &allocations ) );
+        return SPLP_STATUS_ERROR;
+    }
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+/* SplpOpenLoopCapacity
+* Closed-loop throughput of validate_message( ) on the test file, in
+* messages per second.
+*/
+static double SplpOpenLoopCapacity(
+    PSPLP_TEST_DATA pData,
+    double ticksPerSecond )
+{
+    unsigned long long begin;
+    unsigned int msgIdx;
+
+    reset_state( );
+    begin = SplpReadTsc( );
+    for ( msgIdx = 0; msgIdx < pData->size; msgIdx++ )
+    {
+        validate_message( &pData->MessageArray[ msgIdx ].msg );
+    }
+    return pData->size * ticksPerSecond / (double) ( SplpReadTsc( ) - begin );
+}
+
+
+
+
+SPLP_STATUS SplpOpenLoopBenchmark(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_DATA pData )
+{
+    static const char* arrivalNames[ ] = { "poisson", "uniform", "trace" };
+    SPLP_OPENLOOP_RUN run = { 0 };
+    SPLP_BATCH_CONTROL control;
+    SPLP_STATUS status = SPLP_STATUS_OK;
+    unsigned int loads[ SPLP_OPENLOOP_MAX_POINTS ];
+    unsigned int loadCount = 0;
+    unsigned long long* pTrace = NULL;
+    unsigned long long traceCount = 0;
+    double traceMean = 0;
+    double ticksPerSecond;
+    double capacity;
+    const char* pLoad = pOptions->openLoopLoads ? pOptions->openLoopLoads : DEFAULT_OPENLOOP_LOADS;
+    unsigned int i;
+
+    while ( *pLoad && loadCount < SPLP_OPENLOOP_MAX_POINTS )
+    {
+        char* pEnd;
+        unsigned long load = strtoul( pLoad, &pEnd, 10 );
+        if ( pEnd == pLoad || load == 0 )
+        {
+            printf( "***ERROR*** Bad load list \"%s\"\n", pOptions->openLoopLoads );
+            return SPLP_STATUS_ERROR;
+        }
+        loads[ loadCount++ ] = (unsigned int) load;
+        pLoad = *pEnd == ',' ? pEnd + 1 : pEnd;
+    }
+
+    if ( pOptions->openLoopArrival == SPLP_ARRIVAL_TRACE )
+    {
+        if ( SPLP_STATUS_OK != SplpLogReadIntervals( pOptions->openLoopTrace, &pTrace, &traceCount ) )
+            return SPLP_STATUS_ERROR;
+        for ( i = 0; i < traceCount; i++ )
+            traceMean += (double) pTrace[ i ];
+        traceMean = traceMean > 0 ? traceMean / traceCount : 1;
+    }
+
+    run.pData = pData;
+    run.total = (unsigned long long) pData->size * pOptions->cycleCount;
+    run.pOffsets = (unsigned long long*) malloc( (size_t) run.total * sizeof( unsigned long long ) );
+    run.pCorrected = (unsigned long long*) malloc( (size_t) run.total * sizeof( unsigned long long ) );
+    run.pUncorrected = (unsigned long long*) malloc( (size_t) run.total * sizeof( unsigned long long ) );
+
+    if ( !run.pOffsets || !run.pCorrected || !run.pUncorrected ||
+        SPLP_STATUS_OK != SplpRingInit( &run.ring, DEFAULT_RING_CAPACITY ) )
+    {
+        printf( "***ERROR*** Not enough memory for %llu messages\n", run.total );
+        status = SPLP_STATUS_ERROR;
+    }
+
+    if ( status == SPLP_STATUS_OK )
+    {
+        ticksPerSecond = SplpTscTicksPerSecond( );
+        capacity = SplpOpenLoopCapacity( pData, ticksPerSecond );
+
+        printf(
+            "======================================================================\n"
+            " OPEN-LOOP LOAD:\n"
+            "======================================================================\n"
+            "\tTest file:        \"%s\"\n"
+            "\tMessages/point:   \t%14llu\n"
+            "\tArrivals:         \t%14s\n"
+            "\tCapacity (msg/s): \t%14.0f\n",
+            pOptions->testFileName,
+            run.total,
+            arrivalNames[ pOptions->openLoopArrival ],
+            capacity );
+        if ( pOptions->openLoopSlo )
+            printf( "\tBatch SLO (usec): \t%14u\n", pOptions->openLoopSlo );
+
+        printf( "\n\t%6s %12s %12s %10s %10s %10s %10s %12s %7s",
+            "Load", "Offered/s", "Achieved/s", "p50 usec", "p99 usec", "p999 usec", "max usec", "p99 uncorr.", "Allocs" );
+        if ( pOptions->openLoopSlo )
+            printf( " %9s %6s %8s %8s", "Batch avg", "Max", "Grows", "Shrinks" );
+        printf( "\n" );
+
+        for ( i = 0; i < loadCount && status == SPLP_STATUS_OK; i++ )
+        {
+            SplpOpenLoopSchedule( &run, (SPLP_ARRIVAL) pOptions->openLoopArrival,
+                ticksPerSecond / ( capacity * loads[ i ] / 100.0 ), pTrace, traceCount, traceMean );
+            status = SplpOpenLoopRun( &run, pOptions, loads[ i ], capacity, ticksPerSecond, &control );
+        }
+
+        printf( "======================================================================\n" );
+    }
+
+    SplpRingFree( &run.ring );
+    free( run.pOffsets );
+    free( run.pCorrected );
+    free( run.pUncorrected );
+    free( pTrace );
+    return status;
+}
@@ -0,0 +1,36 @@
+/*
+* SPLPOPEN.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the open-loop load generator.
+*/
+#ifndef SPLPOPEN_H
+#define SPLPOPEN_H
+
+#include "splptest.h"
+
+
+
+#define DEFAULT_OPENLOOP_LOADS    "10,25,50,75,90,100,110,125,150"
+#define SPLP_OPENLOOP_MAX_POINTS  32
+
+
+
+
+/* SPLP_ARRIVAL
+* Distribution of the gaps between intended send times.
+*/
+typedef enum _SPLP_ARRIVAL
+{
+    SPLP_ARRIVAL_POISSON,     /* exponential gaps */
+    SPLP_ARRIVAL_UNIFORM,     /* constant gaps */
+    SPLP_ARRIVAL_TRACE        /* gaps of a verdict log, scaled to the rate */
+} SPLP_ARRIVAL;
+
+
+
+
+SPLP_STATUS SplpOpenLoopBenchmark(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_DATA pData );
+
+#endif /* SPLPOPEN_H */
@@ -0,0 +1,151 @@
+/*
+* SPLPPERF.c
+* The file is part of practical task for System programming course.
+* This file contains the hardware event counters of the benchmarks.
+*/
+#include <string.h>
+#include "splpperf.h"
+
+#if defined( __linux__ )
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+
+
+
+#if defined( __linux__ )
+static int SplpPerfOpenEvent(
+    unsigned int type,
+    unsigned long long config )
+{
+    struct perf_event_attr attr;
+
+    memset( &attr, 0, sizeof( attr ) );
+    attr.size = sizeof( attr );
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall( SYS_perf_event_open, &attr, 0, -1, -1, 0 );
+}
+#endif
+
+
+
+
+void SplpPerfOpen(
+    PSPLP_PERF pPerf )
+{
+    unsigned int i;
+
+    memset( pPerf, 0, sizeof( *pPerf ) );
+    for ( i = 0; i < SPLP_PERF_COUNTER_COUNT; i++ )
+        pPerf->fd[ i ] = -1;
+
+#if defined( __linux__ )
+    pPerf->fd[ SPLP_PERF_INSTRUCTIONS ] =
+        SplpPerfOpenEvent( PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS );
+    pPerf->fd[ SPLP_PERF_L1D_MISSES ] =
+        SplpPerfOpenEvent( PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+            ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 ) );
+    pPerf->fd[ SPLP_PERF_LLC_MISSES ] =
+        SplpPerfOpenEvent( PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES );
+#endif
+
+    for ( i = 0; i < SPLP_PERF_COUNTER_COUNT; i++ )
+    {
+        if ( pPerf->fd[ i ] >= 0 )
+            pPerf->available |= 1u << i;
+    }
+}
+
+
+
+
+void SplpPerfStart(
+    PSPLP_PERF pPerf )
+{
+#if defined( __linux__ )
+    unsigned int i;
+
+    for ( i = 0; i < SPLP_PERF_COUNTER_COUNT; i++ )
+    {
+        if ( pPerf->fd[ i ] < 0 )
+            continue;
+        ioctl( pPerf->fd[ i ], PERF_EVENT_IOC_RESET, 0 );
+        ioctl( pPerf->fd[ i ], PERF_EVENT_IOC_ENABLE, 0 );
+    }
+#else
+    (void) pPerf;
+#endif
+}
+
+
+
+
+void SplpPerfStop(
+    PSPLP_PERF pPerf )
+{
+#if defined( __linux__ )
+    unsigned int i;
+
+    for ( i = 0; i < SPLP_PERF_COUNTER_COUNT; i++ )
+    {
+        pPerf->value[ i ] = 0;
+        if ( pPerf->fd[ i ] < 0 )
+            continue;
+        ioctl( pPerf->fd[ i ], PERF_EVENT_IOC_DISABLE, 0 );
+        if ( read( pPerf->fd[ i ], &pPerf->value[ i ], sizeof( pPerf->value[ i ] ) ) != sizeof( pPerf->value[ i ] ) )
+            pPerf->value[ i ] = 0;
+    }
+#else
+    (void) pPerf;
+#endif
+}
+
+
+
+
+int SplpPerfAvailable(
+    PSPLP_PERF pPerf,
+    SPLP_PERF_COUNTER counter )
+{
+    return ( pPerf->available >> counter ) & 1;
+}
+
+
+
+
+const char* SplpPerfCounterName(
+    SPLP_PERF_COUNTER counter )
+{
+    static const char* names[ SPLP_PERF_COUNTER_COUNT ] =
+    {
+        "instructions", "l1d_misses", "llc_misses"
+    };
+    return names[ counter ];
+}
+
+
+
+
+void SplpPerfClose(
+    PSPLP_PERF pPerf )
+{
+#if defined( __linux__ )
+    unsigned int i;
+
+    for ( i = 0; i < SPLP_PERF_COUNTER_COUNT; i++ )
+    {
+        if ( pPerf->fd[ i ] >= 0 )
+            close( pPerf->fd[ i ] );
+        pPerf->fd[ i ] = -1;
+    }
+#else
+    (void) pPerf;
+#endif
+}
@@ -0,0 +1,75 @@
+/*
+* SPLPPERF.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the hardware event counters used
+* by the benchmarks. Counters are read through perf_event_open( ) on
+* Linux; elsewhere, or when the kernel refuses, they are unavailable
+* and the benchmarks print "n/a".
+*/
+#ifndef SPLPPERF_H
+#define SPLPPERF_H
+
+#include "splptest.h"
+
+
+
+/* SPLP_PERF_COUNTER
+* Events counted for the calling thread.
+*/
+typedef enum _SPLP_PERF_COUNTER
+{
+    SPLP_PERF_INSTRUCTIONS,
+    SPLP_PERF_L1D_MISSES,       /* L1 data cache read misses */
+    SPLP_PERF_LLC_MISSES,       /* last level cache misses */
+    SPLP_PERF_COUNTER_COUNT
+} SPLP_PERF_COUNTER;
+
+
+
+
+typedef struct _SPLP_PERF
+{
+    int                fd[ SPLP_PERF_COUNTER_COUNT ];      /* -1 if unavailable or closed */
+    unsigned long long value[ SPLP_PERF_COUNTER_COUNT ];   /* set by SplpPerfStop( ) */
+    unsigned int       available;  /* bit per counter opened, kept by SplpPerfClose( ) */
+
+}SPLP_PERF, *PSPLP_PERF;
+
+
+
+
+void SplpPerfOpen(
+    PSPLP_PERF pPerf );
+
+
+
+
+void SplpPerfStart(
+    PSPLP_PERF pPerf );
+
+
+
+
+void SplpPerfStop(
+    PSPLP_PERF pPerf );
+
+
+
+
+int SplpPerfAvailable(
+    PSPLP_PERF pPerf,
+    SPLP_PERF_COUNTER counter );
+
+
+
+
+const char* SplpPerfCounterName(
+    SPLP_PERF_COUNTER counter );
+
+
+
+
+void SplpPerfClose(
+    PSPLP_PERF pPerf );
+
+#endif /* SPLPPERF_H */
@@ -0,0 +1,299 @@
+/*
+* SPLPPRIO.c
+* The file is part of practical task for System programming course.
+* This file contains the benchmark of the priority scheduling. Control
+* messages of many sessions arrive at Poisson times, and now and then
+* one large B64 response arrives on another session. The worker admits
+* every message whose arrival time has passed before it runs the
+* scheduler again, so a control message queued behind a bulk payload
+* waits for the whole scan with FIFO scheduling and for one slice with
+* priority scheduling. Latency is measured from the arrival time.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "splpv1.h"
+#include "splpprio.h"
+#include "splpsched.h"
+#include "splpscale.h"
+#include "splpbench.h"
+
+
+
+
+/* SPLP_PRIO_LOAD
+* The mix, jobs sorted by arrival, in TSC ticks from the start.
+*/
+typedef struct _SPLP_PRIO_LOAD
+{
+    PSPLP_SCHED_JOB      pJobs;
+    unsigned int         jobCount;
+    unsigned int         controlCount;
+    unsigned int         bulkCount;
+    char*                pBulkText;
+    unsigned long long*  pControlLatency;
+    unsigned long long*  pBulkLatency;
+
+}SPLP_PRIO_LOAD, *PSPLP_PRIO_LOAD;
+
+
+
+
+/* SPLP_PRIO_RESULT
+* Latency of one scheduler, in microseconds.
+*/
+typedef struct _SPLP_PRIO_RESULT
+{
+    double               control[ 4 ];   /* p50, p99, p99.9, max */
+    double               bulk[ 2 ];      /* p50, max */
+    unsigned int         wrong;          /* verdicts other than MESSAGE_VALID */
+
+}SPLP_PRIO_RESULT, *PSPLP_PRIO_RESULT;
+
+
+
+
+static unsigned long long SplpPrioRandom(
+    unsigned long long* pState )
+{
+    /* xorshift64*, as the open-loop generator */
+    *pState ^= *pState >> 12;
+    *pState ^= *pState << 25;
+    *pState ^= *pState >> 27;
+    return *pState * 2685821657736338717ull;
+}
+
+
+
+
+/* SplpPrioGenerate
+* Control messages follow the conversation of their session, so every
+* message of the mix is valid; bulk payloads go to sessions of their
+* own, waiting for B64 data.
+*/
+static SPLP_STATUS SplpPrioGenerate(
+    PSPLP_PRIO_LOAD pLoad,
+    double ticksPerSecond )
+{
+    struct Session shadow[ SPLP_PRIO_CONTROL_SESSIONS ] = { { 0 } };
+    unsigned long long seed = 0x9e3779b97f4a7c15ull;
+    double interval = ticksPerSecond / SPLP_PRIO_CONTROL_RATE;
+    double period = ticksPerSecond * SPLP_PRIO_BULK_PERIOD_MS / 1000.0;
+    double end = ticksPerSecond * SPLP_PRIO_SECONDS;
+    double controlTime = 0;
+    double bulkTime = period / 2;
+    unsigned int capacity = (unsigned int) ( end / interval * 1.1 + end / period + 16 );
+    unsigned int i;
+
+    pLoad->pJobs = (PSPLP_SCHED_JOB) calloc( capacity, sizeof( SPLP_SCHED_JOB ) );
+    pLoad->pControlLatency = (unsigned long long*) malloc( capacity * sizeof( unsigned long long ) );
+    pLoad->pBulkLatency = (unsigned long long*) malloc( capacity * sizeof( unsigned long long ) );
+    pLoad->pBulkText = (char*) malloc( SPLP_PRIO_BULK_BYTES + 6 );
+    if ( !pLoad->pJobs || !pLoad->pControlLatency || !pLoad->pBulkLatency || !pLoad->pBulkText )
+    {
+        printf( "***ERROR*** Not enough memory for the message mix\n" );
+        return SPLP_STATUS_ERROR;
+    }
+
+    memcpy( pLoad->pBulkText, "B64: ", 5 );
+    for ( i = 0; i < SPLP_PRIO_BULK_BYTES; i += 4 )
+        memcpy( pLoad->pBulkText + 5 + i, "SGVs", 4 );
+    pLoad->pBulkText[ 5 + SPLP_PRIO_BULK_BYTES ] = '\0';
+
+    while ( pLoad->jobCount < capacity )
+    {
+        PSPLP_SCHED_JOB pJob = &pLoad->pJobs[ pLoad->jobCount ];
+
+        if ( bulkTime <= controlTime )
+        {
+            if ( bulkTime >= end )
+                break;
+            pJob->msg.direction = B_TO_A;
+            pJob->msg.text_message = pLoad->pBulkText;
+            pJob->session = SPLP_PRIO_CONTROL_SESSIONS + pLoad->bulkCount++;
+            pJob->length = SPLP_PRIO_BULK_BYTES + 5;
+            pJob->arrival = (unsigned long long) bulkTime;
+            bulkTime += period;
+        }
+        else
+        {
+            unsigned long long random = SplpPrioRandom( &seed );
+            unsigned int session = (unsigned int) ( random >> 40 ) % SPLP_PRIO_CONTROL_SESSIONS;
+
+            if ( controlTime >= end )
+                break;
+            pJob->msg = SplpScaleScript[ shadow[ session ].state ][ random & ( SPLP_SCALE_VARIANTS - 1 ) ];
+            validate_session_message( &shadow[ session ], &pJob->msg );
+            pJob->session = session;
+            pJob->length = (unsigned int) strlen( pJob->msg.text_message );
+            pJob->arrival = (unsigned long long) controlTime;
+            pLoad->controlCount++;
+            controlTime += -log( ( ( SplpPrioRandom( &seed ) >> 11 ) + 0.5 ) / 9007199254740992.0 ) * interval;
+        }
+        pLoad->jobCount++;
+    }
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+static int SplpPrioCompare(
+    const void* pLeft,
+    const void* pRight )
+{
+    unsigned long long left = *(const unsigned long long*) pLeft;
+    unsigned long long right = *(const unsigned long long*) pRight;
+    return left < right ? -1 : left > right ? 1 : 0;
+}
+
+
+
+
+static double SplpPrioPercentile(
+    unsigned long long* pSorted,
+    unsigned int total,
+    double percentile,
+    double ticksPerSecond )
+{
+    unsigned int idx = (unsigned int) ( total * percentile / 100.0 );
+    if ( idx >= total )
+        idx = total - 1;
+    return pSorted[ idx ] * 1000000.0 / ticksPerSecond;
+}
+
+
+
+
+/* SplpPrioRun
+* Replays the mix through one scheduler.
+*/
+static SPLP_STATUS SplpPrioRun(
+    PSPLP_PRIO_LOAD pLoad,
+    unsigned int priority,
+    size_t sliceBytes,
+    double ticksPerSecond,
+    PSPLP_PRIO_RESULT pResult )
+{
+    SPLP_SCHED sched;
+    PSPLP_SCHED_JOB pJob;
+    unsigned long long start;
+    unsigned int controlDone = 0;
+    unsigned int bulkDone = 0;
+    unsigned int next = 0;
+    unsigned int i;
+
+    if ( SPLP_STATUS_OK != SplpSchedInit( &sched, SPLP_PRIO_CONTROL_SESSIONS + pLoad->bulkCount,
+        pLoad->jobCount, priority, sliceBytes ) )
+    {
+        printf( "***ERROR*** Not enough memory for the scheduler\n" );
+        return SPLP_STATUS_ERROR;
+    }
+    for ( i = 0; i < pLoad->bulkCount; i++ )
+        sched.pSessions[ SPLP_PRIO_CONTROL_SESSIONS + i ].state = WAITING_B64_DATA;
+
+    memset( pResult, 0, sizeof( *pResult ) );
+    start = SplpReadTsc( ) + (unsigned long long) ( ticksPerSecond / 1000 );
+
+    while ( controlDone + bulkDone < pLoad->jobCount )
+    {
+        unsigned long long now = SplpReadTsc( );
+
+        while ( next < pLoad->jobCount && start + pLoad->pJobs[ next ].arrival <= now )
+            SplpSchedSubmit( &sched, &pLoad->pJobs[ next++ ] );
+
+        pJob = SplpSchedRun( &sched );
+        if ( pJob == NULL )
+            continue;
+
+        pJob->completion = SplpReadTsc( );
+        if ( pJob->result != MESSAGE_VALID )
+            pResult->wrong++;
+        if ( pJob->session < SPLP_PRIO_CONTROL_SESSIONS )
+            pLoad->pControlLatency[ controlDone++ ] = pJob->completion - start - pJob->arrival;
+        else
+            pLoad->pBulkLatency[ bulkDone++ ] = pJob->completion - start - pJob->arrival;
+    }
+    SplpSchedFree( &sched );
+
+    qsort( pLoad->pControlLatency, controlDone, sizeof( unsigned long long ), SplpPrioCompare );
+    qsort( pLoad->pBulkLatency, bulkDone, sizeof( unsigned long long ), SplpPrioCompare );
+
+    pResult->control[ 0 ] = SplpPrioPercentile( pLoad->pControlLatency, controlDone, 50, ticksPerSecond );
+    pResult->control[ 1 ] = SplpPrioPercentile( pLoad->pControlLatency, controlDone, 99, ticksPerSecond );
+    pResult->control[ 2 ] = SplpPrioPercentile( pLoad->pControlLatency, controlDone, 99.9, ticksPerSecond );
+    pResult->control[ 3 ] = SplpPrioPercentile( pLoad->pControlLatency, controlDone, 100, ticksPerSecond );
+    pResult->bulk[ 0 ] = SplpPrioPercentile( pLoad->pBulkLatency, bulkDone, 50, ticksPerSecond );
+    pResult->bulk[ 1 ] = SplpPrioPercentile( pLoad->pBulkLatency, bulkDone, 100, ticksPerSecond );
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+SPLP_STATUS SplpPriorityBenchmark(
+    PSPLP_TEST_OPTIONS pOptions )
+{
+    static const char* schedNames[ ] = { "FIFO", "Priority" };
+    SPLP_PRIO_LOAD load = { 0 };
+    SPLP_PRIO_RESULT results[ 2 ];
+    SPLP_STATUS status;
+    double ticksPerSecond = SplpTscTicksPerSecond( );
+    unsigned int i;
+
+    status = SplpPrioGenerate( &load, ticksPerSecond );
+
+    if ( status == SPLP_STATUS_OK )
+    {
+        printf(
+            "======================================================================\n"
+            " PRIORITY SCHEDULING:\n"
+            "======================================================================\n"
+            "\tControl messages: \t%14u\n"
+            "\tControl sessions: \t%14u\n"
+            "\tBulk payloads:    \t%14u\n"
+            "\tBulk bytes:       \t%14u\n"
+            "\tSlice bytes:      \t%14u\n\n",
+            load.controlCount,
+            SPLP_PRIO_CONTROL_SESSIONS,
+            load.bulkCount,
+            SPLP_PRIO_BULK_BYTES,
+            pOptions->prioritySlice );
+
+        printf( "\t%-9s %11s %11s %11s %11s %12s %12s %6s\n",
+            "Scheduler", "ctl p50 us", "ctl p99 us", "ctl p999 us", "ctl max us", "bulk p50 us", "bulk max us", "Wrong" );
+
+        for ( i = 0; i < 2 && status == SPLP_STATUS_OK; i++ )
+        {
+            status = SplpPrioRun( &load, i, pOptions->prioritySlice, ticksPerSecond, &results[ i ] );
+            if ( status == SPLP_STATUS_OK )
+            {
+                printf( "\t%-9s %11.2f %11.2f %11.2f %11.2f %12.0f %12.0f %6u\n",
+                    schedNames[ i ],
+                    results[ i ].control[ 0 ], results[ i ].control[ 1 ],
+                    results[ i ].control[ 2 ], results[ i ].control[ 3 ],
+                    results[ i ].bulk[ 0 ], results[ i ].bulk[ 1 ],
+                    results[ i ].wrong );
+            }
+        }
+
+        if ( status == SPLP_STATUS_OK )
+        {
+            printf( "\n\tControl p99 improvement: \t%8.1fx\n",
+                results[ 0 ].control[ 1 ] / ( results[ 1 ].control[ 1 ] > 0 ? results[ 1 ].control[ 1 ] : 1 ) );
+            if ( results[ 0 ].wrong || results[ 1 ].wrong )
+            {
+                printf( "***ERROR*** The schedulers returned wrong verdicts\n" );
+                status = SPLP_STATUS_ERROR;
+            }
+        }
+        printf( "======================================================================\n" );
+    }
+
+    free( load.pJobs );
+    free( load.pControlLatency );
+    free( load.pBulkLatency );
+    free( load.pBulkText );
+    return status;
+}
@@ -0,0 +1,32 @@
+/*
+* SPLPPRIO.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the benchmark of the priority
+* scheduling of control messages over bulk payloads.
+*/
+#ifndef SPLPPRIO_H
+#define SPLPPRIO_H
+
+#include "splptest.h"
+
+
+
+#define SPLP_PRIO_SECONDS         1
+#define SPLP_PRIO_CONTROL_RATE    500000      /* control messages per second */
+#define SPLP_PRIO_CONTROL_SESSIONS 4096
+#define SPLP_PRIO_BULK_BYTES      ( 50u << 20 )
+#define SPLP_PRIO_BULK_PERIOD_MS  200         /* one bulk payload every period */
+
+
+
+
+/* SplpPriorityBenchmark
+* Replays the same open-loop mix of control messages and bulk payloads
+* through a FIFO and a priority scheduler, see splpsched.h, and prints
+* the latency percentiles of both classes. pOptions->prioritySlice is
+* the bulk time slice in payload bytes.
+*/
+SPLP_STATUS SplpPriorityBenchmark(
+    PSPLP_TEST_OPTIONS pOptions );
+
+#endif /* SPLPPRIO_H */
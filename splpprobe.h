@@ -0,0 +1,54 @@
+/*
+ * SPLPPROBE.h
+ * The file is part of practical task for System programming course.
+ * This file contains static tracepoints of validate_message().
+ *
+ * On Linux with <sys/sdt.h> (systemtap-sdt-dev) every probe is a single
+ * nop plus a note in the binary which bpftrace and perf can attach to,
+ * e.g.
+ *
+ *    bpftrace -e 'usdt:./test:splp:reject { @[arg0, arg1] = count(); }'
+ *
+ * Probes of the "splp" provider:
+ *    entry(state, direction, text)     - validate_message() was called
+ *    transition(from, to, verdict)     - validate_message() returns
+ *    reject(state, reason)             - message is rejected
+ *    scan_start(state, pointer)        - payload loop starts
+ *    scan_end(state, length)           - payload loop ends, bytes scanned
+ *
+ * SPLP_USDT is defined by default wherever <sys/sdt.h> is found, so a
+ * stock build has the probe sites; SPLP_NO_USDT leaves them out.
+ * Without SPLP_USDT the probes compile to nothing.
+ */
+#ifndef SPLPPROBE_H
+#define SPLPPROBE_H
+
+/* nested, a compiler without __has_include can't parse it in one #if */
+#if !defined(SPLP_USDT) && !defined(SPLP_NO_USDT) && defined(__linux__) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define SPLP_USDT
+#endif
+#endif
+
+#if defined(SPLP_USDT)
+
+#include <sys/sdt.h>
+
+#define SPLP_PROBE_ENTRY(state, direction, text)	DTRACE_PROBE3(splp, entry, state, direction, text)
+#define SPLP_PROBE_TRANSITION(from, to, verdict)	DTRACE_PROBE3(splp, transition, from, to, verdict)
+#define SPLP_PROBE_REJECT(state, reason)			DTRACE_PROBE2(splp, reject, state, reason)
+#define SPLP_PROBE_SCAN_START(state, pointer)		DTRACE_PROBE2(splp, scan_start, state, pointer)
+#define SPLP_PROBE_SCAN_END(state, length)			DTRACE_PROBE2(splp, scan_end, state, length)
+
+#else
+
+/* arguments are referenced in sizeof only, nothing is evaluated */
+#define SPLP_PROBE_ENTRY(state, direction, text)	((void)sizeof(state), (void)sizeof(direction), (void)sizeof(text))
+#define SPLP_PROBE_TRANSITION(from, to, verdict)	((void)sizeof(from), (void)sizeof(to), (void)sizeof(verdict))
+#define SPLP_PROBE_REJECT(state, reason)			((void)sizeof(state), (void)sizeof(reason))
+#define SPLP_PROBE_SCAN_START(state, pointer)		((void)sizeof(state), (void)sizeof(pointer))
+#define SPLP_PROBE_SCAN_END(state, length)			((void)sizeof(state), (void)sizeof(length))
+
+#endif
+
+#endif /* SPLPPROBE_H */
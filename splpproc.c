@@ -0,0 +1,401 @@
+/*
+* SPLPPROC.c
+* The file is part of practical task for System programming course.
+* This file contains the multi-process mode. Process k of n replays
+* test cycles k, k + n, k + 2n, ... with validate_message( ), so every
+* process owns a disjoint set of sessions and the built-in session of
+* the validator is private to it. Counters and the latency histogram
+* are kept on the stack of the process while it validates and copied
+* into its block once, at the end; nothing is shared on the hot path.
+*
+* POSIX launchers fork( ) the processes, which inherit the test data
+* and an anonymous shared mapping. On Windows the launcher starts its
+* own command line again with --process-worker=k:pid, the process
+* loads the test data itself and opens the mapping named after the
+* launcher pid.
+*/
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#include "splpv1.h"
+#include "splpproc.h"
+#include "splpthread.h"
+#include "splpbench.h"
+
+
+
+#define SPLP_PROC_STRIDE          ( ( sizeof( SPLP_PROC_BLOCK ) + SPLP_PROC_CACHE_LINE - 1 ) & ~(size_t) ( SPLP_PROC_CACHE_LINE - 1 ) )
+#define SPLP_PROC_MAPPING_FORMAT  "Local\\SplpProc%lu"
+#define SPLP_PROC_NAME_SIZE       64
+
+
+
+
+static PSPLP_PROC_BLOCK SplpProcBlock(
+    void* pShared,
+    unsigned int index )
+{
+    return (PSPLP_PROC_BLOCK) ( (char*) pShared + index * SPLP_PROC_STRIDE );
+}
+
+
+
+
+/* SplpProcBucket
+* Bucket b holds latencies of 2^b up to 2^(b+1) - 1 ticks, bucket 0
+* those of 0 and 1.
+*/
+static unsigned int SplpProcBucket(
+    unsigned long long ticks )
+{
+    unsigned int bucket = 0;
+
+    while ( ticks > 1 && bucket < SPLP_PROC_HISTOGRAM_BUCKETS - 1 )
+    {
+        ticks >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+
+
+
+/* SplpProcRun
+* The validator loop of process index.
+*/
+static void SplpProcRun(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_DATA pData,
+    unsigned int index,
+    PSPLP_PROC_BLOCK pBlock )
+{
+    SPLP_PROC_BLOCK block;
+    unsigned int cycleIdx;
+    unsigned int msgIdx;
+
+    memset( &block, 0, sizeof( block ) );
+    block.firstWrongMsg = SPLP_INVALID_MSG_INDEX;
+#if defined( _WIN32 )
+    block.pid = (unsigned int) GetCurrentProcessId( );
+#else
+    block.pid = (unsigned int) getpid( );
+#endif
+
+    block.begin = SplpReadTsc( );
+    for ( cycleIdx = index; cycleIdx < pOptions->cycleCount; cycleIdx += pOptions->processes )
+    {
+        block.sessions++;
+        for ( msgIdx = 0; msgIdx < pData->size; msgIdx++ )
+        {
+            PSPLP_TEST_MESSAGE pMsg = &pData->MessageArray[ msgIdx ];
+            unsigned long long begin = SplpReadTsc( );
+            enum test_status result = validate_message( &pMsg->msg );
+
+            block.histogram[ SplpProcBucket( SplpReadTsc( ) - begin ) ]++;
+
+            if ( result != pMsg->expectedTestStatus )
+            {
+                if ( block.firstWrongMsg == SPLP_INVALID_MSG_INDEX )
+                    block.firstWrongMsg = msgIdx;
+                pMsg->expectedTestStatus == MESSAGE_VALID ? block.falseNegative++ : block.falsePositive++;
+            }
+            else
+            {
+                pMsg->expectedTestStatus == MESSAGE_VALID ? block.truePositive++ : block.trueNegative++;
+            }
+        }
+        block.messages += pData->size;
+    }
+    block.end = SplpReadTsc( );
+
+    *pBlock = block;
+    SplpStoreRelease( &pBlock->done, 1 );
+}
+
+
+
+
+/* SplpProcSum
+* Adds the blocks of finished processes into pTotal. The total spans
+* from the first process start to the last process end.
+*/
+static SPLP_STATUS SplpProcSum(
+    void* pShared,
+    unsigned int processCount,
+    PSPLP_PROC_BLOCK pTotal,
+    PSPLP_PROC_BLOCK pBlocks )
+{
+    SPLP_STATUS status = SPLP_STATUS_OK;
+    unsigned int i;
+    unsigned int b;
+
+    memset( pTotal, 0, sizeof( *pTotal ) );
+    pTotal->firstWrongMsg = SPLP_INVALID_MSG_INDEX;
+
+    for ( i = 0; i < processCount; i++ )
+    {
+        PSPLP_PROC_BLOCK pBlock = &pBlocks[ i ];
+
+        *pBlock = *SplpProcBlock( pShared, i );
+        if ( !pBlock->done )
+        {
+            printf( "***ERROR*** Validator process %u didn't finish\n", i );
+            status = SPLP_STATUS_ERROR;
+            continue;
+        }
+
+        pTotal->truePositive += pBlock->truePositive;
+        pTotal->trueNegative += pBlock->trueNegative;
+        pTotal->falsePositive += pBlock->falsePositive;
+        pTotal->falseNegative += pBlock->falseNegative;
+        if ( pBlock->firstWrongMsg < pTotal->firstWrongMsg )
+            pTotal->firstWrongMsg = pBlock->firstWrongMsg;
+        pTotal->sessions += pBlock->sessions;
+        pTotal->messages += pBlock->messages;
+        if ( pTotal->done == 0 || pBlock->begin < pTotal->begin )
+            pTotal->begin = pBlock->begin;
+        if ( pBlock->end > pTotal->end )
+            pTotal->end = pBlock->end;
+        for ( b = 0; b < SPLP_PROC_HISTOGRAM_BUCKETS; b++ )
+            pTotal->histogram[ b ] += pBlock->histogram[ b ];
+        pTotal->done++;
+    }
+    return status;
+}
+
+
+
+
+#if defined( _WIN32 )
+
+SPLP_STATUS SplpProcessLaunch(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_DATA pData,
+    PSPLP_PROC_BLOCK pTotal,
+    PSPLP_PROC_BLOCK pBlocks )
+{
+    static HANDLE processes[ SPLP_PROC_MAX_PROCESSES ];
+    size_t size = SPLP_PROC_STRIDE * pOptions->processes;
+    const char* commandLine = GetCommandLineA( );
+    char name[ SPLP_PROC_NAME_SIZE ];
+    char* command;
+    HANDLE mapping;
+    void* pShared;
+    unsigned int started;
+    unsigned int i;
+    SPLP_STATUS status = SPLP_STATUS_OK;
+
+    ( void ) pData;
+    sprintf( name, SPLP_PROC_MAPPING_FORMAT, (unsigned long) GetCurrentProcessId( ) );
+    mapping = CreateFileMappingA( INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD) size, name );
+    pShared = mapping ? MapViewOfFile( mapping, FILE_MAP_ALL_ACCESS, 0, 0, size ) : NULL;
+    command = (char*) malloc( strlen( commandLine ) + SPLP_PROC_NAME_SIZE );
+    if ( !pShared || !command )
+    {
+        printf( "***ERROR*** Cannot create the shared statistics segment\n" );
+        if ( pShared )
+            UnmapViewOfFile( pShared );
+        if ( mapping )
+            CloseHandle( mapping );
+        free( command );
+        return SPLP_STATUS_ERROR;
+    }
+    memset( pShared, 0, size );
+
+    fflush( stdout );
+    for ( started = 0; started < pOptions->processes; started++ )
+    {
+        STARTUPINFOA startup;
+        PROCESS_INFORMATION process;
+
+        memset( &startup, 0, sizeof( startup ) );
+        startup.cb = sizeof( startup );
+        sprintf( command, "%s --process-worker=%u:%lu", commandLine, started, (unsigned long) GetCurrentProcessId( ) );
+        if ( !CreateProcessA( NULL, command, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &process ) )
+        {
+            printf( "***ERROR*** Cannot start validator process %u\n", started );
+            status = SPLP_STATUS_ERROR;
+            break;
+        }
+        CloseHandle( process.hThread );
+        processes[ started ] = process.hProcess;
+    }
+
+    for ( i = 0; i < started; i++ )
+    {
+        WaitForSingleObject( processes[ i ], INFINITE );
+        CloseHandle( processes[ i ] );
+    }
+
+    if ( status == SPLP_STATUS_OK )
+        status = SplpProcSum( pShared, pOptions->processes, pTotal, pBlocks );
+
+    UnmapViewOfFile( pShared );
+    CloseHandle( mapping );
+    free( command );
+    return status;
+}
+
+
+
+
+SPLP_STATUS SplpProcessWorker(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_DATA pData )
+{
+    size_t size = SPLP_PROC_STRIDE * pOptions->processes;
+    char name[ SPLP_PROC_NAME_SIZE ];
+    HANDLE mapping;
+    void* pShared;
+
+    sprintf( name, SPLP_PROC_MAPPING_FORMAT, (unsigned long) pOptions->processLauncher );
+    mapping = OpenFileMappingA( FILE_MAP_ALL_ACCESS, FALSE, name );
+    pShared = mapping ? MapViewOfFile( mapping, FILE_MAP_ALL_ACCESS, 0, 0, size ) : NULL;
+    if ( !pShared || pOptions->processIndex >= pOptions->processes )
+    {
+        if ( mapping )
+            CloseHandle( mapping );
+        return SPLP_STATUS_ERROR;
+    }
+
+    SplpProcRun( pOptions, pData, pOptions->processIndex, SplpProcBlock( pShared, pOptions->processIndex ) );
+
+    UnmapViewOfFile( pShared );
+    CloseHandle( mapping );
+    return SPLP_STATUS_OK;
+}
+
+#else
+
+SPLP_STATUS SplpProcessLaunch(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_DATA pData,
+    PSPLP_PROC_BLOCK pTotal,
+    PSPLP_PROC_BLOCK pBlocks )
+{
+    static pid_t processes[ SPLP_PROC_MAX_PROCESSES ];
+    size_t size = SPLP_PROC_STRIDE * pOptions->processes;
+    void* pShared;
+    unsigned int started;
+    unsigned int i;
+    SPLP_STATUS status = SPLP_STATUS_OK;
+
+    pShared = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+    if ( pShared == MAP_FAILED )
+    {
+        printf( "***ERROR*** Cannot create the shared statistics segment\n" );
+        return SPLP_STATUS_ERROR;
+    }
+    memset( pShared, 0, size );
+
+    /* buffered output would be printed again by every process */
+    fflush( stdout );
+    for ( started = 0; started < pOptions->processes; started++ )
+    {
+        pid_t pid = fork( );
+        if ( pid == 0 )
+        {
+            SplpProcRun( pOptions, pData, started, SplpProcBlock( pShared, started ) );
+            _exit( 0 );
+        }
+        if ( pid < 0 )
+        {
+            printf( "***ERROR*** Cannot start validator process %u\n", started );
+            status = SPLP_STATUS_ERROR;
+            break;
+        }
+        processes[ started ] = pid;
+    }
+
+    for ( i = 0; i < started; i++ )
+        waitpid( processes[ i ], NULL, 0 );
+
+    if ( status == SPLP_STATUS_OK )
+        status = SplpProcSum( pShared, pOptions->processes, pTotal, pBlocks );
+
+    munmap( pShared, size );
+    return status;
+}
+
+
+
+
+SPLP_STATUS SplpProcessWorker(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_DATA pData )
+{
+    /* fork( ) starts the processes, they never parse --process-worker */
+    ( void ) pOptions;
+    ( void ) pData;
+    printf( "***ERROR*** --process-worker is used on Windows only\n" );
+    return SPLP_STATUS_ERROR;
+}
+
+#endif
+
+
+
+
+void SplpProcessPrint(
+    PSPLP_TEST_OPTIONS pOptions,
+    const SPLP_PROC_BLOCK* pTotal,
+    const SPLP_PROC_BLOCK* pBlocks )
+{
+    double ticksPerSecond = SplpTscTicksPerSecond( );
+    unsigned long long below = 0;
+    unsigned int i;
+    unsigned int b;
+
+    printf(
+        "======================================================================\n"
+        " PROCESSES:\n"
+        "======================================================================\n"
+        "\tProcesses:        \t%14u\n"
+        "\tSessions:         \t%14u\n"
+        "\tMessages:         \t%14llu\n\n",
+        pOptions->processes,
+        pTotal->sessions,
+        pTotal->messages );
+
+    printf( "\t%5s %10s %10s %12s %10s %12s\n", "#", "PID", "Sessions", "Messages", "Wrong", "M msg/s" );
+    for ( i = 0; i < pOptions->processes; i++ )
+    {
+        const SPLP_PROC_BLOCK* pBlock = &pBlocks[ i ];
+        double seconds = ( pBlock->end - pBlock->begin ) / ticksPerSecond;
+
+        printf( "\t%5u %10u %10u %12llu %10u %12.2f\n",
+            i,
+            pBlock->pid,
+            pBlock->sessions,
+            pBlock->messages,
+            pBlock->falsePositive + pBlock->falseNegative,
+            seconds > 0 ? pBlock->messages / seconds / 1e6 : 0 );
+    }
+
+    printf( "\n Latency (TSC ticks per message, all processes):\n" );
+    printf( "\t%10s %10s %14s %10s\n", "From", "To", "Messages", "Cumul. %" );
+    for ( b = 0; b < SPLP_PROC_HISTOGRAM_BUCKETS; b++ )
+    {
+        if ( pTotal->histogram[ b ] == 0 )
+            continue;
+        below += pTotal->histogram[ b ];
+        printf( "\t%10llu %10llu %14llu %10.4f\n",
+            b ? 1ull << b : 0,
+            ( 2ull << b ) - 1,
+            pTotal->histogram[ b ],
+            pTotal->messages ? below * 100.0 / pTotal->messages : 0 );
+    }
+
+    printf( "======================================================================\n" );
+}
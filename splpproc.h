@@ -0,0 +1,82 @@
+/*
+* SPLPPROC.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the multi-process mode. The test
+* cycles are split over validator processes, every process writes its
+* statistics into its own block of a shared memory segment and the
+* launcher sums the blocks when all processes are done.
+*/
+#ifndef SPLPPROC_H
+#define SPLPPROC_H
+
+#include "splptest.h"
+
+
+
+#define SPLP_PROC_MAX_PROCESSES   64
+#define SPLP_PROC_HISTOGRAM_BUCKETS 32    /* log2 of TSC ticks per message */
+#define SPLP_PROC_CACHE_LINE      64
+
+
+
+
+/* SPLP_PROC_BLOCK
+* Counters of one process. Only the owner writes its block, and only
+* the launcher reads it, after the owner exited; blocks are cache line
+* aligned in the segment so processes never write to a shared line.
+*/
+typedef struct _SPLP_PROC_BLOCK
+{
+    unsigned int       truePositive;
+    unsigned int       trueNegative;
+    unsigned int       falsePositive;
+    unsigned int       falseNegative;
+    unsigned int       firstWrongMsg;
+    unsigned int       sessions;       /* test cycles replayed, one session each */
+    unsigned int       done;           /* set when the counters are complete */
+    unsigned int       pid;
+    unsigned long long messages;
+    unsigned long long begin;          /* TSC */
+    unsigned long long end;
+    unsigned long long histogram[ SPLP_PROC_HISTOGRAM_BUCKETS ];
+
+}SPLP_PROC_BLOCK, *PSPLP_PROC_BLOCK;
+
+
+
+
+/* SplpProcessLaunch
+* Starts pOptions->processes validator processes, waits for them and
+* sums their blocks into the counters of *pTotal. pBlocks receives a
+* copy of every block, pOptions->processes entries.
+*/
+SPLP_STATUS SplpProcessLaunch(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_DATA pData,
+    PSPLP_PROC_BLOCK pTotal,
+    PSPLP_PROC_BLOCK pBlocks );
+
+
+
+
+/* SplpProcessWorker
+* Entry of a validator process started by SplpProcessLaunch( ) on
+* Windows, which has no fork( ). The segment is found by the launcher
+* pid given on the command line.
+*/
+SPLP_STATUS SplpProcessWorker(
+    PSPLP_TEST_OPTIONS pOptions,
+    PSPLP_TEST_DATA pData );
+
+
+
+
+/* SplpProcessPrint
+* Prints the processes and the merged latency histogram.
+*/
+void SplpProcessPrint(
+    PSPLP_TEST_OPTIONS pOptions,
+    const SPLP_PROC_BLOCK* pTotal,
+    const SPLP_PROC_BLOCK* pBlocks );
+
+#endif /* SPLPPROC_H */
@@ -0,0 +1,179 @@
+/*
+ * SPLPREF.c
+ * The file is part of practical task for System programming course.
+ * This file contains the reference validator of SPLPv1 protocol.
+ *
+ * It follows the state table in SPLPv1.c rule by rule and keeps the
+ * established behaviour of validate_message() where the table says
+ * nothing:
+ *  - an unknown request in CONNECTED is rejected, the state is kept
+ *  - an unknown response in WAITING_DATA is accepted, the state is kept
+ *  - the response of WAITING_DATA may carry any data command, not only
+ *    the requested one
+ *  - VERSION accepts an empty or zero version
+ * Inputs validate_message() reads out of bounds for are given a
+ * defined verdict: bytes >= 0x80 are never allowed characters and a
+ * base64 payload shorter than 2 characters is rejected as a character
+ * error.
+ */
+
+#include "splpref.h"
+#include <string.h>
+#include "stdbool.h"
+
+
+static bool is_data_char(unsigned char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '.';
+}
+
+
+static bool is_base64_char(unsigned char c)
+{
+	return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '+' || c == '/';
+}
+
+
+static enum test_status reference_reject(struct Session* session, enum Reason why)
+{
+	session->state = INIT;
+	session->reason = why;
+	return MESSAGE_INVALID;
+}
+
+
+static enum test_status reference_accept(struct Session* session, enum State next)
+{
+	session->state = next;
+	return MESSAGE_VALID;
+}
+
+
+// "CMD data CMD" where data is [a-z0-9.]* and CMD is the given command
+static enum test_status reference_data(struct Session* session, const char* text, const char* command)
+{
+	size_t length = strlen(command);
+	const unsigned char* pointer = (const unsigned char*)text + length + 1;
+
+	if (text[length] != ' ')
+		return reference_reject(session, REASON_FORMAT);
+	for (; *pointer != ' ' && *pointer != '\0'; pointer++)
+	{
+		if (!is_data_char(*pointer))
+			return reference_reject(session, REASON_CHARACTER);
+	}
+	if (*pointer == '\0' || strcmp((const char*)pointer + 1, command) != 0)
+		return reference_reject(session, REASON_FORMAT);
+	return reference_accept(session, CONNECTED);
+}
+
+
+// "B64: data", data are base64 characters with up to two '=' of padding
+static enum test_status reference_base64(struct Session* session, const char* text)
+{
+	const unsigned char* payload = (const unsigned char*)text + 5;
+	size_t length = strlen((const char*)payload);
+	size_t i;
+
+	if (text[4] != ' ')
+		return reference_reject(session, REASON_FORMAT);
+	if (length < 2)
+		return reference_reject(session, REASON_CHARACTER);
+	for (i = 0; i + 2 < length; i++)
+	{
+		if (!is_base64_char(payload[i]))
+			return reference_reject(session, REASON_CHARACTER);
+	}
+	if (is_base64_char(payload[length - 2]))
+	{
+		if (!is_base64_char(payload[length - 1]) && payload[length - 1] != '=')
+			return reference_reject(session, REASON_CHARACTER);
+	}
+	else if (payload[length - 2] != '=' || payload[length - 1] != '=')
+	{
+		return reference_reject(session, REASON_CHARACTER);
+	}
+	if (length % 4 != 0)
+		return reference_reject(session, REASON_LENGTH);
+	return reference_accept(session, CONNECTED);
+}
+
+
+enum test_status validate_reference_message(struct Session* session, struct Message* msg)
+{
+	const char* text = msg->text_message;
+	const char* digit;
+
+	switch (session->state)
+	{
+	case INIT:
+		if (strcmp(text, "CONNECT") != 0)
+			return reference_reject(session, REASON_UNEXPECTED);
+		if (msg->direction != A_TO_B)
+			return reference_reject(session, REASON_DIRECTION);
+		return reference_accept(session, CONNECTING);
+
+	case CONNECTING:
+		if (strcmp(text, "CONNECT_OK") != 0)
+			return reference_reject(session, REASON_UNEXPECTED);
+		if (msg->direction != B_TO_A)
+			return reference_reject(session, REASON_DIRECTION);
+		return reference_accept(session, CONNECTED);
+
+	case CONNECTED:
+		if (msg->direction != A_TO_B)
+			return reference_reject(session, REASON_DIRECTION);
+		if (strcmp(text, "GET_DATA") == 0 || strcmp(text, "GET_FILE") == 0 || strcmp(text, "GET_COMMAND") == 0)
+			return reference_accept(session, WAITING_DATA);
+		if (strcmp(text, "DISCONNECT") == 0)
+			return reference_accept(session, DISCONNECTING);
+		if (strcmp(text, "GET_B64") == 0)
+			return reference_accept(session, WAITING_B64_DATA);
+		if (strcmp(text, "GET_VER") == 0)
+			return reference_accept(session, WAITING_VER);
+		session->reason = REASON_UNEXPECTED;
+		return MESSAGE_INVALID;
+
+	case WAITING_VER:
+		if (msg->direction != B_TO_A)
+			return reference_reject(session, REASON_DIRECTION);
+		if (strncmp(text, "VERSION", 7) != 0)
+			return reference_reject(session, REASON_UNEXPECTED);
+		if (text[7] != ' ')
+			return reference_reject(session, REASON_FORMAT);
+		for (digit = text + 8; *digit != '\0'; digit++)
+		{
+			if (*digit < '0' || *digit > '9')
+				return reference_reject(session, REASON_CHARACTER);
+		}
+		return reference_accept(session, CONNECTED);
+
+	case WAITING_DATA:
+		if (msg->direction != B_TO_A)
+			return reference_reject(session, REASON_DIRECTION);
+		if (strncmp(text, "GET_DATA", 8) == 0)
+			return reference_data(session, text, "GET_DATA");
+		if (strncmp(text, "GET_FILE", 8) == 0)
+			return reference_data(session, text, "GET_FILE");
+		if (strncmp(text, "GET_COMMAND", 11) == 0)
+			return reference_data(session, text, "GET_COMMAND");
+		return MESSAGE_VALID;
+
+	case WAITING_B64_DATA:
+		if (msg->direction != B_TO_A)
+			return reference_reject(session, REASON_DIRECTION);
+		if (strncmp(text, "B64:", 4) != 0)
+			return reference_reject(session, REASON_UNEXPECTED);
+		return reference_base64(session, text);
+
+	case DISCONNECTING:
+		if (strcmp(text, "DISCONNECT_OK") != 0)
+			return reference_reject(session, REASON_UNEXPECTED);
+		if (msg->direction != B_TO_A)
+			return reference_reject(session, REASON_DIRECTION);
+		return reference_accept(session, INIT);
+
+	default:
+		return MESSAGE_VALID;
+	}
+}
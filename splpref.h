@@ -0,0 +1,15 @@
+/*
+ * SPLPREF.h
+ * The file is part of practical task for System programming course.
+ * This file contains declaration of the reference validator, a direct
+ * transcription of the SPLPv1 state table without any optimization.
+ * Optimized engines are checked against it by the fuzz target.
+ */
+#ifndef SPLPREF_H
+#define SPLPREF_H
+
+#include "splpv1.h"
+
+extern enum test_status validate_reference_message( struct Session* pSession, struct Message* pMessage );
+
+#endif /* SPLPREF_H */
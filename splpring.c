@@ -0,0 +1,38 @@
+/*
+* SPLPRING.c
+* The file is part of practical task for System programming course.
+* This file contains the single producer, single consumer ring.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "splpring.h"
+
+
+
+
+SPLP_STATUS SplpRingInit(
+    PSPLP_RING pRing,
+    unsigned int capacity )
+{
+    memset( pRing, 0, sizeof( *pRing ) );
+
+    if ( capacity == 0 || ( capacity & ( capacity - 1 ) ) != 0 )
+        return SPLP_STATUS_ERROR;
+
+    pRing->pEntries = (PSPLP_RING_ENTRY) calloc( capacity, sizeof( SPLP_RING_ENTRY ) );
+    if ( !pRing->pEntries )
+        return SPLP_STATUS_ERROR;
+
+    pRing->mask = capacity - 1;
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+void SplpRingFree(
+    PSPLP_RING pRing )
+{
+    free( pRing->pEntries );
+    pRing->pEntries = NULL;
+}
@@ -0,0 +1,145 @@
+/*
+* SPLPRING.h
+* The file is part of practical task for System programming course.
+* This file contains the single producer, single consumer ring which
+* feeds messages to a validator thread.
+*/
+#ifndef SPLPRING_H
+#define SPLPRING_H
+
+#include "splptest.h"
+#include "splpthread.h"
+
+
+
+#define SPLP_RING_CACHE_LINE      64
+#define DEFAULT_RING_CAPACITY     4096    /* entries, power of 2 */
+
+
+
+
+/* SPLP_RING_ENTRY
+* A queued message with the time it was meant to be sent and the time
+* it actually was. Workers serving many sessions also get the session
+* of the message, and control entries without a message, see
+* splpmigrate.c.
+*/
+typedef struct _SPLP_RING_ENTRY
+{
+    PSPLP_TEST_MESSAGE pMsg;
+    unsigned long long intended;
+    unsigned long long sent;
+    unsigned int       session;
+    unsigned int       control;        /* 0 for a message */
+
+}SPLP_RING_ENTRY, *PSPLP_RING_ENTRY;
+
+
+
+
+/* SPLP_RING
+* head is written by the producer only, tail by the consumer only.
+* They live on separate cache lines so the threads don't share a line
+* for every message.
+*/
+typedef struct _SPLP_RING
+{
+    volatile unsigned int head;
+    char                  headPadding[ SPLP_RING_CACHE_LINE - sizeof( unsigned int ) ];
+    volatile unsigned int tail;
+    char                  tailPadding[ SPLP_RING_CACHE_LINE - sizeof( unsigned int ) ];
+    unsigned int          mask;
+    PSPLP_RING_ENTRY      pEntries;
+
+}SPLP_RING, *PSPLP_RING;
+
+
+
+
+SPLP_STATUS SplpRingInit(
+    PSPLP_RING pRing,
+    unsigned int capacity );
+
+
+
+
+void SplpRingFree(
+    PSPLP_RING pRing );
+
+
+
+
+/* SplpRingPush
+* Returns 0 if the ring is full.
+*/
+static __inline int SplpRingPush(
+    PSPLP_RING pRing,
+    const SPLP_RING_ENTRY* pEntry )
+{
+    unsigned int head = pRing->head;
+
+    if ( head - SplpLoadAcquire( &pRing->tail ) > pRing->mask )
+        return 0;
+
+    pRing->pEntries[ head & pRing->mask ] = *pEntry;
+    SplpStoreRelease( &pRing->head, head + 1 );
+    return 1;
+}
+
+
+
+
+/* SplpRingPop
+* Returns 0 if the ring is empty.
+*/
+static __inline int SplpRingPop(
+    PSPLP_RING pRing,
+    PSPLP_RING_ENTRY pEntry )
+{
+    unsigned int tail = pRing->tail;
+
+    if ( tail == SplpLoadAcquire( &pRing->head ) )
+        return 0;
+
+    *pEntry = pRing->pEntries[ tail & pRing->mask ];
+    SplpStoreRelease( &pRing->tail, tail + 1 );
+    return 1;
+}
+
+
+
+
+/* SplpRingPopBatch
+* Pops up to count entries with one release of the tail. Returns the
+* number popped, 0 if the ring is empty.
+*/
+static __inline unsigned int SplpRingPopBatch(
+    PSPLP_RING pRing,
+    PSPLP_RING_ENTRY pEntries,
+    unsigned int count )
+{
+    unsigned int tail = pRing->tail;
+    unsigned int available = SplpLoadAcquire( &pRing->head ) - tail;
+    unsigned int i;
+
+    if ( count > available )
+        count = available;
+    for ( i = 0; i < count; i++ )
+        pEntries[ i ] = pRing->pEntries[ ( tail + i ) & pRing->mask ];
+    SplpStoreRelease( &pRing->tail, tail + count );
+    return count;
+}
+
+
+
+
+/* SplpRingDepth
+* Number of queued entries as seen by the consumer.
+*/
+static __inline unsigned int SplpRingDepth(
+    PSPLP_RING pRing )
+{
+    return SplpLoadAcquire( &pRing->head ) - pRing->tail;
+}
+
+#endif /* SPLPRING_H */
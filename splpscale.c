@@ -0,0 +1,233 @@
+/*
+* SPLPSCALE.c
+* The file is part of practical task for System programming course.
+* This file contains the session-count scaling benchmark. Every message
+* goes to a randomly chosen session out of N, and is the next valid
+* message of that session's conversation, so the session table is
+* read and written in an order the cache cannot predict. As N grows
+* the table falls out of L1, L2, L3 and finally into DRAM.
+* Sessions start in states drawn from the steady state of the script,
+* and a warm-up run precedes the timed one, so a point doesn't time the
+* first CONNECT of sessions which are touched less than once a run.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include "splpv1.h"
+#include "splpscale.h"
+#include "splpbench.h"
+#include "splpperf.h"
+
+
+
+static char SplpScaleConnect[ ] = "CONNECT";
+static char SplpScaleConnectOk[ ] = "CONNECT_OK";
+static char SplpScaleGetVer[ ] = "GET_VER";
+static char SplpScaleGetData[ ] = "GET_DATA";
+static char SplpScaleGetB64[ ] = "GET_B64";
+static char SplpScaleDisconnect[ ] = "DISCONNECT";
+static char SplpScaleVersion[ ] = "VERSION 2";
+static char SplpScaleData[ ] = "GET_DATA abc.1 GET_DATA";
+static char SplpScaleB64Data[ ] = "B64: SGVsbG8=";
+static char SplpScaleDisconnectOk[ ] = "DISCONNECT_OK";
+
+
+
+
+/* SplpScaleScript
+* The next valid message for every state. CONNECTED picks one of four
+* requests, all other states have a single answer.
+*/
+const struct Message SplpScaleScript[ DISCONNECTING + 1 ][ SPLP_SCALE_VARIANTS ] =
+{
+    /* INIT */
+    { { A_TO_B, SplpScaleConnect }, { A_TO_B, SplpScaleConnect },
+      { A_TO_B, SplpScaleConnect }, { A_TO_B, SplpScaleConnect } },
+    /* CONNECTING */
+    { { B_TO_A, SplpScaleConnectOk }, { B_TO_A, SplpScaleConnectOk },
+      { B_TO_A, SplpScaleConnectOk }, { B_TO_A, SplpScaleConnectOk } },
+    /* CONNECTED */
+    { { A_TO_B, SplpScaleGetData }, { A_TO_B, SplpScaleGetVer },
+      { A_TO_B, SplpScaleGetB64 }, { A_TO_B, SplpScaleDisconnect } },
+    /* WAITING_VER */
+    { { B_TO_A, SplpScaleVersion }, { B_TO_A, SplpScaleVersion },
+      { B_TO_A, SplpScaleVersion }, { B_TO_A, SplpScaleVersion } },
+    /* WAITING_DATA */
+    { { B_TO_A, SplpScaleData }, { B_TO_A, SplpScaleData },
+      { B_TO_A, SplpScaleData }, { B_TO_A, SplpScaleData } },
+    /* WAITING_B64_DATA */
+    { { B_TO_A, SplpScaleB64Data }, { B_TO_A, SplpScaleB64Data },
+      { B_TO_A, SplpScaleB64Data }, { B_TO_A, SplpScaleB64Data } },
+    /* DISCONNECTING */
+    { { B_TO_A, SplpScaleDisconnectOk }, { B_TO_A, SplpScaleDisconnectOk },
+      { B_TO_A, SplpScaleDisconnectOk }, { B_TO_A, SplpScaleDisconnectOk } }
+};
+
+
+
+
+/* SplpScaleSteady
+* States of a session in the steady state of SplpScaleScript: a
+* conversation is INIT, CONNECTING, on average 4 visits to CONNECTED
+* with a request answered after all but the last, and DISCONNECTING;
+* 10 messages, each state its share of them.
+*/
+static const unsigned char SplpScaleSteady[ 10 ] =
+{
+    INIT, CONNECTING, CONNECTED, CONNECTED, CONNECTED, CONNECTED,
+    WAITING_VER, WAITING_DATA, WAITING_B64_DATA, DISCONNECTING
+};
+
+
+
+
+/* SplpScaleWarm
+* Puts every session into a random state of SplpScaleSteady. It writes
+* the whole table, which also keeps page faults out of the timing.
+*/
+static void SplpScaleWarm(
+    struct Session* pSessions,
+    unsigned int sessionCount )
+{
+    unsigned long long seed = 0x9e3779b97f4a7c15ull;
+    unsigned int i;
+
+    for ( i = 0; i < sessionCount; i++ )
+    {
+        seed ^= seed >> 12;
+        seed ^= seed << 25;
+        seed ^= seed >> 27;
+
+        pSessions[ i ].state = SplpScaleSteady[ ( ( ( seed * 2685821657736338717ull ) >> 32 ) * 10 ) >> 32 ];
+        pSessions[ i ].reason = REASON_NONE;
+    }
+}
+
+
+
+
+/* SplpScaleRun
+* Validates messageCount messages spread over sessionCount sessions,
+* the sequence given by seed. Returns TSC ticks, *pInvalid receives the
+* number of rejects, which must be 0.
+*/
+static unsigned long long SplpScaleRun(
+    struct Session* pSessions,
+    unsigned int sessionCount,
+    unsigned long long messageCount,
+    unsigned long long seed,
+    unsigned long long* pInvalid )
+{
+    unsigned long long invalid = 0;
+    unsigned long long begin;
+    unsigned long long i;
+
+    begin = SplpReadTsc( );
+    for ( i = 0; i < messageCount; i++ )
+    {
+        struct Session* pSession;
+        unsigned long long random;
+
+        seed ^= seed >> 12;
+        seed ^= seed << 25;
+        seed ^= seed >> 27;
+        random = seed * 2685821657736338717ull;
+
+        pSession = &pSessions[ ( ( random >> 32 ) * sessionCount ) >> 32 ];
+        if ( MESSAGE_VALID != validate_session_message( pSession,
+                (struct Message*) &SplpScaleScript[ pSession->state ][ random & ( SPLP_SCALE_VARIANTS - 1 ) ] ) )
+            invalid++;
+    }
+
+    *pInvalid = invalid;
+    return SplpReadTsc( ) - begin;
+}
+
+
+
+
+SPLP_STATUS SplpScaleBenchmark(
+    PSPLP_TEST_OPTIONS pOptions )
+{
+    unsigned long long counts[ SPLP_SCALE_MAX_POINTS ];
+    unsigned int countCount = 0;
+    unsigned long long messageCount;
+    const char* pCount = pOptions->scaleSessions ? pOptions->scaleSessions : DEFAULT_SCALE_SESSIONS;
+    double ticksPerSecond;
+    SPLP_PERF perf;
+    unsigned int i;
+
+    while ( *pCount && countCount < SPLP_SCALE_MAX_POINTS )
+    {
+        char* pEnd;
+        unsigned long long count = strtoull( pCount, &pEnd, 10 );
+        if ( pEnd == pCount || count == 0 || count > 0xffffffffull )
+        {
+            printf( "***ERROR*** Bad session count list \"%s\"\n", pOptions->scaleSessions );
+            return SPLP_STATUS_ERROR;
+        }
+        counts[ countCount++ ] = count;
+        pCount = *pEnd == ',' ? pEnd + 1 : pEnd;
+    }
+
+    messageCount = SPLP_SCALE_MESSAGES;
+    ticksPerSecond = SplpTscTicksPerSecond( );
+    SplpPerfOpen( &perf );
+
+    printf(
+        "======================================================================\n"
+        " SESSION SCALING:\n"
+        "======================================================================\n"
+        "\tMessages/point:   \t%14llu\n"
+        "\tWarm-up messages: \t%14u\n"
+        "\tBytes/session:    \t%14u\n\n",
+        messageCount,
+        SPLP_SCALE_WARMUP,
+        (unsigned int) sizeof( struct Session ) );
+
+    printf( "\t%10s %12s %10s %12s %12s %12s\n",
+        "Sessions", "Table bytes", "ns/msg", "instr/msg", "L1D miss/msg", "LLC miss/msg" );
+
+    for ( i = 0; i < countCount; i++ )
+    {
+        struct Session* pSessions;
+        unsigned long long warmupInvalid;
+        unsigned long long invalid;
+        unsigned long long ticks;
+        unsigned int c;
+
+        pSessions = (struct Session*) malloc( (size_t) counts[ i ] * sizeof( struct Session ) );
+        if ( !pSessions )
+        {
+            printf( "\t%10llu ***ERROR*** Not enough memory\n", counts[ i ] );
+            continue;
+        }
+
+        SplpScaleWarm( pSessions, (unsigned int) counts[ i ] );
+        SplpScaleRun( pSessions, (unsigned int) counts[ i ], SPLP_SCALE_WARMUP, 0x5851f42d4c957f2dull, &warmupInvalid );
+
+        SplpPerfStart( &perf );
+        ticks = SplpScaleRun( pSessions, (unsigned int) counts[ i ], messageCount, 0x2545f4914f6cdd1dull, &invalid );
+        SplpPerfStop( &perf );
+        invalid += warmupInvalid;
+
+        printf( "\t%10llu %12llu %10.2f",
+            counts[ i ],
+            counts[ i ] * sizeof( struct Session ),
+            ticks * 1e9 / ticksPerSecond / messageCount );
+
+        for ( c = 0; c < SPLP_PERF_COUNTER_COUNT; c++ )
+        {
+            if ( SplpPerfAvailable( &perf, (SPLP_PERF_COUNTER) c ) )
+                printf( " %12.3f", (double) perf.value[ c ] / messageCount );
+            else
+                printf( " %12s", "n/a" );
+        }
+        printf( "%s\n", invalid ? " (rejects)" : "" );
+
+        free( pSessions );
+    }
+
+    printf( "======================================================================\n" );
+    SplpPerfClose( &perf );
+    return SPLP_STATUS_OK;
+}
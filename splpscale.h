@@ -0,0 +1,35 @@
+/*
+* SPLPSCALE.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the session-count scaling
+* benchmark.
+*/
+#ifndef SPLPSCALE_H
+#define SPLPSCALE_H
+
+#include "splptest.h"
+
+
+
+#define DEFAULT_SCALE_SESSIONS    "1,1000,1000000,10000000,100000000"
+#define SPLP_SCALE_MESSAGES       ( 1u << 23 )    /* messages per point */
+#define SPLP_SCALE_WARMUP         ( 1u << 20 )    /* untimed messages per point before them */
+#define SPLP_SCALE_MAX_POINTS     16
+#define SPLP_SCALE_VARIANTS       4       /* messages per state, power of 2 */
+
+
+
+
+/* SplpScaleScript
+* The next valid message for every state. CONNECTED picks one of four
+* requests, all other states have a single answer.
+*/
+extern const struct Message SplpScaleScript[ DISCONNECTING + 1 ][ SPLP_SCALE_VARIANTS ];
+
+
+
+
+SPLP_STATUS SplpScaleBenchmark(
+    PSPLP_TEST_OPTIONS pOptions );
+
+#endif /* SPLPSCALE_H */
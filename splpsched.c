@@ -0,0 +1,118 @@
+/*
+* SPLPSCHED.c
+* The file is part of practical task for System programming course.
+* This file contains the message scheduler. It is single threaded, the
+* worker which owns the sessions submits messages and runs the
+* scheduler in turns.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "splpv1.h"
+#include "splpsched.h"
+
+
+
+static SPLP_STATUS SplpSchedLaneInit(
+    PSPLP_SCHED_LANE pLane,
+    unsigned int capacity )
+{
+    unsigned int size = 16;
+
+    while ( size < capacity && size < 0x80000000u )
+        size *= 2;
+    pLane->ppJobs = (PSPLP_SCHED_JOB*) malloc( size * sizeof( PSPLP_SCHED_JOB ) );
+    pLane->head = 0;
+    pLane->tail = 0;
+    pLane->mask = size - 1;
+    return pLane->ppJobs ? SPLP_STATUS_OK : SPLP_STATUS_ERROR;
+}
+
+
+
+
+SPLP_STATUS SplpSchedInit(
+    PSPLP_SCHED pSched,
+    unsigned int sessionCount,
+    unsigned int capacity,
+    unsigned int priority,
+    size_t sliceBytes )
+{
+    memset( pSched, 0, sizeof( *pSched ) );
+    pSched->priority = priority;
+    pSched->sliceBytes = priority ? sliceBytes : (size_t) -1;
+    pSched->pSessions = (struct Session*) calloc( sessionCount, sizeof( struct Session ) );
+    pSched->pBulkQueued = (unsigned int*) calloc( sessionCount, sizeof( unsigned int ) );
+    if ( !pSched->pSessions || !pSched->pBulkQueued ||
+        SPLP_STATUS_OK != SplpSchedLaneInit( &pSched->control, capacity ) ||
+        SPLP_STATUS_OK != SplpSchedLaneInit( &pSched->bulk, capacity ) )
+    {
+        SplpSchedFree( pSched );
+        return SPLP_STATUS_ERROR;
+    }
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+void SplpSchedFree(
+    PSPLP_SCHED pSched )
+{
+    free( pSched->pSessions );
+    free( pSched->pBulkQueued );
+    free( pSched->control.ppJobs );
+    free( pSched->bulk.ppJobs );
+    memset( pSched, 0, sizeof( *pSched ) );
+}
+
+
+
+
+SPLP_STATUS SplpSchedSubmit(
+    PSPLP_SCHED pSched,
+    PSPLP_SCHED_JOB pJob )
+{
+    PSPLP_SCHED_LANE pLane = &pSched->bulk;
+
+    if ( pSched->priority && pJob->length <= SPLP_SCHED_CONTROL_BYTES && pSched->pBulkQueued[ pJob->session ] == 0 )
+        pLane = &pSched->control;
+
+    if ( pLane->tail - pLane->head > pLane->mask )
+        return SPLP_STATUS_ERROR;
+
+    if ( pLane == &pSched->bulk )
+        pSched->pBulkQueued[ pJob->session ]++;
+    pJob->scan.position = 0;
+    pLane->ppJobs[ pLane->tail++ & pLane->mask ] = pJob;
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+PSPLP_SCHED_JOB SplpSchedRun(
+    PSPLP_SCHED pSched )
+{
+    PSPLP_SCHED_JOB pJob;
+    int done;
+
+    if ( pSched->control.head != pSched->control.tail )
+    {
+        pJob = pSched->control.ppJobs[ pSched->control.head++ & pSched->control.mask ];
+        pJob->result = validate_session_message( &pSched->pSessions[ pJob->session ], &pJob->msg );
+        return pJob;
+    }
+
+    if ( pSched->bulk.head == pSched->bulk.tail )
+        return NULL;
+
+    pJob = pSched->bulk.ppJobs[ pSched->bulk.head & pSched->bulk.mask ];
+    pJob->result = validate_session_slice( &pSched->pSessions[ pJob->session ], &pJob->msg,
+        &pJob->scan, pSched->sliceBytes, &done );
+    if ( !done )
+        return NULL;
+
+    pSched->bulk.head++;
+    pSched->pBulkQueued[ pJob->session ]--;
+    return pJob;
+}
@@ -0,0 +1,123 @@
+/*
+* SPLPSCHED.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the message scheduler of a worker
+* which validates the messages of many sessions.
+*/
+#ifndef SPLPSCHED_H
+#define SPLPSCHED_H
+
+#include "splptest.h"
+
+
+
+#define SPLP_SCHED_CONTROL_BYTES  64      /* longer messages are bulk */
+#define DEFAULT_SCHED_SLICE_BYTES 16384   /* payload bytes per bulk time slice */
+
+
+
+
+/* SPLP_SCHED_JOB
+* A message of session index session, with the progress of its scan.
+*/
+typedef struct _SPLP_SCHED_JOB
+{
+    struct Message     msg;
+    struct Scan        scan;
+    unsigned int       session;
+    unsigned int       length;
+    unsigned long long arrival;
+    unsigned long long completion;
+    enum test_status   result;
+
+}SPLP_SCHED_JOB, *PSPLP_SCHED_JOB;
+
+
+
+
+/* SPLP_SCHED_LANE
+* FIFO of jobs, power of 2 capacity.
+*/
+typedef struct _SPLP_SCHED_LANE
+{
+    PSPLP_SCHED_JOB*   ppJobs;
+    unsigned int       head;
+    unsigned int       tail;
+    unsigned int       mask;
+
+}SPLP_SCHED_LANE, *PSPLP_SCHED_LANE;
+
+
+
+
+/* SPLP_SCHED
+* With priority set, messages up to SPLP_SCHED_CONTROL_BYTES go to the
+* control lane and run before anything else; longer ones are validated
+* in slices of sliceBytes from the bulk lane, so a control message
+* waits one slice at most. A message of a session which has a bulk
+* message queued follows it in the bulk lane, messages of a session are
+* never reordered. Without priority every message runs to completion
+* from one lane, in arrival order.
+*/
+typedef struct _SPLP_SCHED
+{
+    struct Session*    pSessions;
+    unsigned int*      pBulkQueued;    /* bulk lane messages per session */
+    SPLP_SCHED_LANE    control;
+    SPLP_SCHED_LANE    bulk;
+    unsigned int       priority;
+    size_t             sliceBytes;
+
+}SPLP_SCHED, *PSPLP_SCHED;
+
+
+
+
+/* SplpSchedInit
+* Sessions start as { INIT, REASON_NONE }. capacity is the number of
+* jobs each lane holds.
+*/
+SPLP_STATUS SplpSchedInit(
+    PSPLP_SCHED pSched,
+    unsigned int sessionCount,
+    unsigned int capacity,
+    unsigned int priority,
+    size_t sliceBytes );
+
+
+
+
+void SplpSchedFree(
+    PSPLP_SCHED pSched );
+
+
+
+
+/* SplpSchedSubmit
+* Queues a job. Returns SPLP_STATUS_ERROR if its lane is full.
+*/
+SPLP_STATUS SplpSchedSubmit(
+    PSPLP_SCHED pSched,
+    PSPLP_SCHED_JOB pJob );
+
+
+
+
+/* SplpSchedRun
+* Runs the next control message, or the next slice of the bulk message
+* at the head of its lane. Returns the job if it is complete, with its
+* result set, NULL otherwise or if nothing is queued.
+*/
+PSPLP_SCHED_JOB SplpSchedRun(
+    PSPLP_SCHED pSched );
+
+
+
+
+static __inline int SplpSchedIdle(
+    PSPLP_SCHED pSched )
+{
+    return pSched->control.head == pSched->control.tail && pSched->bulk.head == pSched->bulk.tail;
+}
+
+#endif /* SPLPSCHED_H */
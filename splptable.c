@@ -0,0 +1,260 @@
+/*
+* SPLPTABLE.c
+* The file is part of practical task for System programming course.
+* This file contains the concurrent session tables.
+*
+* In SPLP_TABLE a transition is validate_session_message( ) applied to
+* a copy of the session word, committed only if the word still holds
+* the copy. A session whose state and reason don't change is not
+* written at all, so lookups of a known id and repeated rejects in
+* CONNECTED leave its cache line shared between cores.
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "splpv1.h"
+#include "splptable.h"
+
+
+
+#define SPLP_TABLE_HASH( id )     ( ( id ) * 2654435761u )
+#define SPLP_TABLE_SHARD_STRIDE   ( ( sizeof( SPLP_SHARD ) + SPLP_TABLE_CACHE_LINE - 1 ) & ~(size_t) ( SPLP_TABLE_CACHE_LINE - 1 ) )
+#define SPLP_TABLE_SHARD( pTable, i ) \
+    ( (PSPLP_SHARD) ( ( pTable )->pShards + (size_t) ( i ) * SPLP_TABLE_SHARD_STRIDE ) )
+
+
+
+
+static unsigned int SplpTableCapacity(
+    unsigned int sessions )
+{
+    unsigned int capacity = 16;
+
+    /* at most half full, so probe sequences stay short */
+    while ( capacity < 2 * sessions && capacity < 0x80000000u )
+        capacity *= 2;
+    return capacity;
+}
+
+
+
+
+SPLP_STATUS SplpTableInit(
+    PSPLP_TABLE pTable,
+    unsigned int sessions )
+{
+    unsigned int capacity = SplpTableCapacity( sessions );
+
+    pTable->pSlots = (PSPLP_TABLE_SLOT) calloc( capacity, sizeof( SPLP_TABLE_SLOT ) );
+    pTable->mask = capacity - 1;
+    return pTable->pSlots ? SPLP_STATUS_OK : SPLP_STATUS_ERROR;
+}
+
+
+
+
+void SplpTableFree(
+    PSPLP_TABLE pTable )
+{
+    free( pTable->pSlots );
+    pTable->pSlots = NULL;
+}
+
+
+
+
+PSPLP_TABLE_SLOT SplpTableLookup(
+    PSPLP_TABLE pTable,
+    unsigned int id )
+{
+    unsigned int key = id + 1;
+    unsigned int index = SPLP_TABLE_HASH( id ) & pTable->mask;
+    unsigned int probes;
+
+    if ( id > SPLP_TABLE_MAX_ID )
+        return NULL;
+
+    for ( probes = 0; probes <= pTable->mask; probes++ )
+    {
+        PSPLP_TABLE_SLOT pSlot = &pTable->pSlots[ index ];
+        unsigned int current = SplpLoadAcquire( &pSlot->key );
+
+        if ( current == SPLP_TABLE_EMPTY )
+        {
+            /* a thread which loses the race for the slot may have lost it
+             * to the same id */
+            if ( SplpCompareExchange( &pSlot->key, SPLP_TABLE_EMPTY, key ) )
+                return pSlot;
+            current = SplpLoadAcquire( &pSlot->key );
+        }
+        if ( current == key )
+            return pSlot;
+
+        index = ( index + 1 ) & pTable->mask;
+    }
+    return NULL;
+}
+
+
+
+
+enum test_status SplpTableValidate(
+    PSPLP_TABLE_SLOT pSlot,
+    struct Message* pMsg,
+    unsigned int* pRetries )
+{
+    unsigned int snapshot = SplpLoadAcquire( &pSlot->word );
+
+    for ( ;; )
+    {
+        struct Session session;
+        enum test_status result;
+        unsigned int desired;
+
+        session.state = (unsigned char) ( snapshot & 0xff );
+        session.reason = (unsigned char) ( snapshot >> 8 );
+        result = validate_session_message( &session, pMsg );
+        desired = session.state | (unsigned int) session.reason << 8;
+
+        if ( desired == snapshot || SplpCompareExchange( &pSlot->word, snapshot, desired ) )
+            return result;
+
+        ( *pRetries )++;
+        snapshot = SplpLoadAcquire( &pSlot->word );
+    }
+}
+
+
+
+
+SPLP_STATUS SplpShardedInit(
+    PSPLP_SHARDED_TABLE pTable,
+    unsigned int shardCount,
+    unsigned int sessions )
+{
+    unsigned int capacity = SplpTableCapacity( ( sessions + shardCount - 1 ) / shardCount );
+    unsigned int i;
+
+    memset( pTable, 0, sizeof( *pTable ) );
+    /* one line more than needed, to round pShards up to a line boundary */
+    pTable->pMemory = calloc( shardCount + 1, SPLP_TABLE_SHARD_STRIDE );
+    if ( !pTable->pMemory )
+        return SPLP_STATUS_ERROR;
+    pTable->pShards = (unsigned char*) pTable->pMemory +
+        ( ( SPLP_TABLE_CACHE_LINE - (uintptr_t) pTable->pMemory % SPLP_TABLE_CACHE_LINE ) % SPLP_TABLE_CACHE_LINE );
+    pTable->shardCount = shardCount;
+    pTable->mask = capacity - 1;
+
+    for ( i = 0; i < shardCount; i++ )
+    {
+        PSPLP_SHARD pShard = SPLP_TABLE_SHARD( pTable, i );
+
+        SplpMutexInit( &pShard->lock );
+        pShard->pKeys = (unsigned int*) calloc( capacity, sizeof( unsigned int ) );
+        pShard->pSessions = (struct Session*) calloc( capacity, sizeof( struct Session ) );
+        if ( !pShard->pKeys || !pShard->pSessions )
+            return SPLP_STATUS_ERROR;
+    }
+    return SPLP_STATUS_OK;
+}
+
+
+
+
+void SplpShardedFree(
+    PSPLP_SHARDED_TABLE pTable )
+{
+    unsigned int i;
+
+    for ( i = 0; pTable->pShards && i < pTable->shardCount; i++ )
+    {
+        PSPLP_SHARD pShard = SPLP_TABLE_SHARD( pTable, i );
+
+        SplpMutexDestroy( &pShard->lock );
+        free( pShard->pKeys );
+        free( pShard->pSessions );
+    }
+    free( pTable->pMemory );
+    memset( pTable, 0, sizeof( *pTable ) );
+}
+
+
+
+
+/* SplpShardedFind
+* Index of session id in its shard, adding it if add is set. Returns
+* mask + 1 if it is not there, or the shard is full. Called under the
+* lock of the shard.
+*/
+static unsigned int SplpShardedFind(
+    PSPLP_SHARDED_TABLE pTable,
+    PSPLP_SHARD pShard,
+    unsigned int id,
+    int add )
+{
+    unsigned int key = id + 1;
+    unsigned int index = SPLP_TABLE_HASH( id / pTable->shardCount ) & pTable->mask;
+    unsigned int probes;
+
+    for ( probes = 0; probes <= pTable->mask; probes++ )
+    {
+        if ( pShard->pKeys[ index ] == key )
+            return index;
+        if ( pShard->pKeys[ index ] == SPLP_TABLE_EMPTY )
+        {
+            if ( !add )
+                break;
+            pShard->pKeys[ index ] = key;
+            pShard->pSessions[ index ].state = INIT;
+            pShard->pSessions[ index ].reason = REASON_NONE;
+            return index;
+        }
+        index = ( index + 1 ) & pTable->mask;
+    }
+    return pTable->mask + 1;
+}
+
+
+
+
+enum test_status SplpShardedValidate(
+    PSPLP_SHARDED_TABLE pTable,
+    unsigned int id,
+    struct Message* pMsg )
+{
+    PSPLP_SHARD pShard = SPLP_TABLE_SHARD( pTable, id % pTable->shardCount );
+    enum test_status result = MESSAGE_INVALID;
+    unsigned int index;
+
+    if ( id > SPLP_TABLE_MAX_ID )
+        return MESSAGE_INVALID;
+
+    SplpMutexLock( &pShard->lock );
+    index = SplpShardedFind( pTable, pShard, id, 1 );
+    if ( index <= pTable->mask )
+        result = validate_session_message( &pShard->pSessions[ index ], pMsg );
+    SplpMutexUnlock( &pShard->lock );
+    return result;
+}
+
+
+
+
+enum State SplpShardedState(
+    PSPLP_SHARDED_TABLE pTable,
+    unsigned int id )
+{
+    PSPLP_SHARD pShard = SPLP_TABLE_SHARD( pTable, id % pTable->shardCount );
+    enum State state = INIT;
+    unsigned int index;
+
+    if ( id > SPLP_TABLE_MAX_ID )
+        return INIT;
+
+    SplpMutexLock( &pShard->lock );
+    index = SplpShardedFind( pTable, pShard, id, 0 );
+    if ( index <= pTable->mask )
+        state = (enum State) pShard->pSessions[ index ].state;
+    SplpMutexUnlock( &pShard->lock );
+    return state;
+}
@@ -0,0 +1,177 @@
+/*
+* SPLPTABLE.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the concurrent session tables.
+* Both map a session id to its struct Session and validate messages of
+* any session from any thread:
+*   - SPLP_TABLE keeps a session in one word updated by compare and
+*     swap. Only the first lookup of an id writes, to claim its slot,
+*     later lookups and validations which leave the session unchanged
+*     only read.
+*   - SPLP_SHARDED_TABLE splits sessions over shards, each behind its
+*     own lock.
+*/
+#ifndef SPLPTABLE_H
+#define SPLPTABLE_H
+
+#include "splptest.h"
+#include "splpthread.h"
+
+
+
+#define SPLP_TABLE_CACHE_LINE     64
+#define SPLP_TABLE_EMPTY          0       /* key of a free slot, keys are id + 1 */
+#define SPLP_TABLE_MAX_ID         0xfffffffeu /* id + 1 must not wrap to SPLP_TABLE_EMPTY */
+
+
+
+
+/* SPLP_TABLE_SLOT
+* word holds state | reason << 8 of the session. key is set once, when
+* the slot is claimed, and never changes afterwards.
+*/
+typedef struct _SPLP_TABLE_SLOT
+{
+    volatile unsigned int key;
+    volatile unsigned int word;
+
+}SPLP_TABLE_SLOT, *PSPLP_TABLE_SLOT;
+
+
+
+
+/* SPLP_TABLE
+* Open addressing with linear probing, power of 2 capacity. Slots are
+* never freed, a closed session is a session in INIT.
+*/
+typedef struct _SPLP_TABLE
+{
+    PSPLP_TABLE_SLOT   pSlots;
+    unsigned int       mask;
+
+}SPLP_TABLE, *PSPLP_TABLE;
+
+
+
+
+/* SPLP_SHARD
+* One lock and the open addressing table of its sessions. Shards start
+* on their own cache lines, see SPLP_SHARDED_TABLE, so locks of
+* neighbouring shards don't share a line.
+*/
+typedef struct _SPLP_SHARD
+{
+    SPLP_MUTEX         lock;
+    unsigned int*      pKeys;
+    struct Session*    pSessions;
+
+}SPLP_SHARD, *PSPLP_SHARD;
+
+
+
+
+/* SPLP_SHARDED_TABLE
+* Shards are SPLP_TABLE_SHARD_STRIDE bytes apart in pShards, which is
+* rounded up to a cache line boundary inside pMemory.
+*/
+typedef struct _SPLP_SHARDED_TABLE
+{
+    void*              pMemory;
+    unsigned char*     pShards;
+    unsigned int       shardCount;
+    unsigned int       mask;           /* of the sessions of a shard */
+
+}SPLP_SHARDED_TABLE, *PSPLP_SHARDED_TABLE;
+
+
+
+
+/* SplpTableInit
+* Sizes the table for sessions sessions at most.
+*/
+SPLP_STATUS SplpTableInit(
+    PSPLP_TABLE pTable,
+    unsigned int sessions );
+
+
+
+
+void SplpTableFree(
+    PSPLP_TABLE pTable );
+
+
+
+
+/* SplpTableLookup
+* Returns the slot of session id, claiming a free one for a new id.
+* NULL if the table is full or id is above SPLP_TABLE_MAX_ID.
+*/
+PSPLP_TABLE_SLOT SplpTableLookup(
+    PSPLP_TABLE pTable,
+    unsigned int id );
+
+
+
+
+/* SplpTableValidate
+* Validates msg against a snapshot of the session and commits the new
+* state with compare and swap, again from a fresh snapshot if another
+* thread changed the session in between. pRetries is incremented per
+* repeated validation.
+*/
+enum test_status SplpTableValidate(
+    PSPLP_TABLE_SLOT pSlot,
+    struct Message* pMsg,
+    unsigned int* pRetries );
+
+
+
+
+/* SplpTableState
+* State of the session in a slot, e.g. to choose its next message.
+*/
+static __inline enum State SplpTableState(
+    PSPLP_TABLE_SLOT pSlot )
+{
+    return (enum State) ( SplpLoadAcquire( &pSlot->word ) & 0xff );
+}
+
+
+
+
+SPLP_STATUS SplpShardedInit(
+    PSPLP_SHARDED_TABLE pTable,
+    unsigned int shardCount,
+    unsigned int sessions );
+
+
+
+
+void SplpShardedFree(
+    PSPLP_SHARDED_TABLE pTable );
+
+
+
+
+/* SplpShardedValidate
+* Looks up or adds session id and validates msg in it, all under the
+* lock of the shard of id. Returns MESSAGE_INVALID without a verdict if
+* the shard is full or id is above SPLP_TABLE_MAX_ID.
+*/
+enum test_status SplpShardedValidate(
+    PSPLP_SHARDED_TABLE pTable,
+    unsigned int id,
+    struct Message* pMsg );
+
+
+
+
+/* SplpShardedState
+* State of session id, INIT for an unknown one. It is read under the
+* lock of the shard, but may be stale by the time the caller acts on it.
+*/
+enum State SplpShardedState(
+    PSPLP_SHARDED_TABLE pTable,
+    unsigned int id );
+
+#endif /* SPLPTABLE_H */
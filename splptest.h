@@ -0,0 +1,171 @@
+/*
+* SPLPTEST.h
+* The file is part of practical task for System programming course.
+* This file contains declarations shared by the test program modules.
+*/
+#ifndef SPLPTEST_H
+#define SPLPTEST_H
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#elif defined( __i386__ ) || defined( __x86_64__ )
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+#include "splpv1.h"
+
+
+
+#define SPLP_INVALID_MSG_INDEX    0xffffffff
+
+
+
+
+typedef enum _SPLP_STATUS
+{
+    SPLP_STATUS_OK,
+    SPLP_STATUS_ERROR
+} SPLP_STATUS;
+
+
+
+
+/* SPLP_TEST_MESSAGE
+* This is a utility data structure which holds a message to evaluate
+* by validate_message() and the answer which is expected to be.
+* if the result returned by validate_message() for msg member is NOT
+* the same as  expectedTestStatus,  the function is implemented with
+* mistakes.
+*/
+typedef struct _SPLP_TEST_MESSAGE
+{
+    enum test_status  expectedTestStatus;  /* Correct answer */
+    struct Message    msg;                 /* Message */
+    unsigned int      length;              /* strlen( msg.text_message ) */
+
+}SPLP_TEST_MESSAGE, *PSPLP_TEST_MESSAGE;
+
+
+
+
+/* SPLP_FORMAT
+* How test results are printed.
+*/
+typedef enum _SPLP_FORMAT
+{
+    SPLP_FORMAT_TEXT,
+    SPLP_FORMAT_JSON,
+    SPLP_FORMAT_CSV
+} SPLP_FORMAT;
+
+
+
+
+/* SPLP_TEST_OPTIONS
+* This structure contains configuration for a test
+*/
+typedef struct _SPLP_TEST_OPTIONS
+{
+    const char*  testFileName;  /* path to the file with test messages */
+    unsigned int cycleCount;    /* how many times should the file be evaluated */
+    const char*  logFileName;   /* verdict log to write, NULL if disabled */
+    unsigned int logSampleRate; /* log every logSampleRate-th verdict */
+    const char*  scanFileName;  /* verdict log to aggregate instead of testing */
+    const char*  capturePrefix; /* ring files for rejected messages, NULL if disabled */
+    unsigned int captureFiles;  /* number of ring files */
+    unsigned int captureSlots;  /* messages per ring file */
+    unsigned int captureSampleRate; /* capture every n-th reject */
+    unsigned int captureRate;   /* captures per second at most */
+    const char*  exportFileName; /* ring file to convert into a test file */
+    unsigned long long watchdogThreshold; /* TSC ticks, 0 if the watchdog is off */
+    unsigned int overloadPolicies; /* policies to benchmark under overload, bit mask */
+    unsigned int overloadLoad;  /* offered load, % of capacity */
+    unsigned int overloadHigh;  /* queue depth entering overload */
+    unsigned int overloadLow;   /* queue depth leaving overload */
+    unsigned int benchmark;     /* run the micro benchmarks instead of the test */
+    const char*  benchFilter;   /* run benchmarks with this in the name only */
+    const char*  benchJsonFileName; /* benchmark results to write, NULL if disabled */
+    const char*  benchBaselineFileName; /* results of baseline runs, comma separated, NULL if disabled */
+    const char*  benchCurrentFileName; /* results of current runs to compare with them */
+    unsigned int benchThreshold; /* % a median may grow by before it fails the gate */
+    unsigned int openLoop;      /* run the open-loop load sweep instead of the test */
+    const char*  openLoopLoads; /* comma separated loads, % of capacity */
+    unsigned int openLoopArrival; /* SPLP_ARRIVAL */
+    const char*  openLoopTrace; /* verdict log with the arrival pattern */
+    unsigned int openLoopSlo;   /* latency SLO of adaptive batches in usec, 0 for none */
+    unsigned int scale;         /* run the session scaling benchmark instead of the test */
+    const char*  scaleSessions; /* comma separated session counts */
+    unsigned int outputFormat;  /* SPLP_FORMAT of the test results */
+    unsigned int allocCheck;    /* fail if timed loops call the allocator */
+    unsigned int engineMix;     /* compare the engines on traffic mixes instead of the test */
+    const char*  mixInvalid;    /* comma separated % of corrupted messages */
+    unsigned int adversarial;   /* run the adversarial benchmark instead of the test */
+    unsigned int adversarialBound; /* TSC cycles per byte a message may cost */
+    unsigned int concurrent;    /* benchmark the concurrent session tables instead of the test */
+    const char*  concurrentThreads; /* comma separated thread counts */
+    unsigned int concurrentSessions; /* sessions shared by the threads */
+    unsigned int processes;     /* validator processes the cycles are split over, 0 for none */
+    unsigned int processWorker; /* set in a process started by the launcher */
+    unsigned int processIndex;  /* of this process, 0..processes-1 */
+    unsigned int processLauncher; /* pid of the launcher */
+    unsigned int priority;      /* benchmark the priority scheduling instead of the test */
+    unsigned int prioritySlice; /* bulk payload bytes per time slice */
+    unsigned int noDedup;       /* keep a heap copy of every message text */
+    unsigned int corpusThreads; /* decompression threads of the test file, 0 for one per processor */
+    unsigned int migrateWorkers; /* benchmark session migration between this many workers, 0 for none */
+    unsigned int embed;         /* benchmark the inline validator in a receive loop instead of the test */
+
+}SPLP_TEST_OPTIONS, *PSPLP_TEST_OPTIONS;
+
+
+
+
+/* SPLP_TEST_ENTRY
+* A test message as an index into the message dictionary, see
+* splpdict.h.
+*/
+#define SPLP_TEST_ENTRY_MAX_INDEX ( ( 1u << 30 ) - 1 )
+
+typedef struct _SPLP_TEST_ENTRY
+{
+    unsigned int      index : 30;          /* of the text in the dictionary */
+    unsigned int      direction : 1;       /* 1 for B_TO_A */
+    unsigned int      valid : 1;           /* expected MESSAGE_VALID */
+
+}SPLP_TEST_ENTRY, *PSPLP_TEST_ENTRY;
+
+
+
+
+/* SPLP_TEST_DATA
+* This structure contains data for a test
+*/
+typedef struct _SPLP_TEST_DATA
+{
+    PSPLP_TEST_MESSAGE   MessageArray; /* test messages to evaluate */
+    unsigned int         size;         /* amount of messages in MessageArray */
+    unsigned int         dataSize;     /* total size of test data, in bytes  */
+    struct _SPLP_DICTIONARY* pDictionary; /* distinct texts, NULL unless deduplicated */
+    PSPLP_TEST_ENTRY     pEntries;     /* the messages as dictionary entries */
+
+}SPLP_TEST_DATA, *PSPLP_TEST_DATA;
+
+
+
+
+/* SplpReadTsc
+* Returns the CPU time stamp counter. It is used where clock( ) is too
+* coarse, e.g. to timestamp a single message. On targets without TSC
+* it falls back to clock( ) ticks.
+*/
+static __inline unsigned long long SplpReadTsc( void )
+{
+#if defined( _MSC_VER ) || defined( __i386__ ) || defined( __x86_64__ )
+    return __rdtsc( );
+#else
+    return (unsigned long long) clock( );
+#endif
+}
+
+#endif /* SPLPTEST_H */
@@ -0,0 +1,242 @@
+/*
+* SPLPTHREAD.h
+* The file is part of practical task for System programming course.
+* This file contains the thread and atomic primitives used by the test
+* program modules, for Windows and POSIX.
+*/
+#ifndef SPLPTHREAD_H
+#define SPLPTHREAD_H
+
+#if defined( _WIN32 )
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#if defined( __i386__ ) || defined( __x86_64__ )
+#include <x86intrin.h>
+#endif
+#endif
+
+
+
+#if defined( _WIN32 )
+typedef HANDLE SPLP_THREAD;
+#define SPLP_THREAD_ROUTINE( name, arg )    DWORD WINAPI name( LPVOID arg )
+#define SPLP_THREAD_RETURN                  return 0
+#else
+typedef pthread_t SPLP_THREAD;
+#define SPLP_THREAD_ROUTINE( name, arg )    void* name( void* arg )
+#define SPLP_THREAD_RETURN                  return NULL
+#endif
+
+
+
+
+/* SplpThreadCreate
+* Starts routine( arg ) on a new thread. Returns 0 on success.
+*/
+#if defined( _WIN32 )
+static __inline int SplpThreadCreate(
+    SPLP_THREAD* pThread,
+    LPTHREAD_START_ROUTINE routine,
+    void* arg )
+{
+    *pThread = CreateThread( NULL, 0, routine, arg, 0, NULL );
+    return *pThread ? 0 : -1;
+}
+#else
+static __inline int SplpThreadCreate(
+    SPLP_THREAD* pThread,
+    void* ( *routine )( void* ),
+    void* arg )
+{
+    return pthread_create( pThread, NULL, routine, arg );
+}
+#endif
+
+
+
+
+static __inline void SplpThreadJoin(
+    SPLP_THREAD thread )
+{
+#if defined( _WIN32 )
+    WaitForSingleObject( thread, INFINITE );
+    CloseHandle( thread );
+#else
+    pthread_join( thread, NULL );
+#endif
+}
+
+
+
+
+/* SplpCpuCount
+* Number of online processors, at least 1.
+*/
+static __inline unsigned int SplpCpuCount( void )
+{
+#if defined( _WIN32 )
+    SYSTEM_INFO info;
+    GetSystemInfo( &info );
+    return info.dwNumberOfProcessors ? info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf( _SC_NPROCESSORS_ONLN );
+    return count > 0 ? (unsigned int) count : 1;
+#endif
+}
+
+
+
+
+/* SplpCpuRelax
+* Hint for spin-wait loops.
+*/
+static __inline void SplpCpuRelax( void )
+{
+#if defined( _WIN32 )
+    YieldProcessor( );
+#elif defined( __i386__ ) || defined( __x86_64__ )
+    _mm_pause( );
+#else
+    sched_yield( );
+#endif
+}
+
+
+
+
+/* SplpThreadYield
+* Gives the processor to another ready thread. Waits which may last
+* longer than a few hundred cycles use it, so the open-loop generator
+* and its consumer still make progress when they share one core.
+*/
+static __inline void SplpThreadYield( void )
+{
+#if defined( _WIN32 )
+    SwitchToThread( );
+#else
+    sched_yield( );
+#endif
+}
+
+
+
+
+/* Acquire loads and release stores. MSVC gives volatile accesses these
+* semantics on x86 and x64, so only the compiler has to be fenced.
+*/
+static __inline unsigned int SplpLoadAcquire(
+    volatile unsigned int* p )
+{
+#if defined( _MSC_VER )
+    unsigned int value = *p;
+    _ReadWriteBarrier( );
+    return value;
+#else
+    return __atomic_load_n( p, __ATOMIC_ACQUIRE );
+#endif
+}
+
+
+
+
+static __inline void SplpStoreRelease(
+    volatile unsigned int* p,
+    unsigned int value )
+{
+#if defined( _MSC_VER )
+    _ReadWriteBarrier( );
+    *p = value;
+#else
+    __atomic_store_n( p, value, __ATOMIC_RELEASE );
+#endif
+}
+
+
+
+
+
+/* SplpCompareExchange
+* Stores desired if *p still holds expected, as one atomic step which
+* is a full barrier. Returns nonzero if it stored.
+*/
+static __inline int SplpCompareExchange(
+    volatile unsigned int* p,
+    unsigned int expected,
+    unsigned int desired )
+{
+#if defined( _MSC_VER )
+    return (unsigned int) _InterlockedCompareExchange( (volatile long*) p, (long) desired, (long) expected ) == expected;
+#else
+    return __atomic_compare_exchange_n( p, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE );
+#endif
+}
+
+
+
+
+/* SPLP_MUTEX
+* A lock for short critical sections.
+*/
+#if defined( _WIN32 )
+typedef SRWLOCK SPLP_MUTEX;
+#else
+typedef pthread_mutex_t SPLP_MUTEX;
+#endif
+
+
+
+
+static __inline void SplpMutexInit(
+    SPLP_MUTEX* pMutex )
+{
+#if defined( _WIN32 )
+    InitializeSRWLock( pMutex );
+#else
+    pthread_mutex_init( pMutex, NULL );
+#endif
+}
+
+
+
+
+static __inline void SplpMutexLock(
+    SPLP_MUTEX* pMutex )
+{
+#if defined( _WIN32 )
+    AcquireSRWLockExclusive( pMutex );
+#else
+    pthread_mutex_lock( pMutex );
+#endif
+}
+
+
+
+
+static __inline void SplpMutexUnlock(
+    SPLP_MUTEX* pMutex )
+{
+#if defined( _WIN32 )
+    ReleaseSRWLockExclusive( pMutex );
+#else
+    pthread_mutex_unlock( pMutex );
+#endif
+}
+
+
+
+
+static __inline void SplpMutexDestroy(
+    SPLP_MUTEX* pMutex )
+{
+#if defined( _WIN32 )
+    ( void ) pMutex;
+#else
+    pthread_mutex_destroy( pMutex );
+#endif
+}
+
+#endif /* SPLPTHREAD_H */
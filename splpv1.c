@@ -52,12 +52,16 @@
  */
 
 
+#define SPLP_LIBRARY
+
 #include "splpv1.h"
+#include "splpinline.h"
 #include <string.h>
 #include "stdbool.h"
 
 
 
+
  /* FUNCTION:  validate_message
   *
   * PURPOSE:
@@ -74,326 +78,278 @@
   *    state
   */
 
-enum State {
-	INIT, CONNECTING, CONNECTED, WAITING_VER, WAITING_DATA, WAITING_B64_DATA, DISCONNECTING
+static struct Session session = { INIT, REASON_NONE };
+
+// class bits of every byte, see SPLPclass.h:
+// 0x01 data, 0x02 base64, 0x04 base64 or '=', 0x08 digit, 0x10 space
+const unsigned char splp_char_class[256] =
+{
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x00
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x10
+	0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x01, 0x06,	// 0x20
+	0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00,	// 0x30
+	0x00, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06,	// 0x40
+	0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x50
+	0x00, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07,	// 0x60
+	0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x70
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x80
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x90
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xa0
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xb0
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xc0
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xd0
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xe0
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xf0
 };
 
-static enum State state = INIT;
-
-const char* CONNECT = "CONNECT";
-const char* CONNECT_OK = "CONNECT_OK";
-const char* GET_VER = "GET_VER";
-const char* GET_DATA = "GET_DATA";
-const char* GET_FILE = "GET_FILE";
-const char* GET_COMMAND = "GET_COMMAND";
-const char* GET_B64 = "GET_B64";
-const char* DISCONNECT = "DISCONNECT";
-const char* VERSION = "VERSION";
-const char* B64 = "B64:";
-const char* DISCONNECT_OK = "DISCONNECT_OK";
-
-bool table[128] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-				   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
-				   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
-				   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
-				   0, 0, 0, 0, 0, 0, 1, 0, 1, 1, 
-				   1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 
-				   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
-				   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
-				   0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-				   0, 0, 0, 0, 0, 0, 0, 1, 1, 1,
-				   1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 
-				   1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-				   1, 1, 1, 0, 0, 0, 0, 0 };
-
-bool tableBase64[128] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-						  0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-						  0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-						  0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-						  0, 0, 0, 1, 0, 0, 0, 1, 1, 1,
-						  1, 1, 1, 1, 1, 1, 1, 1, 0, 0,
-						  0, 0, 0, 0, 0, 1, 1, 1, 1, 1,
-						  1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-						  1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-						  1, 0, 0, 0, 0, 0, 0, 1, 1, 1,
-						  1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-						  1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-						  1, 1, 1, 0, 0, 0, 0, 0 };
-
-bool tableBase64WithEquals[128] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-									0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-									0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-									0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-									0, 0, 0, 1, 0, 0, 0, 1, 1, 1,
-									1, 1, 1, 1, 1, 1, 1, 1, 0, 0,
-									0, 1, 0, 0, 0, 1, 1, 1, 1, 1,
-									1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-									1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-									1, 0, 0, 0, 0, 0, 0, 1, 1, 1,
-									1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-									1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-									1, 1, 1, 0, 0, 0, 0, 0 };
 
 
-enum test_status validate_message(struct Message* msg)
+
+enum State get_state(void)
+{
+	return (enum State)session.state;
+}
+
+
+enum Reason get_reason(void)
+{
+	return (enum Reason)session.reason;
+}
+
+
+// the core of SPLPinline.h behind a call
+enum test_status validate_session_message(struct Session* session, struct Message* msg)
+{
+	return splp_validate_session_inline(session, msg);
+}
+
+
+enum test_status validate_session_message_n(struct Session* session, enum Direction direction, const char* text, size_t length)
+{
+	return splp_validate_session_inline_n(session, direction, text, length);
+}
+
+
+#ifdef SPLP_LITERAL_SIMD
+#define SPLP_LITERAL_STATES ((1u << INIT) | (1u << CONNECTING) | (1u << DISCONNECTING))
+
+// four messages of four different sessions, all in INIT, CONNECTING or
+// DISCONNECTING and sent in the direction of their literal: the texts
+// are compared against their literals in one pass and the compares
+// folded into one mask, a single branch for the four. Returns false
+// without touching a session unless all four are valid
+static bool validate_literal_group(struct Session* const* sessions, struct Message* const* messages, enum test_status* results)
 {
-	switch (state)
+	const __m128i index = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	__m128i equal = _mm_set1_epi8(-1);
+	size_t i;
+
+	if (sessions[0] == sessions[1] || sessions[0] == sessions[2] || sessions[0] == sessions[3] ||
+		sessions[1] == sessions[2] || sessions[1] == sessions[3] || sessions[2] == sessions[3])
+	{
+		return false;
+	}
+	for (i = 0; i < 4; i++)
 	{
-	case INIT:
+		const struct splp_literal* literal;
+		const char* text = messages[i]->text_message;
+		__m128i message;
 
-		if (strcmp(msg->text_message, CONNECT) != 0)
+		if (!((SPLP_LITERAL_STATES >> sessions[i]->state) & 1))
 		{
-			return MESSAGE_INVALID;
+			return false;
 		}
-		if (msg->direction != A_TO_B)
+		literal = &splp_literals[sessions[i]->state];
+		if (messages[i]->direction != literal->direction || ((uintptr_t)text & 4095) > 4096 - 16)
 		{
-			return MESSAGE_INVALID;
+			return false;
 		}
-		state = CONNECTING;
-		return MESSAGE_VALID;
-	case CONNECTING:
-		//A<-B CONNECT_OK 3
-		//return MESSAGE_INVALID;
+#if defined(__GNUC__)
+		// the load runs past a short message array, see splp_equals_literal()
+		__asm__("" : "+r"(text));
+#endif
+		message = _mm_loadu_si128((const __m128i*)text);
+		// the bytes after the terminator of the literal always compare equal
+		equal = _mm_and_si128(equal, _mm_or_si128(
+			_mm_cmpeq_epi8(message, _mm_loadu_si128((const __m128i*)literal->text)),
+			_mm_cmpgt_epi8(index, _mm_set1_epi8((char)literal->length))));
+	}
+	if (_mm_movemask_epi8(equal) != 0xffff)
+	{
+		return false;
+	}
 
-		if (strcmp(msg->text_message, CONNECT_OK) != 0)
-		{
-			state = INIT;
-			return MESSAGE_INVALID;
-		}
-		
-		if (msg->direction != B_TO_A)
-		{
-			state = INIT;
-			return MESSAGE_INVALID;
-		}
-		state = CONNECTED;
-		return MESSAGE_VALID;
-		break;
-	case CONNECTED:
-		//A->B GET_VER 4
-		//A->B GET_DATA 5
-		//A->B GET_FILE 5
-		//A->B GET_COMMAND 5
-		//A->B GET_B64 6
-		//A->B DISCONNECTS 7
-
-		if (msg->direction != A_TO_B)
-		{
-			state = INIT;
-			return MESSAGE_INVALID;
-		}
-		
-		if (strcmp(msg->text_message, GET_DATA) == 0 || strcmp(msg->text_message, GET_FILE) == 0 || strcmp(msg->text_message, GET_COMMAND) == 0)
-		{
-			state = WAITING_DATA;
-			return MESSAGE_VALID;
-		}
-		if (strcmp(msg->text_message, DISCONNECT) == 0)
-		{
-			state = DISCONNECTING;
-			return MESSAGE_VALID;
-		}
-		if (strcmp(msg->text_message, GET_B64) == 0)
-		{
-			state = WAITING_B64_DATA;
-			return MESSAGE_VALID;
-		}
-		if (strcmp(msg->text_message, GET_VER) == 0)
-		{
-			state = WAITING_VER;
-			return MESSAGE_VALID;
-		}
-		
-		return MESSAGE_INVALID;
-		
-		break;
-	case WAITING_VER:
-		//A<-B VERSION
-		//return MESSAGE_INVALID;
-
-		if (msg->direction != B_TO_A)
-		{
-			state = INIT;
-			return MESSAGE_INVALID;
-		}
+	for (i = 0; i < 4; i++)
+	{
+		enum State from = (enum State)sessions[i]->state;
 
-		if (strncmp(msg->text_message, VERSION, 7) == 0)
-		{
-			if (msg->text_message[7] != ' ') {
-				state = INIT;
-				return MESSAGE_INVALID;
-			}
-			for (size_t i = 8; msg->text_message[i] != '\0'; i++)
-			{
-				if (!(msg->text_message[i] >= 48 && msg->text_message[i] < 58) || msg->text_message[i] == 32)
-				{
-					state = INIT;
-					return MESSAGE_INVALID;
-				}
-			}
+		SPLP_PROBE_ENTRY(sessions[i]->state, messages[i]->direction, messages[i]->text_message);
+		sessions[i]->state = (unsigned char)splp_literals[from].next;
+		results[i] = MESSAGE_VALID;
+		SPLP_PROBE_TRANSITION(from, sessions[i]->state, MESSAGE_VALID);
+	}
+	return true;
+}
+#endif
 
-			state = CONNECTED;
-			return MESSAGE_VALID;
-		}
-		else {
-			state = INIT;
-			return MESSAGE_INVALID;
-		}
-		break;
-	case WAITING_DATA:
-		//A<-B CMD data CMD
 
-		if (msg->direction != B_TO_A)
+// runs of valid control messages of different sessions go four at a
+// time through validate_literal_group(); any other message, a reject
+// included, is validated alone by the core
+void validate_session_batch(struct Session* const* sessions, struct Message* const* messages, enum test_status* results, size_t count)
+{
+	size_t i = 0;
+
+#ifdef SPLP_LITERAL_SIMD
+	while (i + 4 <= count)
+	{
+		if (validate_literal_group(sessions + i, messages + i, results + i))
 		{
-			state = INIT;
-			return MESSAGE_INVALID;
+			i += 4;
+			continue;
 		}
-		if (strncmp(msg->text_message, GET_DATA, 8) == 0)
-		{
-			if (msg->text_message[8] != ' ') {
-				state = INIT;
-				return MESSAGE_INVALID;
-			}
-			char* pointer = msg->text_message + 9;
-			for (; *pointer != ' ' && *pointer != '\0';)
-			{
-				if (!*(table + *pointer))
-				{
-					state = INIT;
-					return MESSAGE_INVALID;
-				}
-				pointer++;
-			}
+		results[i] = splp_validate_session_inline(sessions[i], messages[i]);
+		i++;
+	}
+#endif
+	for (; i < count; i++)
+	{
+		results[i] = splp_validate_session_inline(sessions[i], messages[i]);
+	}
+}
 
-			if (*pointer == '\0' || strcmp(pointer + 1, GET_DATA)) {
-				state = INIT;
-				return MESSAGE_INVALID;
-			}
-			state = CONNECTED;
-			return MESSAGE_VALID;
-		}
-		if (strncmp(msg->text_message, GET_FILE, 8) == 0)
-		{
-			if (msg->text_message[8] != ' ') {
-				state = INIT;
-				return MESSAGE_INVALID;
-			}
-			char* pointer = msg->text_message + 9;
-			for (; *pointer != ' ' && *pointer != '\0';)
-			{
-				if (!*(table + *pointer))
-				{
-					state = INIT;
-					return MESSAGE_INVALID;
-				}
-				pointer++;
-			}
 
-			if (*pointer == '\0' || strcmp(pointer + 1, GET_FILE)) {
-				state = INIT;
-				return MESSAGE_INVALID;
-			}
-			state = CONNECTED;
-			return MESSAGE_VALID;
+// offset of the payload of a server response in WAITING_DATA or
+// WAITING_B64_DATA which passed the checks before the payload scan,
+// 0 for any other message
+static size_t payload_start(struct Session* session, struct Message* msg)
+{
+	const char* text = msg->text_message;
+	size_t start;
 
-		}
-		if (strncmp(msg->text_message, GET_COMMAND, 11) == 0)
-		{
-			if (msg->text_message[11] != ' ') {
-				state = INIT;
-				return MESSAGE_INVALID;
-			}
+	if (msg->direction != B_TO_A)
+	{
+		return 0;
+	}
+	start = splp_payload_start((enum State)session->state, text, NULL);
+	if (session->state == WAITING_B64_DATA && start != 0 && (text[5] == '\0' || text[6] == '\0'))
+	{
+		return 0;
+	}
+	return start;
+}
 
-			char* pointer = msg->text_message + 12;
-			for (; *pointer != ' ' && *pointer != '\0';)
-			{
-				if (!*(table + *pointer))
-				{
-					state = INIT;
-					return MESSAGE_INVALID;
-				}
-				pointer++;
-			}
 
-			if (*pointer == '\0' || strcmp(pointer + 1, GET_COMMAND)) {
-				state = INIT;
-				return MESSAGE_INVALID;
-			}
-			state = CONNECTED;
-			return MESSAGE_VALID;
+// the payload scans of the core in slices; the session is left alone
+// until the scan is complete, so a suspended message is invisible
+enum test_status validate_session_slice(struct Session* session, struct Message* msg, struct Scan* scan, size_t budget, int* done)
+{
+	const char* text = msg->text_message;
+	const char* pointer;
+	const char* stop;
+	enum State from = (enum State)session->state;
+	enum test_status result;
+
+	*done = 1;
+	if (scan->position == 0)
+	{
+		scan->position = payload_start(session, msg);
+		if (scan->position == 0)
+		{
+			return validate_session_message(session, msg);
 		}
+		SPLP_PROBE_ENTRY(session->state, msg->direction, msg->text_message);
+		SPLP_PROBE_SCAN_START(session->state, text + scan->position);
+	}
 
-		break;
-	case WAITING_B64_DATA:
-		//A<-B B64 
+	// every slice makes progress; a budget past the end of the address
+	// space is no limit
+	pointer = text + scan->position;
+	budget = budget ? budget : 1;
+	stop = budget < UINTPTR_MAX - (uintptr_t)pointer ? pointer + budget : NULL;
 
-		if (msg->direction != B_TO_A)
-		{
-			state = INIT;
-			return MESSAGE_INVALID;
-		}
-		if (strncmp(msg->text_message, B64, 4) != 0)
+	if (session->state == WAITING_DATA)
+	{
+		//A<-B CMD data CMD
+		size_t commandLength;
+		const char* command = splp_data_command(text, NULL, &commandLength);
+
+		pointer = splp_scan_data(pointer, NULL, stop);
+		if (pointer == stop)
 		{
-			state = INIT;
-			return MESSAGE_INVALID;
-		}
-		if (msg->text_message[4] != ' ') {
-			state = INIT;
+			scan->position = pointer - text;
+			*done = 0;
 			return MESSAGE_INVALID;
 		}
-		char* initialPointer = msg->text_message + 5;
-		char* pointer = msg->text_message + 5;
-		for (; *(pointer + 2) != '\0';)
-		{
-			if (!*(tableBase64 + *pointer))
-			{
-				state = INIT;
-				return MESSAGE_INVALID;
-			}
-			pointer++;
-		}
-
-		if (!*(tableBase64 + *pointer))
+		SPLP_PROBE_SCAN_END(session->state, pointer - (text + commandLength + 1));
+		result = splp_data_suffix(session, pointer, NULL, command, commandLength);
+	}
+	else
+	{
+		//A<-B B64: data
+		pointer = splp_scan_b64(pointer, NULL, stop);
+		if (splp_more(pointer + 2, NULL))
 		{
-			if (!(*pointer == '=' && *(pointer + 1) == 61))
+			if (pointer == stop)
 			{
-				state = INIT;
+				scan->position = pointer - text;
+				*done = 0;
 				return MESSAGE_INVALID;
 			}
+			result = splp_reject(session, REASON_CHARACTER);
 		}
-		else if (!*(tableBase64WithEquals + *(pointer + 1)))
-		{
-			state = INIT;
-			return MESSAGE_INVALID;
-		}
-		if ((pointer + 2 - initialPointer) % 4 != 0)
+		else
 		{
-			state = INIT;
-			return MESSAGE_INVALID;
+			SPLP_PROBE_SCAN_END(session->state, pointer - (text + 5));
+			result = splp_b64_tail(session, text + 5, pointer);
 		}
-		state = CONNECTED;
-		return MESSAGE_VALID;
-		break;
-	case DISCONNECTING:
-		//A<-B DISCONNECT_OK 1
-		//A<-B CONNECT_OK 3
+	}
 
-		if (strcmp(msg->text_message, DISCONNECT_OK) != 0)
-		{
-			state = INIT;
-			return MESSAGE_INVALID;
-		}
-		if (msg->direction != B_TO_A)
-		{
-			state = INIT;
-			return MESSAGE_INVALID;
-		}
-		state = INIT;
+	SPLP_PROBE_TRANSITION(from, session->state, result);
+	return result;
+}
+
+
+enum test_status validate_message(struct Message* msg)
+{
+	return validate_session_message(&session, msg);
+}
+
+
+/* FUNCTION:  validate_message_fail_open
+ *
+ * PURPOSE:
+ *    Used instead of validate_message() while the validator is
+ *    overloaded. Responses in WAITING_DATA and WAITING_B64_DATA are
+ *    accepted after the direction and keyword checks, without the
+ *    payload scan. All other states are validated as usual.
+ */
+enum test_status validate_message_fail_open(struct Message* msg)
+{
+	return validate_session_message_fail_open(&session, msg);
+}
+
+
+enum test_status validate_session_message_fail_open(struct Session* session, struct Message* msg)
+{
+	if ((session->state == WAITING_DATA || session->state == WAITING_B64_DATA) && msg->direction == B_TO_A &&
+		splp_payload_start((enum State)session->state, msg->text_message, NULL) != 0)
+	{
+		session->state = CONNECTED;
 		return MESSAGE_VALID;
-		break;
-	default:
-		break;
 	}
 
-	return MESSAGE_VALID;
+	return validate_session_message(session, msg);
+}
+
+
+void reset_state(void)
+{
+	session.state = INIT;
+}
+
+
+void set_state(enum State newState)
+{
+	session.state = (unsigned char)newState;
 }
@@ -4,6 +4,14 @@
  * This file contains definitions of the data structures and forward
  * declaration of handle_message() function
  */
+#ifndef SPLPV1_H
+#define SPLPV1_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 
 
@@ -21,6 +29,29 @@ enum Direction
 };
 
 
+enum State
+{
+	INIT,
+	CONNECTING,
+	CONNECTED,
+	WAITING_VER,
+	WAITING_DATA,
+	WAITING_B64_DATA,
+	DISCONNECTING
+};
+
+
+enum Reason /* why the last message was rejected */
+{
+	REASON_NONE,
+	REASON_DIRECTION,   /* message sent in the wrong direction   */
+	REASON_UNEXPECTED,  /* message not allowed in current state  */
+	REASON_FORMAT,      /* malformed prefix, separator or suffix */
+	REASON_CHARACTER,   /* character outside of the allowed set  */
+	REASON_LENGTH       /* payload has wrong length              */
+};
+
+
 struct Message /* message */
 {
 	enum Direction	direction;        
@@ -28,4 +59,60 @@ struct Message /* message */
 };
 
 
+struct Session /* validator state of one connection */
+{
+	unsigned char	state;            /* enum State */
+	unsigned char	reason;           /* enum Reason of the last MESSAGE_INVALID */
+};
+
+
 extern enum test_status validate_message( struct Message* pMessage ); 
+
+/* Same as validate_message() for a caller-owned session, which must
+ * start as { INIT, REASON_NONE }. validate_message() uses a built-in one */
+extern enum test_status validate_session_message( struct Session* pSession, struct Message* pMessage );
+
+/* Same as validate_session_message() for length bytes of text, which
+ * needn't be NUL terminated; nothing past them is read. A NUL byte
+ * among them is a character no message allows */
+extern enum test_status validate_session_message_n( struct Session* pSession, enum Direction direction,
+	const char* pText, size_t length );
+
+struct Scan /* progress of a message validated in slices */
+{
+	size_t			position;         /* next byte of the payload, 0 before the first slice */
+};
+
+/* Same as validate_session_message() in slices of at most budget (>= 1)
+ * payload bytes, for scanning long server responses between other work.
+ * *done is 0 while the payload isn't scanned completely; the session
+ * changes only in the last slice. scan must start as { 0 }; messages
+ * without a payload are validated in the first slice */
+extern enum test_status validate_session_slice( struct Session* pSession, struct Message* pMessage,
+	struct Scan* pScan, size_t budget, int* pDone );
+
+/* validate_session_message() of count messages, messages[i] in
+ * sessions[i], in order; a session may appear more than once. Runs of
+ * four control messages of INIT, CONNECTING and DISCONNECTING in four
+ * different sessions, most of a capture by count, are compared against
+ * their literals together on SSE2 targets */
+extern void validate_session_batch( struct Session* const* pSessions, struct Message* const* pMessages,
+	enum test_status* pResults, size_t count );
+
+extern enum State get_state( void );	/* state the next message is validated in  */
+extern enum Reason get_reason( void );	/* reason of the last MESSAGE_INVALID      */
+
+/* Overload support: validation which skips payload scans of server
+ * responses, and dropping the session back to INIT */
+extern enum test_status validate_message_fail_open( struct Message* pMessage );
+extern enum test_status validate_session_message_fail_open( struct Session* pSession, struct Message* pMessage );
+extern void reset_state( void );
+
+/* Benchmark support: validate the next message in the given state */
+extern void set_state( enum State newState );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPLPV1_H */
@@ -0,0 +1,129 @@
+/*
+ * SPLPv1.hpp
+ * The file is part of practical task for System programming course.
+ * This file contains the C++ interface of the SPLPv1 validator on top of
+ * validate_session_message(): splp::Session owns the state of one
+ * connection, splp::Validator validates std::string_view messages and
+ * std::span batches of them (C++20) in a session.
+ *
+ *     splp::Validator validator;
+ *     splp::Session session;
+ *     if (validator.validate(session, A_TO_B, packet) == MESSAGE_INVALID)
+ *         drop(session.reason());
+ *
+ * A view is validated in place by validate_session_message_n(), which
+ * reads its bytes and nothing past them; no call copies or allocates.
+ * In a view a NUL byte is a character no message allows, NUL terminated
+ * text ends at its first NUL byte as in C. A session is movable, not
+ * copyable: a copy would be a second connection in the same state.
+ */
+#ifndef SPLPV1_HPP
+#define SPLPV1_HPP
+
+#include "splpv1.h"
+#include <cstddef>
+#include <string_view>
+#if __cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#include <span>
+#define SPLP_HAS_SPAN
+#endif
+
+namespace splp
+{
+
+using Direction = ::Direction;
+using State = ::State;
+using Reason = ::Reason;
+using Verdict = ::test_status;
+
+
+// a message of a batch; text needn't be NUL terminated
+struct Message
+{
+	Direction			direction;
+	std::string_view	text;
+};
+
+
+class Session
+{
+public:
+	Session() noexcept : session_{ INIT, REASON_NONE } {}
+
+	// the moved-from session starts over in INIT
+	Session(Session&& other) noexcept : session_(other.session_) { other.reset(); }
+	Session& operator=(Session&& other) noexcept
+	{
+		if (this != &other)
+		{
+			session_ = other.session_;
+			other.reset();
+		}
+		return *this;
+	}
+	Session(const Session&) = delete;
+	Session& operator=(const Session&) = delete;
+
+	State state() const noexcept { return static_cast<State>(session_.state); }
+	Reason reason() const noexcept { return static_cast<Reason>(session_.reason); }	// of the last MESSAGE_INVALID
+	void reset() noexcept { session_ = ::Session{ INIT, REASON_NONE }; }
+
+	::Session* get() noexcept { return &session_; }
+
+private:
+	::Session session_;
+};
+
+
+class Validator
+{
+public:
+	// NUL terminated text
+	Verdict validate(Session& session, Direction direction, const char* text) noexcept
+	{
+		::Message msg = { direction, const_cast<char*>(text) };
+		return validate_session_message(session.get(), &msg);
+	}
+
+	Verdict validate(Session& session, Direction direction, std::string_view text) noexcept
+	{
+		return validate_session_message_n(session.get(), direction, text.data(), text.size());
+	}
+
+	Verdict validate(Session& session, const Message& message) noexcept
+	{
+		return validate(session, message.direction, message.text);
+	}
+
+#ifdef SPLP_HAS_SPAN
+	// messages of one session in order; returns the number validated,
+	// which is less than messages.size() if results is shorter
+	std::size_t validate(Session& session, std::span<const Message> messages, std::span<Verdict> results) noexcept
+	{
+		std::size_t count = messages.size() < results.size() ? messages.size() : results.size();
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			results[i] = validate(session, messages[i]);
+		}
+		return count;
+	}
+
+	// messages[i] in *sessions[i], in order; a session may appear more than once
+	std::size_t validate(std::span<Session* const> sessions, std::span<const Message> messages, std::span<Verdict> results) noexcept
+	{
+		std::size_t count = messages.size() < results.size() ? messages.size() : results.size();
+
+		count = sessions.size() < count ? sessions.size() : count;
+		for (std::size_t i = 0; i < count; i++)
+		{
+			results[i] = validate(*sessions[i], messages[i]);
+		}
+		return count;
+	}
+#endif
+};
+
+} // namespace splp
+
+#endif /* SPLPV1_HPP */
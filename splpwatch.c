@@ -0,0 +1,128 @@
+/*
+* SPLPWATCH.c
+* The file is part of practical task for System programming course.
+* This file contains the slow message watchdog.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include "splpwatch.h"
+#include "splplog.h"
+
+
+
+
+static unsigned int SplpWatchdogHash(
+    const char* text )
+{
+    unsigned int hash = 2166136261u;
+    while ( *text )
+    {
+        hash ^= (unsigned char) *text++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+
+
+
+void SplpWatchdogRecord(
+    PSPLP_WATCHDOG pWatchdog,
+    unsigned long long elapsed,
+    unsigned int msgIdx,
+    const struct Message* pMsg,
+    unsigned int length,
+    enum State state,
+    enum test_status result )
+{
+    PSPLP_SLOW_MESSAGE pSlot;
+    unsigned int i;
+
+    pWatchdog->overThreshold++;
+
+    if ( pWatchdog->count < SPLP_WATCHDOG_SLOTS )
+    {
+        pSlot = &pWatchdog->slowest[ pWatchdog->count++ ];
+    }
+    else if ( elapsed > pWatchdog->slowest[ pWatchdog->minIdx ].elapsed )
+    {
+        pSlot = &pWatchdog->slowest[ pWatchdog->minIdx ];
+    }
+    else
+    {
+        return;
+    }
+
+    pSlot->elapsed = elapsed;
+    pSlot->msgIdx = msgIdx;
+    pSlot->length = length;
+    pSlot->hash = SplpWatchdogHash( pMsg->text_message );
+    pSlot->state = (unsigned char) state;
+    pSlot->command = (unsigned char) SplpLogClassify( pMsg->text_message, length );
+    pSlot->valid = result == MESSAGE_VALID;
+
+    for ( i = 0, pWatchdog->minIdx = 0; i < pWatchdog->count; i++ )
+    {
+        if ( pWatchdog->slowest[ i ].elapsed < pWatchdog->slowest[ pWatchdog->minIdx ].elapsed )
+            pWatchdog->minIdx = i;
+    }
+}
+
+
+
+
+static int SplpWatchdogCompare(
+    const void* pLeft,
+    const void* pRight )
+{
+    unsigned long long left = ( (const SPLP_SLOW_MESSAGE*) pLeft )->elapsed;
+    unsigned long long right = ( (const SPLP_SLOW_MESSAGE*) pRight )->elapsed;
+    return left < right ? 1 : left > right ? -1 : 0;
+}
+
+
+
+
+void SplpWatchdogSort(
+    PSPLP_WATCHDOG pWatchdog )
+{
+    qsort( pWatchdog->slowest, pWatchdog->count, sizeof( SPLP_SLOW_MESSAGE ), SplpWatchdogCompare );
+    pWatchdog->minIdx = pWatchdog->count ? pWatchdog->count - 1 : 0;
+}
+
+
+
+
+void SplpWatchdogPrint(
+    PSPLP_WATCHDOG pWatchdog )
+{
+    unsigned int i;
+
+    SplpWatchdogSort( pWatchdog );
+
+    printf(
+        " Slow messages (> %llu ticks):\n"
+        "\tOver threshold:   \t%14llu\n",
+        pWatchdog->threshold,
+        pWatchdog->overThreshold );
+
+    if ( pWatchdog->count )
+    {
+        printf( "\t%10s %8s %8s %-18s %-14s %8s %s\n",
+            "Ticks", "Msg #", "Length", "State", "Command", "Hash", "Verdict" );
+    }
+
+    for ( i = 0; i < pWatchdog->count; i++ )
+    {
+        PSPLP_SLOW_MESSAGE pSlot = &pWatchdog->slowest[ i ];
+        printf( "\t%10llu %8u %8u %-18s %-14s %08x %s\n",
+            pSlot->elapsed,
+            pSlot->msgIdx,
+            pSlot->length,
+            SplpLogStateName( pSlot->state ),
+            SplpLogCommandName( pSlot->command ),
+            pSlot->hash,
+            pSlot->valid ? "VALID" : "INVALID" );
+    }
+    printf( "\n" );
+}
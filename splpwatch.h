@@ -0,0 +1,99 @@
+/*
+* SPLPWATCH.h
+* The file is part of practical task for System programming course.
+* This file contains declarations of the slow message watchdog. It
+* keeps the N slowest messages which took longer than a threshold.
+*/
+#ifndef SPLPWATCH_H
+#define SPLPWATCH_H
+
+#include "splpv1.h"
+#include "splptest.h"
+
+
+
+#define SPLP_WATCHDOG_SLOTS       16
+
+
+
+
+/* SPLP_SLOW_MESSAGE
+* A message which took longer than the watchdog threshold.
+*/
+typedef struct _SPLP_SLOW_MESSAGE
+{
+    unsigned long long elapsed;     /* TSC ticks spent in validate_message( ) */
+    unsigned int       msgIdx;      /* index in the test file */
+    unsigned int       length;      /* message length in bytes */
+    unsigned int       hash;        /* FNV-1a of the message text */
+    unsigned char      state;       /* state the message was validated in */
+    unsigned char      command;     /* SPLP_LOG_COMMAND */
+    unsigned char      valid;       /* verdict */
+
+}SPLP_SLOW_MESSAGE, *PSPLP_SLOW_MESSAGE;
+
+
+
+
+/* SPLP_WATCHDOG
+* Slowest-N table. Entries are unordered, minIdx points to the fastest
+* one which is replaced first.
+*/
+typedef struct _SPLP_WATCHDOG
+{
+    unsigned long long threshold;   /* TSC ticks, 0 if the watchdog is off */
+    unsigned long long overThreshold; /* messages slower than threshold */
+    unsigned int       count;
+    unsigned int       minIdx;
+    SPLP_SLOW_MESSAGE  slowest[ SPLP_WATCHDOG_SLOTS ];
+
+}SPLP_WATCHDOG, *PSPLP_WATCHDOG;
+
+
+
+
+void SplpWatchdogRecord(
+    PSPLP_WATCHDOG pWatchdog,
+    unsigned long long elapsed,
+    unsigned int msgIdx,
+    const struct Message* pMsg,
+    unsigned int length,
+    enum State state,
+    enum test_status result );
+
+
+
+
+/* SplpWatchdogCheck
+* Called for every message, only messages above the threshold leave
+* the inline part.
+*/
+static __inline void SplpWatchdogCheck(
+    PSPLP_WATCHDOG pWatchdog,
+    unsigned long long elapsed,
+    unsigned int msgIdx,
+    const struct Message* pMsg,
+    unsigned int length,
+    enum State state,
+    enum test_status result )
+{
+    if ( elapsed > pWatchdog->threshold )
+        SplpWatchdogRecord( pWatchdog, elapsed, msgIdx, pMsg, length, state, result );
+}
+
+
+
+
+/* SplpWatchdogSort
+* Orders the table from the slowest message down.
+*/
+void SplpWatchdogSort(
+    PSPLP_WATCHDOG pWatchdog );
+
+
+
+
+void SplpWatchdogPrint(
+    PSPLP_WATCHDOG pWatchdog );
+
+#endif /* SPLPWATCH_H */